@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <vector>
+#include "audio_processor.h"
+#include "fingerprinter_configuration.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+static void RunAudioProcessor(benchmark::State &state, const std::vector<int16_t> &data, int sample_rate, int num_channels)
+{
+	const size_t chunk_size = 4096 * num_channels;
+	NullAudioConsumer consumer;
+	AudioProcessor processor(DEFAULT_SAMPLE_RATE, &consumer);
+	for (auto _ : state) {
+		processor.Reset(sample_rate, num_channels);
+		for (size_t i = 0; i < data.size(); i += chunk_size) {
+			processor.Consume(data.data() + i, std::min(chunk_size, data.size() - i));
+		}
+		processor.Flush();
+	}
+	benchmark::DoNotOptimize(consumer.num_samples());
+	SetItemsProcessed(state, data.size() / num_channels);
+}
+
+static void BM_AudioProcessor(benchmark::State &state)
+{
+	const int sample_rate = state.range(0);
+	const int num_channels = state.range(1);
+	const auto data = GenerateAudio(sample_rate, num_channels, 30.0);
+	RunAudioProcessor(state, data, sample_rate, num_channels);
+}
+
+BENCHMARK(BM_AudioProcessor)
+	->ArgNames({"rate", "channels"})
+	->Args({11025, 1})
+	->Args({8000, 1})
+	->Args({22050, 1})
+	->Args({44100, 1})
+	->Args({44100, 2})
+	->Args({48000, 2})
+	->Args({48000, 6})
+	->Args({48000, 8})
+	->Unit(benchmark::kMicrosecond);
+
+// Float input, as decoded by most codecs, either interleaved or planar.
+static void BM_AudioProcessorFloat(benchmark::State &state)
+{
+	const int sample_rate = state.range(0);
+	const int num_channels = state.range(1);
+	const bool planar = state.range(2);
+	const auto data = GenerateAudio(sample_rate, num_channels, 30.0);
+	const size_t length = data.size() / num_channels;
+	std::vector<float> interleaved(data.size());
+	std::vector<std::vector<float>> planes(num_channels, std::vector<float>(length));
+	for (size_t i = 0; i < data.size(); i++) {
+		interleaved[i] = data[i] / 32768.0f;
+		planes[i % num_channels][i / num_channels] = data[i] / 32768.0f;
+	}
+
+	const size_t chunk_size = 4096;
+	std::vector<const float *> chunk(num_channels);
+	NullAudioConsumer consumer;
+	AudioProcessor processor(DEFAULT_SAMPLE_RATE, &consumer);
+	for (auto _ : state) {
+		processor.Reset(sample_rate, num_channels);
+		for (size_t i = 0; i < length; i += chunk_size) {
+			const size_t size = std::min(chunk_size, length - i);
+			if (planar) {
+				for (int ch = 0; ch < num_channels; ch++) {
+					chunk[ch] = planes[ch].data() + i;
+				}
+				processor.ConsumePlanarFloat(chunk.data(), size);
+			} else {
+				processor.ConsumeFloat(interleaved.data() + i * num_channels, size * num_channels);
+			}
+		}
+		processor.Flush();
+	}
+	benchmark::DoNotOptimize(consumer.num_samples());
+	SetItemsProcessed(state, length);
+}
+
+BENCHMARK(BM_AudioProcessorFloat)
+	->ArgNames({"rate", "channels", "planar"})
+	->Args({44100, 2, 0})
+	->Args({44100, 2, 1})
+	->Args({48000, 6, 0})
+	->Args({48000, 6, 1})
+	->Unit(benchmark::kMicrosecond);
+
+static void BM_AudioProcessorFile(benchmark::State &state)
+{
+	const auto &file = kBenchAudioFiles[state.range(0)];
+	std::vector<int16_t> data;
+	if (!LoadAudioFile(file, 30.0, data)) {
+		state.SkipWithError("could not load the audio file");
+		return;
+	}
+	state.SetLabel(file.name);
+	RunAudioProcessor(state, data, file.sample_rate, file.num_channels);
+}
+
+BENCHMARK(BM_AudioProcessorFile)->DenseRange(0, kNumBenchAudioFiles - 1)->Unit(benchmark::kMicrosecond);
+
+}; // namespace chromaprint
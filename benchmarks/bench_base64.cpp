@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "utils/base64.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+static void BM_Base64Encode(benchmark::State &state)
+{
+	const size_t size = state.range(0);
+	std::string input(size, '\0');
+	BenchRandom random(1);
+	for (auto &c : input) {
+		c = char(random.Next());
+	}
+
+	std::string output;
+	for (auto _ : state) {
+		Base64Encode(input, output);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetLabel("items are input bytes");
+	SetItemsProcessed(state, size);
+}
+
+BENCHMARK(BM_Base64Encode)->Arg(256)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64Decode(benchmark::State &state)
+{
+	const size_t size = state.range(0);
+	std::string input(size, '\0');
+	BenchRandom random(1);
+	for (auto &c : input) {
+		c = char(random.Next());
+	}
+	const auto encoded = Base64Encode(input);
+
+	std::string output;
+	for (auto _ : state) {
+		Base64Decode(encoded, output);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetLabel("items are output bytes");
+	SetItemsProcessed(state, size);
+}
+
+BENCHMARK(BM_Base64Decode)->Arg(256)->Arg(4096)->Arg(1 << 20);
+
+}; // namespace chromaprint
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "chroma.h"
+#include "chroma_filter.h"
+#include "chroma_normalizer.h"
+#include "fft.h"
+#include "fingerprinter_configuration.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+static const int kMinFreq = 28;
+static const int kMaxFreq = 3520;
+
+namespace {
+
+const std::vector<FFTFrame> &GetFFTFrames()
+{
+	static std::vector<FFTFrame> frames;
+	if (frames.empty()) {
+		const auto data = GenerateAudio(DEFAULT_SAMPLE_RATE, 1, 30.0);
+		FingerprinterConfigurationTest2 config;
+		FFTFrameCollector collector;
+		FFT fft(config.frame_size(), config.frame_overlap(), &collector);
+		fft.Consume(data.data(), data.size());
+		frames = collector.frames();
+	}
+	return frames;
+}
+
+const std::vector<FeatureVector> &GetChromaFeatures()
+{
+	static std::vector<FeatureVector> features;
+	if (features.empty()) {
+		FingerprinterConfigurationTest2 config;
+		FeatureVectorCollector collector;
+		Chroma chroma(kMinFreq, kMaxFreq, config.frame_size(), config.sample_rate(), &collector);
+		for (const auto &frame : GetFFTFrames()) {
+			chroma.Consume(frame);
+		}
+		features = collector.features();
+	}
+	return features;
+}
+
+};
+
+static void BM_Chroma(benchmark::State &state)
+{
+	const auto level = SimdLevel(state.range(0));
+	const auto &frames = GetFFTFrames();
+
+	FingerprinterConfigurationTest2 config;
+	NullFeatureVectorConsumer consumer;
+	SetSimdLevel(level);
+	Chroma chroma(kMinFreq, kMaxFreq, config.frame_size(), config.sample_rate(), &consumer);
+	SetSimdLevel(GetBestSimdLevel());
+
+	for (auto _ : state) {
+		for (const auto &frame : frames) {
+			chroma.Consume(frame);
+		}
+	}
+	state.SetLabel(std::string(GetSimdLevelName(level)) + ", items are frames");
+	SetItemsProcessed(state, frames.size());
+}
+
+BENCHMARK(BM_Chroma)->Apply(ApplySimdLevels)->Unit(benchmark::kMicrosecond);
+
+static void BM_ChromaInterpolated(benchmark::State &state)
+{
+	const auto &frames = GetFFTFrames();
+
+	FingerprinterConfigurationTest2 config;
+	NullFeatureVectorConsumer consumer;
+	Chroma chroma(kMinFreq, kMaxFreq, config.frame_size(), config.sample_rate(), &consumer);
+	chroma.set_interpolate(true);
+
+	for (auto _ : state) {
+		for (const auto &frame : frames) {
+			chroma.Consume(frame);
+		}
+	}
+	state.SetLabel("items are frames");
+	SetItemsProcessed(state, frames.size());
+}
+
+BENCHMARK(BM_ChromaInterpolated)->Unit(benchmark::kMicrosecond);
+
+static void BM_ChromaFilter(benchmark::State &state)
+{
+	auto features = GetChromaFeatures();
+
+	FingerprinterConfigurationTest2 config;
+	NullFeatureVectorConsumer consumer;
+	ChromaFilter filter(config.filter_coefficients(), config.num_filter_coefficients(), &consumer);
+
+	for (auto _ : state) {
+		filter.Reset();
+		for (auto &f : features) {
+			filter.Consume(f);
+		}
+	}
+	state.SetLabel("items are frames");
+	SetItemsProcessed(state, features.size());
+}
+
+BENCHMARK(BM_ChromaFilter)->Unit(benchmark::kMicrosecond);
+
+static void BM_ChromaNormalizer(benchmark::State &state)
+{
+	const auto &features = GetChromaFeatures();
+
+	NullFeatureVectorConsumer consumer;
+	ChromaNormalizer normalizer(&consumer);
+
+	FeatureVector tmp;
+	for (auto _ : state) {
+		for (const auto &f : features) {
+			tmp = f;
+			normalizer.Consume(tmp);
+		}
+	}
+	state.SetLabel("items are frames");
+	SetItemsProcessed(state, features.size());
+}
+
+BENCHMARK(BM_ChromaNormalizer)->Unit(benchmark::kMicrosecond);
+
+}; // namespace chromaprint
@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "fft.h"
+#include "fingerprinter_configuration.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+// Measures the configured FFT library, only one of them can be compiled in.
+static void BM_FFT(benchmark::State &state)
+{
+	const auto level = SimdLevel(state.range(0));
+	const size_t batch_size = state.range(1);
+	const auto data = GenerateAudio(DEFAULT_SAMPLE_RATE, 1, 30.0);
+
+	FingerprinterConfigurationTest2 config;
+	NullFFTFrameConsumer consumer;
+	SetSimdLevel(level);
+	FFT fft(config.frame_size(), config.frame_overlap(), &consumer, batch_size);
+	SetSimdLevel(GetBestSimdLevel());
+
+	for (auto _ : state) {
+		fft.Reset();
+		fft.Consume(data.data(), data.size());
+	}
+	const size_t num_frames = (data.size() - fft.overlap()) / fft.increment();
+	state.SetLabel(std::string(GetFFTLibName()) + "/" + GetSimdLevelName(level) + ", items are frames");
+	SetItemsProcessed(state, num_frames);
+	state.counters["samples_per_second"] = benchmark::Counter(data.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void ApplyFFTArgs(benchmark::internal::Benchmark *b)
+{
+	for (int i = int(SimdLevel::Generic); i <= int(SimdLevel::NEON); i++) {
+		if (IsSimdLevelSupported(SimdLevel(i))) {
+			for (int batch_size : { 1, 4, 8, 16 }) {
+				b->Args({ i, batch_size });
+			}
+		}
+	}
+	b->ArgNames({ "simd", "batch" });
+}
+
+BENCHMARK(BM_FFT)->Apply(ApplyFFTArgs)->Unit(benchmark::kMicrosecond);
+
+}; // namespace chromaprint
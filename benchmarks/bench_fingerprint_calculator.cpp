@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "chroma.h"
+#include "chroma_filter.h"
+#include "chroma_normalizer.h"
+#include "fft.h"
+#include "fingerprint_calculator.h"
+#include "fingerprinter_configuration.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+static void BM_FingerprintCalculator(benchmark::State &state)
+{
+	FingerprinterConfigurationTest2 config;
+
+	// normalized and filtered chroma features, as they come from the pipeline
+	FeatureVectorCollector collector;
+	{
+		const auto data = GenerateAudio(config.sample_rate(), 1, 30.0);
+		ChromaNormalizer normalizer(&collector);
+		ChromaFilter filter(config.filter_coefficients(), config.num_filter_coefficients(), &normalizer);
+		Chroma chroma(28, 3520, config.frame_size(), config.sample_rate(), &filter);
+		FFT fft(config.frame_size(), config.frame_overlap(), &chroma);
+		fft.Consume(data.data(), data.size());
+	}
+	auto features = collector.features();
+
+	FingerprintCalculator calculator(config.classifiers(), config.num_classifiers());
+	for (auto _ : state) {
+		calculator.Reset();
+		for (auto &f : features) {
+			calculator.Consume(f);
+		}
+		benchmark::DoNotOptimize(calculator.GetFingerprint().data());
+	}
+	state.SetLabel("items are frames");
+	SetItemsProcessed(state, features.size());
+	state.counters["fp_items"] = calculator.GetFingerprint().size();
+}
+
+BENCHMARK(BM_FingerprintCalculator)->Unit(benchmark::kMicrosecond);
+
+}; // namespace chromaprint
@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "fingerprint_compressor.h"
+#include "fingerprint_decompressor.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+static void BM_FingerprintCompress(benchmark::State &state)
+{
+	const size_t size = state.range(0);
+	std::vector<uint32_t> fp;
+	GenerateFingerprint(fp, size, 1);
+
+	FingerprintCompressor compressor;
+	std::string output;
+	for (auto _ : state) {
+		compressor.Compress(fp, 2, output);
+		benchmark::DoNotOptimize(output.data());
+	}
+	SetItemsProcessed(state, size);
+	state.counters["bytes_per_item"] = double(output.size()) / size;
+}
+
+BENCHMARK(BM_FingerprintCompress)->Arg(120)->Arg(1000)->Arg(100000);
+
+static void BM_FingerprintDecompress(benchmark::State &state)
+{
+	const size_t size = state.range(0);
+	std::vector<uint32_t> fp;
+	GenerateFingerprint(fp, size, 1);
+	const auto compressed = CompressFingerprint(fp, 2);
+
+	FingerprintDecompressor decompressor;
+	for (auto _ : state) {
+		if (!decompressor.Decompress(compressed)) {
+			state.SkipWithError("could not decompress the fingerprint");
+			break;
+		}
+		benchmark::DoNotOptimize(decompressor.GetOutput().data());
+	}
+	SetItemsProcessed(state, size);
+}
+
+BENCHMARK(BM_FingerprintDecompress)->Arg(120)->Arg(1000)->Arg(100000);
+
+}; // namespace chromaprint
@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <vector>
+#include "fingerprint_index.h"
+#include "fingerprint_searcher.h"
+
+namespace chromaprint {
+
+namespace {
+
+// Number of items AcoustID indexes for each fingerprint (ACOUSTID_QUERY_LENGTH).
+const size_t kIndexedFingerprintSize = 120;
+
+class RandomFingerprintGenerator
+{
+public:
+	RandomFingerprintGenerator(uint32_t seed) : m_state(seed * 2654435761u + 1) {}
+
+	void Generate(std::vector<uint32_t> &fp, size_t size) {
+		fp.resize(size);
+		for (size_t i = 0; i < size; i++) {
+			m_state ^= m_state << 13;
+			m_state ^= m_state >> 17;
+			m_state ^= m_state << 5;
+			fp[i] = m_state;
+		}
+	}
+
+private:
+	uint32_t m_state;
+};
+
+const FingerprintIndex &GetIndex(size_t num_docs)
+{
+	static std::map<size_t, std::unique_ptr<FingerprintIndex>> cache;
+	auto &index = cache[num_docs];
+	if (!index) {
+		index.reset(new FingerprintIndex());
+		RandomFingerprintGenerator generator(1);
+		std::vector<uint32_t> fp;
+		for (size_t i = 0; i < num_docs; i++) {
+			generator.Generate(fp, kIndexedFingerprintSize);
+			index->AddFingerprint(i, fp);
+		}
+		index->Build();
+	}
+	return *index;
+}
+
+};
+
+static void BM_FingerprintIndexBuild(benchmark::State &state)
+{
+	const size_t num_docs = state.range(0);
+	RandomFingerprintGenerator generator(1);
+	std::vector<uint32_t> fp;
+	for (auto _ : state) {
+		FingerprintIndex index;
+		for (size_t i = 0; i < num_docs; i++) {
+			generator.Generate(fp, kIndexedFingerprintSize);
+			index.AddFingerprint(i, fp);
+		}
+		index.Build();
+		benchmark::DoNotOptimize(index.num_postings());
+	}
+	state.SetItemsProcessed(state.iterations() * num_docs * kIndexedFingerprintSize);
+}
+
+BENCHMARK(BM_FingerprintIndexBuild)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_FingerprintSearcherSearch(benchmark::State &state)
+{
+	const size_t num_docs = state.range(0);
+	const auto &index = GetIndex(num_docs);
+
+	// queries are noisy copies of indexed fingerprints, so that the results are not empty
+	const size_t num_queries = 64;
+	std::vector<std::vector<uint32_t>> queries(num_queries);
+	for (size_t i = 0; i < num_queries; i++) {
+		size_t size;
+		const auto data = index.GetFingerprint((i * 7919) % num_docs, &size);
+		queries[i].assign(data, data + size);
+		for (size_t j = 0; j < size; j += 3) {
+			queries[i][j] ^= 1u << (j % 32);
+		}
+	}
+
+	FingerprintSearcher searcher(&index);
+	std::vector<FingerprintSearchResult> results;
+	size_t i = 0;
+	for (auto _ : state) {
+		searcher.Search(queries[i++ % num_queries], 10, results);
+		benchmark::DoNotOptimize(results.data());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_FingerprintSearcherSearch)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_FingerprintIndexOpen(benchmark::State &state)
+{
+	const size_t num_docs = state.range(0);
+	const char *file_name = "bench_fingerprint_index.idx";
+	if (!GetIndex(num_docs).Save(file_name)) {
+		state.SkipWithError("could not save the index");
+		return;
+	}
+	for (auto _ : state) {
+		FingerprintIndex index;
+		if (!index.Open(file_name)) {
+			state.SkipWithError("could not open the index");
+			break;
+		}
+		benchmark::DoNotOptimize(index.num_postings());
+	}
+	remove(file_name);
+}
+
+BENCHMARK(BM_FingerprintIndexOpen)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+}; // namespace chromaprint
@@ -0,0 +1,37 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "fingerprint_matcher.h"
+#include "fingerprinter_configuration.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+static void BM_FingerprintMatcher(benchmark::State &state)
+{
+	const size_t size = state.range(0);
+
+	// the second fingerprint is a noisy copy of the first one, shifted by a few seconds
+	std::vector<uint32_t> fp1, fp2;
+	GenerateFingerprint(fp1, size, 1);
+	const size_t shift = 40;
+	fp2.assign(fp1.begin() + shift, fp1.end());
+	BenchRandom random(2);
+	for (auto &x : fp2) {
+		x ^= 1u << (random.Next() & 31);
+	}
+
+	FingerprintMatcher matcher(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_TEST2));
+	for (auto _ : state) {
+		if (!matcher.Match(fp1, fp2)) {
+			state.SkipWithError("could not match the fingerprints");
+			break;
+		}
+		benchmark::DoNotOptimize(matcher.segments().data());
+	}
+	SetItemsProcessed(state, size);
+	state.counters["segments"] = matcher.segments().size();
+}
+
+BENCHMARK(BM_FingerprintMatcher)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+}; // namespace chromaprint
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <vector>
+#include <chromaprint.h>
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+// Whole pipeline through the public API, from raw audio to a raw fingerprint.
+static void RunFingerprinter(benchmark::State &state, const std::vector<int16_t> &data, int sample_rate, int num_channels)
+{
+	const size_t chunk_size = 4096 * num_channels;
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+	int size = 0;
+	for (auto _ : state) {
+		chromaprint_start(ctx, sample_rate, num_channels);
+		for (size_t i = 0; i < data.size(); i += chunk_size) {
+			chromaprint_feed(ctx, data.data() + i, std::min(chunk_size, data.size() - i));
+		}
+		chromaprint_finish(ctx);
+		chromaprint_get_raw_fingerprint_size(ctx, &size);
+	}
+	chromaprint_free(ctx);
+	SetItemsProcessed(state, data.size() / num_channels);
+	state.counters["fp_items"] = size;
+}
+
+static void BM_Fingerprinter(benchmark::State &state)
+{
+	const int sample_rate = state.range(0);
+	const int num_channels = state.range(1);
+	const auto data = GenerateAudio(sample_rate, num_channels, 30.0);
+	RunFingerprinter(state, data, sample_rate, num_channels);
+}
+
+BENCHMARK(BM_Fingerprinter)
+	->ArgNames({"rate", "channels"})
+	->Args({11025, 1})
+	->Args({44100, 2})
+	->Unit(benchmark::kMillisecond);
+
+static void BM_FingerprinterFile(benchmark::State &state)
+{
+	const auto &file = kBenchAudioFiles[state.range(0)];
+	std::vector<int16_t> data;
+	if (!LoadAudioFile(file, 30.0, data)) {
+		state.SkipWithError("could not load the audio file");
+		return;
+	}
+	state.SetLabel(file.name);
+	RunFingerprinter(state, data, file.sample_rate, file.num_channels);
+}
+
+BENCHMARK(BM_FingerprinterFile)->DenseRange(0, kNumBenchAudioFiles - 1)->Unit(benchmark::kMillisecond);
+
+// Complete buffer processed with chromaprint_process_parallel().
+static void BM_FingerprinterParallel(benchmark::State &state)
+{
+	const int sample_rate = 44100;
+	const int num_channels = 2;
+	const int num_threads = state.range(0);
+	const auto data = GenerateAudio(sample_rate, num_channels, 600.0);
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+	int size = 0;
+	for (auto _ : state) {
+		chromaprint_process_parallel(ctx, sample_rate, num_channels, data.data(), data.size(), num_threads);
+		chromaprint_get_raw_fingerprint_size(ctx, &size);
+	}
+	chromaprint_free(ctx);
+	SetItemsProcessed(state, data.size() / num_channels);
+	state.counters["fp_items"] = size;
+}
+
+BENCHMARK(BM_FingerprinterParallel)
+	->ArgName("threads")
+	->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+}; // namespace chromaprint
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "simd/simd.h"
+#include "bench_utils.h"
+
+namespace chromaprint {
+
+static const size_t kKernelSize = 4096;
+
+static void BM_SimdApplyWindow(benchmark::State &state)
+{
+	const auto &kernels = GetSimdKernels(SimdLevel(state.range(0)));
+	const auto input = GenerateAudio(11025, 1, 1.0);
+	std::vector<float> window(kKernelSize, 0.5f), output(kKernelSize);
+	for (auto _ : state) {
+		kernels.apply_window(input.data(), window.data(), output.data(), kKernelSize);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetLabel(GetSimdLevelName(kernels.level));
+	SetItemsProcessed(state, kKernelSize);
+}
+
+BENCHMARK(BM_SimdApplyWindow)->Apply(ApplySimdLevels);
+
+static void BM_SimdPowerSpectrum(benchmark::State &state)
+{
+	const auto &kernels = GetSimdKernels(SimdLevel(state.range(0)));
+	std::vector<float> input(kKernelSize * 2);
+	BenchRandom random(1);
+	for (auto &x : input) {
+		x = float(random.Next() % 65536) - 32768.0f;
+	}
+	std::vector<FeatureScalar> output(kKernelSize);
+	for (auto _ : state) {
+		kernels.power_spectrum_interleaved(input.data(), output.data(), kKernelSize);
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetLabel(GetSimdLevelName(kernels.level));
+	SetItemsProcessed(state, kKernelSize);
+}
+
+BENCHMARK(BM_SimdPowerSpectrum)->Apply(ApplySimdLevels);
+
+static void BM_SimdSum(benchmark::State &state)
+{
+	const auto &kernels = GetSimdKernels(SimdLevel(state.range(0)));
+	std::vector<FeatureScalar> input(kKernelSize);
+	BenchRandom random(1);
+	for (auto &x : input) {
+		x = FeatureScalar(random.Next() % 65536);
+	}
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(kernels.sum(input.data(), input.size()));
+	}
+	state.SetLabel(GetSimdLevelName(kernels.level));
+	SetItemsProcessed(state, kKernelSize);
+}
+
+BENCHMARK(BM_SimdSum)->Apply(ApplySimdLevels);
+
+static void BM_SimdHammingDistance(benchmark::State &state)
+{
+	const auto &kernels = GetSimdKernels(SimdLevel(state.range(0)));
+	std::vector<uint32_t> a, b, output(kKernelSize);
+	GenerateFingerprint(a, kKernelSize, 1);
+	GenerateFingerprint(b, kKernelSize, 2);
+	for (auto _ : state) {
+		kernels.hamming_distance(a.data(), b.data(), kKernelSize, output.data());
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetLabel(GetSimdLevelName(kernels.level));
+	SetItemsProcessed(state, kKernelSize);
+}
+
+BENCHMARK(BM_SimdHammingDistance)->Apply(ApplySimdLevels);
+
+}; // namespace chromaprint
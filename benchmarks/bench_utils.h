@@ -0,0 +1,230 @@
+#ifndef CHROMAPRINT_BENCHMARKS_BENCH_UTILS_H_
+#define CHROMAPRINT_BENCHMARKS_BENCH_UTILS_H_
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include "audio_consumer.h"
+#include "fft_frame_consumer.h"
+#include "feature_vector_consumer.h"
+#include "simd/simd.h"
+
+namespace chromaprint {
+
+// Data files from the test suite, all of them are 2 seconds long.
+struct BenchAudioFile
+{
+	const char *name;
+	int sample_rate;
+	int num_channels;
+};
+
+static const BenchAudioFile kBenchAudioFiles[] = {
+	{ "data/test_mono_8000.raw", 8000, 1 },
+	{ "data/test_mono_11025.raw", 11025, 1 },
+	{ "data/test_mono_44100.raw", 44100, 1 },
+	{ "data/test_stereo_44100.raw", 44100, 2 },
+};
+
+static const int kNumBenchAudioFiles = sizeof(kBenchAudioFiles) / sizeof(kBenchAudioFiles[0]);
+
+inline bool LoadAudioFile(const std::string &file_name, std::vector<int16_t> &data)
+{
+	std::string path = TESTS_DIR + file_name;
+	std::ifstream file(path.c_str(), std::ifstream::in | std::ifstream::binary);
+	if (!file) {
+		return false;
+	}
+	uint8_t buf[4096];
+	data.clear();
+	while (!file.eof()) {
+		file.read((char *) buf, 4096);
+		size_t nread = file.gcount();
+		for (size_t i = 0; i + 1 < nread; i += 2) {
+			data.push_back((int16_t) (((uint16_t) buf[i+1] << 8) | ((uint16_t) buf[i])));
+		}
+	}
+	return true;
+}
+
+//! Load a test file and repeat it until it's at least the given duration long.
+inline bool LoadAudioFile(const BenchAudioFile &file, double duration, std::vector<int16_t> &data)
+{
+	if (!LoadAudioFile(file.name, data) || data.empty()) {
+		return false;
+	}
+	const size_t min_size = size_t(file.sample_rate * duration) * file.num_channels;
+	data.reserve(min_size);
+	for (size_t i = 0; data.size() < min_size; i++) {
+		data.push_back(data[i]);
+	}
+	return true;
+}
+
+// Deterministic xorshift generator, so that all runs process the same data.
+class BenchRandom
+{
+public:
+	BenchRandom(uint32_t seed) : m_state(seed * 2654435761u + 1) {}
+
+	uint32_t Next() {
+		m_state ^= m_state << 13;
+		m_state ^= m_state >> 17;
+		m_state ^= m_state << 5;
+		return m_state;
+	}
+
+private:
+	uint32_t m_state;
+};
+
+//! Generate interleaved audio with a few changing tones and some noise.
+inline std::vector<int16_t> GenerateAudio(int sample_rate, int num_channels, double duration)
+{
+	const size_t num_frames = size_t(sample_rate * duration);
+	std::vector<int16_t> data(num_frames * num_channels);
+	BenchRandom random(1);
+	const double notes[] = { 220.0, 261.63, 329.63, 392.0, 440.0, 523.25, 659.26, 783.99 };
+	const size_t note_length = sample_rate / 4;
+	for (size_t i = 0; i < num_frames; i++) {
+		const size_t note = i / note_length;
+		const double t = double(i) / sample_rate;
+		double value = 0.0;
+		for (size_t j = 0; j < 3; j++) {
+			const double freq = notes[(note * 3 + j * 5) % 8];
+			value += 6000.0 * std::sin(2.0 * M_PI * freq * t);
+		}
+		for (int ch = 0; ch < num_channels; ch++) {
+			const double noise = int(random.Next() % 2001) - 1000;
+			data[i * num_channels + ch] = int16_t(value + noise);
+		}
+	}
+	return data;
+}
+
+//! Generate a fingerprint that changes only a few bits between items, like real ones do.
+inline void GenerateFingerprint(std::vector<uint32_t> &fp, size_t size, uint32_t seed)
+{
+	BenchRandom random(seed);
+	fp.resize(size);
+	uint32_t x = random.Next();
+	for (size_t i = 0; i < size; i++) {
+		const uint32_t r = random.Next();
+		x ^= 1u << (r & 31);
+		if (r & (1u << 5)) {
+			x ^= 1u << ((r >> 6) & 31);
+		}
+		if ((r >> 11) % 16 == 0) {
+			x ^= 1u << ((r >> 16) & 31);
+		}
+		fp[i] = x;
+	}
+}
+
+//! Get a name of the FFT library the library was compiled with.
+inline const char *GetFFTLibName()
+{
+#if defined(USE_AVFFT)
+	return "avfft";
+#elif defined(USE_FFTW3F)
+	return "fftw3f";
+#elif defined(USE_FFTW3)
+	return "fftw3";
+#elif defined(USE_VDSP)
+	return "vdsp";
+#elif defined(USE_KISSFFT)
+	return "kissfft";
+#elif defined(USE_BUILTIN_FFT)
+	return "builtin";
+#else
+	return "unknown";
+#endif
+}
+
+//! Register one benchmark run for each SIMD level supported by the CPU.
+inline void ApplySimdLevels(benchmark::internal::Benchmark *b)
+{
+	for (int i = int(SimdLevel::Generic); i <= int(SimdLevel::NEON); i++) {
+		if (IsSimdLevelSupported(SimdLevel(i))) {
+			b->Arg(i);
+		}
+	}
+	b->ArgName("simd");
+}
+
+//! Report the throughput and the time per item.
+//
+// Items are audio samples (per channel) for the audio stages, frames for the
+// frame based stages and fingerprint items or bytes for the rest.
+inline void SetItemsProcessed(benchmark::State &state, size_t items_per_iteration)
+{
+	state.SetItemsProcessed(state.iterations() * items_per_iteration);
+	state.counters["time_per_item"] = benchmark::Counter(items_per_iteration,
+		benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+class NullAudioConsumer : public AudioConsumer
+{
+public:
+	void Consume(const int16_t *input, int length) override {
+		benchmark::DoNotOptimize(input);
+		m_num_samples += length;
+	}
+
+	size_t num_samples() const { return m_num_samples; }
+
+private:
+	size_t m_num_samples = 0;
+};
+
+class FFTFrameCollector : public FFTFrameConsumer
+{
+public:
+	void Consume(const FFTFrame &frame) override {
+		m_frames.push_back(frame);
+	}
+
+	const std::vector<FFTFrame> &frames() const { return m_frames; }
+
+private:
+	std::vector<FFTFrame> m_frames;
+};
+
+class NullFFTFrameConsumer : public FFTFrameConsumer
+{
+public:
+	void Consume(const FFTFrame &frame) override {
+		benchmark::DoNotOptimize(frame.data());
+	}
+};
+
+class FeatureVectorCollector : public FeatureVectorConsumer
+{
+public:
+	void Consume(FeatureVector &features) override {
+		m_features.push_back(features);
+	}
+
+	const std::vector<FeatureVector> &features() const { return m_features; }
+
+private:
+	std::vector<FeatureVector> m_features;
+};
+
+class NullFeatureVectorConsumer : public FeatureVectorConsumer
+{
+public:
+	void Consume(FeatureVector &features) override {
+		benchmark::DoNotOptimize(features.data());
+	}
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -9,6 +9,7 @@
 #include <cassert>
 #include <vector>
 #include "debug.h"
+#include "utils/state_buffer.h"
 
 namespace chromaprint {
 
@@ -69,6 +70,21 @@ public:
 		m_buffer_end = std::copy(begin, end, m_buffer_end);
 	}
 
+	//! Save the input that is buffered for the next frame.
+	void SaveState(StateWriter &writer) const {
+		writer.WriteArray(m_buffer.data() + (m_buffer_begin - m_buffer.begin()), m_buffer_end - m_buffer_begin);
+	}
+
+	bool RestoreState(StateReader &reader) {
+		std::vector<T> buffer;
+		if (!reader.ReadArray(&buffer, m_size - 1)) {
+			return false;
+		}
+		Reset();
+		m_buffer_end = std::copy(buffer.begin(), buffer.end(), m_buffer_begin);
+		return true;
+	}
+
 private:
 	size_t m_size;
 	size_t m_increment;
@@ -9,25 +9,44 @@ extern "C" {
 }
 #include "debug.h"
 #include "audio_processor.h"
+#include "polyphase_resampler.h"
+#include "stats.h"
+#include "utils/state_buffer.h"
 
 namespace chromaprint {
 
 static const int kMinSampleRate = 1000;
 static const int kMaxBufferSize = 1024 * 32;
 
+// Maximum number of input samples copied after the buffered ones, when mono
+// input is resampled directly. It should be more than the filter length (349
+// taps for 192 kHz input), otherwise all of the input is buffered as before.
+static const size_t kMaxResampleOverlap = 1024;
+
 // Resampler configuration
 static const int kResampleFilterLength = 16;
 static const int kResamplePhaseShift = 8;
 static const int kResampleLinear = 0;
 static const double kResampleCutoff = 0.8;
 
+// Downmix weights for 5.1 and 7.1 streams in the WAVE channel order
+// (FL FR FC LFE BL BR [SL SR]), in units of 1 / (1 << kDownmixWeightBits).
+// The center and surround channels are attenuated by 3 dB relative to the
+// front channels, the LFE channel is dropped and the weights add up to one.
+static const int16_t kDownmixWeights51[6] = { 7951, 7951, 5622, 0, 5622, 5622 };
+static const int16_t kDownmixWeights71[8] = { 5919, 5919, 4186, 0, 4186, 4186, 4186, 4186 };
+
 AudioProcessor::AudioProcessor(int sample_rate, AudioConsumer *consumer)
 	: m_buffer(kMaxBufferSize),
 	  m_buffer_offset(0),
 	  m_resample_buffer(kMaxBufferSize),
 	  m_target_sample_rate(sample_rate),
+	  m_sample_rate(0),
+	  m_num_channels(0),
+	  m_downmix_weights(0),
 	  m_consumer(consumer),
-	  m_resample_ctx(0)
+	  m_resample_ctx(0),
+	  m_kernels(&GetSimdKernels())
 {
 }
 
@@ -38,56 +57,169 @@ AudioProcessor::~AudioProcessor()
 	}
 }
 
-void AudioProcessor::LoadMono(const int16_t *input, int length)
+void AudioProcessor::LoadMultiChannel(const int16_t *input, int length)
 {
 	int16_t *output = m_buffer.data() + m_buffer_offset;
 	while (length--) {
-		*output++ = input[0];
-		input++;
+		int32_t sum = 0;
+		for (int i = 0; i < m_num_channels; i++) {
+			sum += *input++;
+		}
+		*output++ = (int16_t)(sum / m_num_channels);
 	}
 }
 
-void AudioProcessor::LoadStereo(const int16_t *input, int length)
+void AudioProcessor::LoadPlanarMultiChannel(const int16_t *const *input, size_t offset, int length)
 {
 	int16_t *output = m_buffer.data() + m_buffer_offset;
-	while (length--) {
-		*output++ = (input[0] + input[1]) / 2;
-		input += 2;
+	for (int i = 0; i < length; i++) {
+		int32_t sum = 0;
+		for (int j = 0; j < m_num_channels; j++) {
+			sum += input[j][offset + i];
+		}
+		output[i] = (int16_t)(sum / m_num_channels);
 	}
 }
 
-void AudioProcessor::LoadMultiChannel(const int16_t *input, int length)
+// Float samples are downmixed before they are converted, so that the
+// conversion is done only once per output sample. There are no branches,
+// so that the compiler can vectorize the loops, NaN ends up as the maximum.
+static inline int16_t FloatToInt16(float x)
+{
+	x = std::max(-32768.0f, std::min(32767.0f, x * 32768.0f));
+	return static_cast<int16_t>(x + (x < 0.0f ? -0.5f : 0.5f));
+}
+
+int AudioProcessor::LoadFloat(const float *input, int length)
 {
+	assert(length >= 0);
+	assert(m_buffer_offset <= m_buffer.size());
+	length = std::min(length, static_cast<int>(m_buffer.size() - m_buffer_offset));
 	int16_t *output = m_buffer.data() + m_buffer_offset;
-	while (length--) {
-		int32_t sum = 0;
-		for (int i = 0; i < m_num_channels; i++) {
-			sum += *input++;
+	switch (m_num_channels) {
+	case 1:
+		for (int i = 0; i < length; i++) {
+			output[i] = FloatToInt16(input[i]);
 		}
-		*output++ = (int16_t)(sum / m_num_channels);
+		break;
+	case 2:
+		for (int i = 0; i < length; i++) {
+			output[i] = FloatToInt16((input[2 * i] + input[2 * i + 1]) * 0.5f);
+		}
+		break;
+	default: {
+		const float *weights = m_float_weights.data();
+		for (int i = 0; i < length; i++) {
+			float sum = 0.0f;
+			for (int j = 0; j < m_num_channels; j++) {
+				sum += *input++ * weights[j];
+			}
+			output[i] = FloatToInt16(sum);
+		}
+		break;
+	}
 	}
+	m_buffer_offset += length;
+	return length;
 }
 
-int AudioProcessor::Load(const int16_t *input, int length)
+int AudioProcessor::LoadPlanarFloat(const float *const *input, size_t offset, int length)
 {
 	assert(length >= 0);
 	assert(m_buffer_offset <= m_buffer.size());
 	length = std::min(length, static_cast<int>(m_buffer.size() - m_buffer_offset));
+	int16_t *output = m_buffer.data() + m_buffer_offset;
 	switch (m_num_channels) {
 	case 1:
-		LoadMono(input, length);
+		for (int i = 0; i < length; i++) {
+			output[i] = FloatToInt16(input[0][offset + i]);
+		}
 		break;
 	case 2:
-		LoadStereo(input, length);
+		for (int i = 0; i < length; i++) {
+			output[i] = FloatToInt16((input[0][offset + i] + input[1][offset + i]) * 0.5f);
+		}
 		break;
-	default:
-		LoadMultiChannel(input, length);
+	default: {
+		// sum one channel at a time, which is faster than reading all
+		// channels for each sample, in the same order as LoadFloat()
+		const float *weights = m_float_weights.data();
+		m_float_buffer.resize(m_buffer.size());
+		float *sum = m_float_buffer.data();
+		std::fill(sum, sum + length, 0.0f);
+		for (int j = 0; j < m_num_channels; j++) {
+			const float *channel = input[j] + offset;
+			for (int i = 0; i < length; i++) {
+				sum[i] += channel[i] * weights[j];
+			}
+		}
+		for (int i = 0; i < length; i++) {
+			output[i] = FloatToInt16(sum[i]);
+		}
 		break;
 	}
+	}
+	m_buffer_offset += length;
+	return length;
+}
+
+int AudioProcessor::Load(const int16_t *input, int length)
+{
+	assert(length >= 0);
+	assert(m_buffer_offset <= m_buffer.size());
+	length = std::min(length, static_cast<int>(m_buffer.size() - m_buffer_offset));
+	int16_t *output = m_buffer.data() + m_buffer_offset;
+	if (m_num_channels == 1) {
+		std::copy(input, input + length, output);
+	} else if (m_num_channels == 2) {
+		m_kernels->downmix_stereo(input, output, length);
+	} else if (m_downmix_weights) {
+		m_kernels->downmix_weighted(input, m_downmix_weights, m_num_channels, output, length);
+	} else {
+		LoadMultiChannel(input, length);
+	}
 	m_buffer_offset += length;
 	return length;
 }
 
+int AudioProcessor::LoadPlanar(const int16_t *const *input, size_t offset, int length)
+{
+	assert(length >= 0);
+	assert(m_buffer_offset <= m_buffer.size());
+	length = std::min(length, static_cast<int>(m_buffer.size() - m_buffer_offset));
+	int16_t *output = m_buffer.data() + m_buffer_offset;
+	if (m_num_channels == 1) {
+		std::copy(input[0] + offset, input[0] + offset + length, output);
+	} else if (m_num_channels == 2) {
+		m_kernels->downmix_stereo_planar(input[0] + offset, input[1] + offset, output, length);
+	} else if (m_downmix_weights) {
+		m_kernels->downmix_weighted_planar(input, offset, m_downmix_weights, m_num_channels, output, length);
+	} else {
+		LoadPlanarMultiChannel(input, offset, length);
+	}
+	m_buffer_offset += length;
+	return length;
+}
+
+// Resample the input and pass the result to the consumer. Returns the number
+// of output samples, the unused input needs to be passed again.
+int AudioProcessor::ResampleInput(const int16_t *input, int length, int *consumed)
+{
+	*consumed = 0;
+	int output_length;
+	if (m_polyphase_resampler) {
+		output_length = m_polyphase_resampler->Resample(m_resample_buffer.data(), input, consumed, length, kMaxBufferSize);
+	} else {
+		output_length = av_resample(m_resample_ctx, m_resample_buffer.data(), input, consumed, length, kMaxBufferSize, 1);
+	}
+	if (output_length > kMaxBufferSize) {
+		DEBUG("chromaprint::AudioProcessor::Resample() -- Resampling overwrote output buffer.");
+		output_length = kMaxBufferSize;
+	}
+	m_consumer->Consume(m_resample_buffer.data(), output_length);
+	return output_length;
+}
+
 void AudioProcessor::Resample()
 {
 	if (!m_resample_ctx) {
@@ -95,13 +227,8 @@ void AudioProcessor::Resample()
 		m_buffer_offset = 0;
 		return;
 	}
-	int consumed = 0;
-	int length = av_resample(m_resample_ctx, m_resample_buffer.data(), m_buffer.data(), &consumed, m_buffer_offset, kMaxBufferSize, 1);
-	if (length > kMaxBufferSize) {
-		DEBUG("chromaprint::AudioProcessor::Resample() -- Resampling overwrote output buffer.");
-		length = kMaxBufferSize;
-	}
-	m_consumer->Consume(m_resample_buffer.data(), length);
+	int consumed;
+	ResampleInput(m_buffer.data(), m_buffer_offset, &consumed);
 	int remaining = m_buffer_offset - consumed;
 	if (remaining > 0) {
 		std::copy(m_buffer.begin() + consumed, m_buffer.begin() + m_buffer_offset, m_buffer.begin());
@@ -113,6 +240,67 @@ void AudioProcessor::Resample()
 	m_buffer_offset = remaining;
 }
 
+// Mono input doesn't need to be copied to the buffer. Without resampling it
+// goes straight to the consumer. Otherwise the resampler reads the input
+// directly and only the samples it needs together with the buffered ones are
+// copied. The buffered samples are what the resampler didn't use last time,
+// so usually a bit less than the filter length. A ring buffer wouldn't help
+// here, the filter needs the samples to be contiguous.
+void AudioProcessor::ConsumeMono(const int16_t *input, int length)
+{
+	if (!m_resample_ctx) {
+		if (m_buffer_offset) {
+			Resample();
+		}
+		m_consumer->Consume(input, length);
+		return;
+	}
+
+	auto load = [&](int length) {
+		int consumed = Load(input, length);
+		input += consumed;
+		return consumed;
+	};
+
+	// At the start of the stream, the resampler mirrors the filter around the
+	// first sample and the result depends on how much input it gets at once.
+	// When upsampling, the output buffer can get full before all input is used
+	// and Flush() drops what doesn't fit, so the input must be buffered the same
+	// way as before, to not change the fingerprints.
+	int state[AV_RESAMPLE_STATE_SIZE];
+	av_resample_get_state(m_resample_ctx, state);
+	if (state[0] < 0 || m_sample_rate < m_target_sample_rate) {
+		Process(length, load);
+		return;
+	}
+
+	if (m_buffer_offset) {
+		const int overlap = std::min(length, static_cast<int>(std::min(m_buffer_offset + kMaxResampleOverlap, m_buffer.size()) - m_buffer_offset));
+		length -= Load(input, overlap);
+		input += overlap;
+		Resample();
+		if (m_buffer_offset > size_t(overlap)) {
+			// the resampler needs more input to get past the buffered samples
+			Process(length, load);
+			return;
+		}
+		// what is left in the buffer is the end of the overlap
+		input -= m_buffer_offset;
+		length += m_buffer_offset;
+		m_buffer_offset = 0;
+	}
+
+	while (length > 0) {
+		int consumed;
+		const int output_length = ResampleInput(input, length, &consumed);
+		input += consumed;
+		length -= consumed;
+		if (output_length < kMaxBufferSize) {
+			break;
+		}
+	}
+	Process(length, load);
+}
 
 bool AudioProcessor::Reset(int sample_rate, int num_channels)
 {
@@ -126,6 +314,7 @@ bool AudioProcessor::Reset(int sample_rate, int num_channels)
 		return false;
 	}
 	m_buffer_offset = 0;
+	m_polyphase_resampler.reset();
 	if (m_resample_ctx) {
 		av_resample_close(m_resample_ctx);
 		m_resample_ctx = 0;
@@ -137,19 +326,37 @@ bool AudioProcessor::Reset(int sample_rate, int num_channels)
 			kResamplePhaseShift,
 			kResampleLinear,
 			kResampleCutoff);
+		if (m_resample_ctx && PolyphaseResampler::IsSupported(m_target_sample_rate, sample_rate)) {
+			m_polyphase_resampler.reset(new PolyphaseResampler(m_resample_ctx, m_target_sample_rate, sample_rate));
+		}
+	}
+	switch (num_channels) {
+	case 6:
+		m_downmix_weights = kDownmixWeights51;
+		break;
+	case 8:
+		m_downmix_weights = kDownmixWeights71;
+		break;
+	default:
+		m_downmix_weights = 0;
+		break;
+	}
+	m_float_weights.resize(num_channels);
+	for (int i = 0; i < num_channels; i++) {
+		m_float_weights[i] = m_downmix_weights ? m_downmix_weights[i] / float(1 << kDownmixWeightBits) : 1.0f / num_channels;
 	}
+	m_sample_rate = sample_rate;
 	m_num_channels = num_channels;
 	return true;
 }
 
-void AudioProcessor::Consume(const int16_t *input, int length)
+// Load the input into the buffer in chunks and resample every full buffer.
+// The load function returns the number of frames it loaded.
+template <typename LoadFunc>
+void AudioProcessor::Process(int length, LoadFunc load)
 {
-	assert(length >= 0);
-	assert(length % m_num_channels == 0);
-	length /= m_num_channels;
 	while (length > 0) {
-		int consumed = Load(input, length); 
-		input += consumed * m_num_channels;
+		int consumed = load(length);
 		length -= consumed;
 		if (m_buffer.size() == m_buffer_offset) {
 			Resample();
@@ -161,11 +368,113 @@ void AudioProcessor::Consume(const int16_t *input, int length)
 	}
 }
 
+void AudioProcessor::Consume(const int16_t *input, int length)
+{
+	assert(length >= 0);
+	assert(length % m_num_channels == 0);
+	length /= m_num_channels;
+	CHROMAPRINT_STAGE_TIMER(AudioProcessor, length);
+	if (m_num_channels == 1) {
+		ConsumeMono(input, length);
+		return;
+	}
+	Process(length, [&](int length) {
+		int consumed = Load(input, length);
+		input += consumed * m_num_channels;
+		return consumed;
+	});
+}
+
+void AudioProcessor::ConsumePlanar(const int16_t *const *input, int length)
+{
+	assert(length >= 0);
+	CHROMAPRINT_STAGE_TIMER(AudioProcessor, length);
+	if (m_num_channels == 1) {
+		ConsumeMono(input[0], length);
+		return;
+	}
+	size_t offset = 0;
+	Process(length, [&](int length) {
+		int consumed = LoadPlanar(input, offset, length);
+		offset += consumed;
+		return consumed;
+	});
+}
+
+void AudioProcessor::ConsumeFloat(const float *input, int length)
+{
+	assert(length >= 0);
+	assert(length % m_num_channels == 0);
+	length /= m_num_channels;
+	CHROMAPRINT_STAGE_TIMER(AudioProcessor, length);
+	Process(length, [&](int length) {
+		int consumed = LoadFloat(input, length);
+		input += consumed * m_num_channels;
+		return consumed;
+	});
+}
+
+void AudioProcessor::ConsumePlanarFloat(const float *const *input, int length)
+{
+	assert(length >= 0);
+	CHROMAPRINT_STAGE_TIMER(AudioProcessor, length);
+	size_t offset = 0;
+	Process(length, [&](int length) {
+		int consumed = LoadPlanarFloat(input, offset, length);
+		offset += consumed;
+		return consumed;
+	});
+}
+
 void AudioProcessor::Flush()
 {
+	CHROMAPRINT_STAGE_TIMER(AudioProcessor, 0);
 	if (m_buffer_offset) {
 		Resample();
 	}
 }
 
+bool AudioProcessor::SaveState(StateWriter &writer) const
+{
+	if (!m_num_channels) {
+		DEBUG("chromaprint::AudioProcessor::SaveState() -- No audio stream was started.");
+		return false;
+	}
+	writer.Write(int32_t(m_sample_rate));
+	writer.Write(int32_t(m_num_channels));
+	writer.WriteArray(m_buffer.data(), m_buffer_offset);
+	int resample_state[AV_RESAMPLE_STATE_SIZE] = { 0 };
+	if (m_resample_ctx) {
+		av_resample_get_state(m_resample_ctx, resample_state);
+	}
+	writer.WriteArray(resample_state, AV_RESAMPLE_STATE_SIZE);
+	return true;
+}
+
+bool AudioProcessor::RestoreState(StateReader &reader)
+{
+	int32_t sample_rate, num_channels;
+	if (!reader.Read(&sample_rate) || !reader.Read(&num_channels)) {
+		return false;
+	}
+	if (!Reset(sample_rate, num_channels)) {
+		return false;
+	}
+	std::vector<int16_t> buffer;
+	if (!reader.ReadArray(&buffer, m_buffer.size() - 1)) {
+		return false;
+	}
+	std::copy(buffer.begin(), buffer.end(), m_buffer.begin());
+	m_buffer_offset = buffer.size();
+	int resample_state[AV_RESAMPLE_STATE_SIZE];
+	if (!reader.ReadArray(resample_state, AV_RESAMPLE_STATE_SIZE)) {
+		return false;
+	}
+	if (m_resample_ctx && av_resample_set_state(m_resample_ctx, resample_state) < 0) {
+		DEBUG("chromaprint::AudioProcessor::RestoreState() -- Invalid resampler state.");
+		return false;
+	}
+	return true;
+}
+
 }; // namespace chromaprint
@@ -6,6 +6,8 @@
 
 #include "utils.h"
 #include "audio_consumer.h"
+#include "simd/simd.h"
+#include <memory>
 #include <vector>
 
 struct AVResampleContext;
@@ -13,6 +15,10 @@ struct AVResampleContext;
 namespace chromaprint
 {
 
+	class StateWriter;
+	class StateReader;
+	class PolyphaseResampler;
+
 	class AudioProcessor : public AudioConsumer
 	{
 	public:
@@ -45,25 +51,53 @@ namespace chromaprint
 		//! Process a chunk of data from the audio stream
 		void Consume(const int16_t *input, int length);
 
+		//! Process a chunk of planar samples, one array per channel, length is per channel
+		void ConsumePlanar(const int16_t *const *input, int length);
+
+		//! Process a chunk of interleaved float samples in the [-1, 1] range
+		void ConsumeFloat(const float *input, int length);
+
+		//! Process a chunk of planar float samples, length is per channel
+		void ConsumePlanarFloat(const float *const *input, int length);
+
 		//! Process any buffered input that was not processed before and clear buffers
 		void Flush();
 
+		//! Save the stream parameters and buffered input, fails if no stream was started
+		bool SaveState(StateWriter &writer) const;
+
+		//! Prepare for continuing a stream saved by SaveState()
+		bool RestoreState(StateReader &reader);
+
 	private:
 		CHROMAPRINT_DISABLE_COPY(AudioProcessor);
 
+		template <typename LoadFunc>
+		void Process(int length, LoadFunc load);
+
+		void ConsumeMono(const int16_t *input, int length);
 		int Load(const int16_t *input, int length);
-		void LoadMono(const int16_t *input, int length);
-		void LoadStereo(const int16_t *input, int length);
+		int LoadPlanar(const int16_t *const *input, size_t offset, int length);
 		void LoadMultiChannel(const int16_t *input, int length);
+		void LoadPlanarMultiChannel(const int16_t *const *input, size_t offset, int length);
+		int LoadFloat(const float *input, int length);
+		int LoadPlanarFloat(const float *const *input, size_t offset, int length);
+		int ResampleInput(const int16_t *input, int length, int *consumed);
 		void Resample();
 
 		std::vector<int16_t> m_buffer;
 		size_t m_buffer_offset;
 		std::vector<int16_t> m_resample_buffer;
+		std::vector<float> m_float_buffer;
+		std::vector<float> m_float_weights;
 		int m_target_sample_rate;
+		int m_sample_rate;
 		int m_num_channels;
+		const int16_t *m_downmix_weights;
 		AudioConsumer *m_consumer;
 		struct AVResampleContext *m_resample_ctx;
+		std::unique_ptr<PolyphaseResampler> m_polyphase_resampler;
+		const SimdKernels *m_kernels;
 	};
 
 };
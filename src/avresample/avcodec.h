@@ -76,9 +76,15 @@ static CHROMAPRINT_C_INLINE int av_clip(int a, int amin, int amax)
 
 struct AVResampleContext;
 struct AVResampleContext *av_resample_init(int out_rate, int in_rate, int filter_length, int log2_phase_count, int linear, double cutoff);
-int av_resample(struct AVResampleContext *c, short *dst, short *src, int *consumed, int src_size, int dst_size, int update_ctx);
+int av_resample(struct AVResampleContext *c, short *dst, const short *src, int *consumed, int src_size, int dst_size, int update_ctx);
 void av_resample_compensate(struct AVResampleContext *c, int sample_delta, int compensation_distance);
 void av_resample_close(struct AVResampleContext *c);
+/* position of the resampler between av_resample() calls, to save and restore it */
+#define AV_RESAMPLE_STATE_SIZE 4
+void av_resample_get_state(const struct AVResampleContext *c, int state[AV_RESAMPLE_STATE_SIZE]);
+int av_resample_set_state(struct AVResampleContext *c, const int state[AV_RESAMPLE_STATE_SIZE]);
+/* filter bank with (1 << phase_shift) filters of filter_length taps, for alternative implementations of av_resample() */
+const short *av_resample_get_filter_bank(const struct AVResampleContext *c, int *filter_length, int *phase_shift);
 void av_build_filter(int16_t *filter, double factor, int tap_count, int phase_count, int scale, int type);
 
 /* error handling */
@@ -229,7 +229,34 @@ void av_resample_compensate(AVResampleContext *c, int sample_delta, int compensa
     c->dst_incr = c->ideal_dst_incr - c->ideal_dst_incr * (int64_t)sample_delta / compensation_distance;
 }
 
-int av_resample(AVResampleContext *c, short *dst, short *src, int *consumed, int src_size, int dst_size, int update_ctx){
+void av_resample_get_state(const AVResampleContext *c, int state[AV_RESAMPLE_STATE_SIZE]){
+    state[0]= c->index;
+    state[1]= c->frac;
+    state[2]= c->dst_incr;
+    state[3]= c->compensation_distance;
+}
+
+int av_resample_set_state(AVResampleContext *c, const int state[AV_RESAMPLE_STATE_SIZE]){
+    if(state[0] < -(c->filter_length << c->phase_shift) || state[0] > c->phase_mask)
+        return -1;
+    if(state[1] < 0 || state[1] >= c->src_incr || state[2] <= 0 || state[3] < 0)
+        return -1;
+    if(state[3] == 0 && state[2] != c->ideal_dst_incr)
+        return -1;
+    c->index= state[0];
+    c->frac= state[1];
+    c->dst_incr= state[2];
+    c->compensation_distance= state[3];
+    return 0;
+}
+
+const short *av_resample_get_filter_bank(const AVResampleContext *c, int *filter_length, int *phase_shift){
+    *filter_length= c->filter_length;
+    *phase_shift= c->phase_shift;
+    return c->filter_bank;
+}
+
+int av_resample(AVResampleContext *c, short *dst, const short *src, int *consumed, int src_size, int dst_size, int update_ctx){
     int dst_index, i;
     int index= c->index;
     int frac= c->frac;
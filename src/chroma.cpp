@@ -17,21 +17,16 @@ inline double FreqToOctave(double freq, double base = 440.0 / 16.0)
 	return log(freq / base) / log(2.0);
 }
 
-Chroma::Chroma(int min_freq, int max_freq, int frame_size, int sample_rate, FeatureVectorConsumer *consumer)
+ChromaTransform::ChromaTransform(int min_freq, int max_freq, int frame_size, int sample_rate)
 	: m_interpolate(false),
 	  m_notes(frame_size),
 	  m_notes_frac(frame_size),
-	  m_features(NUM_BANDS),
-	  m_consumer(consumer)
+	  m_kernels(&GetSimdKernels())
 {
 	PrepareNotes(min_freq, max_freq, frame_size, sample_rate);
 }
 
-Chroma::~Chroma()
-{
-}
-
-void Chroma::PrepareNotes(int min_freq, int max_freq, int frame_size, int sample_rate)
+void ChromaTransform::PrepareNotes(int min_freq, int max_freq, int frame_size, int sample_rate)
 {
 	m_min_index = std::max(1, FreqToIndex(min_freq, frame_size, sample_rate));
 	m_max_index = std::min(frame_size / 2, FreqToIndex(max_freq, frame_size, sample_rate));
@@ -41,22 +36,23 @@ void Chroma::PrepareNotes(int min_freq, int max_freq, int frame_size, int sample
 		double note = NUM_BANDS * (octave - floor(octave)); 
 		m_notes[i] = (char)note;
 		m_notes_frac[i] = note - m_notes[i];
+		if (m_note_ranges.empty() || m_note_ranges.back().note != m_notes[i]) {
+			m_note_ranges.push_back({ m_notes[i], i, i + 1 });
+		} else {
+			m_note_ranges.back().end = i + 1;
+		}
 	}
 }
 
-void Chroma::Reset()
+void ChromaTransform::Compute(const FFTFrame &frame, FeatureVector &features) const
 {
-}
-
-void Chroma::Consume(const FFTFrame &frame)
-{
-	fill(m_features.begin(), m_features.end(), 0.0);
-	for (int i = m_min_index; i < m_max_index; i++) {
-		int note = m_notes[i];
-		double energy = frame[i];
-		if (m_interpolate) {
+	fill(features.begin(), features.end(), FeatureScalar(0.0));
+	if (m_interpolate) {
+		for (int i = m_min_index; i < m_max_index; i++) {
+			int note = m_notes[i];
+			FeatureScalar energy = frame[i];
 			int note2 = note;
-			double a = 1.0;
+			FeatureScalar a = 1.0;
 			if (m_notes_frac[i] < 0.5) {
 				note2 = (note + NUM_BANDS - 1) % NUM_BANDS;
 				a = 0.5 + m_notes_frac[i];
@@ -65,14 +61,15 @@ void Chroma::Consume(const FFTFrame &frame)
 				note2 = (note + 1) % NUM_BANDS;
 				a = 1.5 - m_notes_frac[i];
 			}
-			m_features[note] += energy * a; 
-			m_features[note2] += energy * (1.0 - a); 
+			features[note] += energy * a; 
+			features[note2] += energy * (FeatureScalar(1.0) - a); 
 		}
-		else {
-			m_features[note] += energy; 
+	}
+	else {
+		for (const auto &range : m_note_ranges) {
+			features[range.note] += m_kernels->sum(frame.data() + range.begin, range.end - range.begin);
 		}
 	}
-	m_consumer->Consume(m_features);
 }
 
 }; // namespace chromaprint
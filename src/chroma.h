@@ -9,13 +9,15 @@
 #include "utils.h"
 #include "fft_frame_consumer.h"
 #include "feature_vector_consumer.h"
+#include "simd/simd.h"
+#include "stats.h"
 
 namespace chromaprint {
 
-class Chroma : public FFTFrameConsumer {
+// Projection of FFT frames onto the 12 pitch classes.
+class ChromaTransform {
 public:
-	Chroma(int min_freq, int max_freq, int frame_size, int sample_rate, FeatureVectorConsumer *consumer);
-	~Chroma();
+	ChromaTransform(int min_freq, int max_freq, int frame_size, int sample_rate);
 
 	bool interpolate() const {
 		return m_interpolate;
@@ -25,23 +27,74 @@ public:
 		m_interpolate = interpolate;
 	}
 
-	void Reset();
-	void Consume(const FFTFrame &frame);
+	int min_index() const { return m_min_index; }
+	int max_index() const { return m_max_index; }
 
-private:
-	CHROMAPRINT_DISABLE_COPY(Chroma);
+	//! Sum the energy of the frame's bins into the features of their notes.
+	void Compute(const FFTFrame &frame, FeatureVector &features) const;
 
+private:
 	void PrepareNotes(int min_freq, int max_freq, int frame_size, int sample_rate);
 
+	// Range of consecutive FFT bins that belong to the same note.
+	struct NoteRange {
+		int note;
+		int begin;
+		int end;
+	};
+
 	bool m_interpolate;
 	std::vector<char> m_notes;
-	std::vector<double> m_notes_frac;
+	std::vector<FeatureScalar> m_notes_frac;
+	std::vector<NoteRange> m_note_ranges;
 	int m_min_index;
 	int m_max_index;
-	std::vector<double> m_features;
-	FeatureVectorConsumer *m_consumer;
+	const SimdKernels *m_kernels;
 };
 
+// The consumer type is a template parameter, so that when it's a concrete
+// stage, the call to it is not virtual and can be inlined. Use Chroma for
+// any FeatureVectorConsumer.
+template <typename Consumer>
+class BasicChroma : public FFTFrameConsumer {
+public:
+	BasicChroma(int min_freq, int max_freq, int frame_size, int sample_rate, Consumer *consumer)
+		: m_transform(min_freq, max_freq, frame_size, sample_rate),
+		  m_features(12),
+		  m_consumer(consumer) {}
+
+	bool interpolate() const {
+		return m_transform.interpolate();
+	}
+
+	void set_interpolate(bool interpolate) {
+		m_transform.set_interpolate(interpolate);
+	}
+
+	void Reset() {}
+
+	void Consume(const FFTFrame &frame) override final {
+		CHROMAPRINT_STAGE_TIMER(Chroma, 1);
+		m_transform.Compute(frame, m_features);
+		m_consumer->Consume(m_features);
+	}
+
+	bool GetBinRange(size_t *begin, size_t *end) const override {
+		*begin = m_transform.min_index();
+		*end = m_transform.max_index();
+		return true;
+	}
+
+private:
+	CHROMAPRINT_DISABLE_COPY(BasicChroma);
+
+	ChromaTransform m_transform;
+	FeatureVector m_features;
+	Consumer *m_consumer;
+};
+
+typedef BasicChroma<FeatureVectorConsumer> Chroma;
+
 }; // namespace chromaprint
 
 #endif
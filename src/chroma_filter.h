@@ -4,32 +4,127 @@
 #ifndef CHROMAPRINT_CHROMA_FILTER_H_
 #define CHROMAPRINT_CHROMA_FILTER_H_
 
-#include <vector>
+#include <array>
+#include <cassert>
+#include <algorithm>
 #include "feature_vector_consumer.h"
+#include "stats.h"
+#include "utils.h"
+#include "utils/state_buffer.h"
 
 namespace chromaprint {
-	
-class ChromaFilter : public FeatureVectorConsumer {
+
+// The consumer type is a template parameter, so that when it's a concrete
+// stage, the call to it is not virtual and can be inlined. Use ChromaFilter
+// for any FeatureVectorConsumer.
+template <typename Consumer>
+class BasicChromaFilter : public FeatureVectorConsumer {
 public:
-	ChromaFilter(const double *coefficients, int length, FeatureVectorConsumer *consumer);
-	~ChromaFilter();
+	static const int kMaxLength = 8;
+
+	BasicChromaFilter(const double *coefficients, int length, Consumer *consumer)
+		: m_length(length),
+		  m_filter(GetFilter(length)),
+		  m_result(12),
+		  m_buffer_offset(0),
+		  m_buffer_size(1),
+		  m_consumer(consumer)
+	{
+		assert(length >= 1 && length <= kMaxLength);
+		std::copy(coefficients, coefficients + length, m_coefficients.begin());
+	}
+
+	void Reset() {
+		m_buffer_size = 1;
+		m_buffer_offset = 0;
+	}
+
+	void Consume(FeatureVector &features) override final {
+		CHROMAPRINT_STAGE_TIMER(ChromaFilter, 1);
+		assert(features.size() == 12);
+		// every row is stored twice, so that the last m_length rows are
+		// always next to each other
+		std::copy(features.begin(), features.end(), m_buffer[m_buffer_offset].begin());
+		std::copy(features.begin(), features.end(), m_buffer[m_buffer_offset + kMaxLength].begin());
+		m_buffer_offset = (m_buffer_offset + 1) % kMaxLength;
+		if (m_buffer_size >= m_length) {
+			const auto rows = m_buffer.data() + m_buffer_offset + kMaxLength - m_length;
+			m_filter(rows, m_coefficients.data(), m_result.data());
+			m_consumer->Consume(m_result);
+		}
+		else {
+			m_buffer_size++;
+		}
+	}
+
+	void SaveState(StateWriter &writer) const {
+		writer.Write(int32_t(m_buffer_offset));
+		writer.Write(int32_t(m_buffer_size));
+		writer.WriteArray(m_buffer[0].data(), kMaxLength * 12);
+	}
 
-	void Reset();
-	void Consume(std::vector<double> &features);
+	bool RestoreState(StateReader &reader) {
+		int32_t offset, size;
+		if (!reader.Read(&offset) || !reader.Read(&size)) {
+			return false;
+		}
+		if (offset < 0 || offset >= kMaxLength || size < 1 || size > m_length) {
+			return false;
+		}
+		if (!reader.ReadArray(m_buffer[0].data(), kMaxLength * 12)) {
+			return false;
+		}
+		std::copy(m_buffer.begin(), m_buffer.begin() + kMaxLength, m_buffer.begin() + kMaxLength);
+		m_buffer_offset = offset;
+		m_buffer_size = size;
+		return true;
+	}
 
-	FeatureVectorConsumer *consumer() { return m_consumer; }
-	void set_consumer(FeatureVectorConsumer *consumer) { m_consumer = consumer; }
+	Consumer *consumer() { return m_consumer; }
+	void set_consumer(Consumer *consumer) { m_consumer = consumer; }
 
 private:
-	const double *m_coefficients;
+	CHROMAPRINT_DISABLE_COPY(BasicChromaFilter);
+
+	typedef std::array<FeatureScalar, 12> Row;
+	typedef void (*FilterFunc)(const Row *rows, const FeatureScalar *coefficients, FeatureScalar *result);
+
+	template <int Length>
+	static void Filter(const Row *rows, const FeatureScalar *coefficients, FeatureScalar *result) {
+		for (int i = 0; i < 12; i++) {
+			FeatureScalar sum = 0.0;
+			for (int j = 0; j < Length; j++) {
+				sum += rows[j][i] * coefficients[j];
+			}
+			result[i] = sum;
+		}
+	}
+
+	static FilterFunc GetFilter(int length) {
+		switch (length) {
+			case 1: return Filter<1>;
+			case 2: return Filter<2>;
+			case 3: return Filter<3>;
+			case 4: return Filter<4>;
+			case 5: return Filter<5>;
+			case 6: return Filter<6>;
+			case 7: return Filter<7>;
+			default: return Filter<8>;
+		}
+	}
+
+	std::array<FeatureScalar, kMaxLength> m_coefficients;
 	int m_length;
-	std::vector< std::vector<double> > m_buffer;
-	std::vector<double> m_result;
+	FilterFunc m_filter;
+	std::array<Row, 2 * kMaxLength> m_buffer;
+	FeatureVector m_result;
 	int m_buffer_offset;
 	int m_buffer_size;
-	FeatureVectorConsumer *m_consumer;
+	Consumer *m_consumer;
 };
 
+typedef BasicChromaFilter<FeatureVectorConsumer> ChromaFilter;
+
 }; // namespace chromaprint
 
 #endif
@@ -8,29 +8,37 @@
 #include <algorithm>
 #include "feature_vector_consumer.h"
 #include "utils.h"
+#include "stats.h"
 
 namespace chromaprint {
 
-class ChromaNormalizer : public FeatureVectorConsumer {
+// The consumer type is a template parameter, so that when it's a concrete
+// stage, the call to it is not virtual and can be inlined. Use
+// ChromaNormalizer for any FeatureVectorConsumer.
+template <typename Consumer>
+class BasicChromaNormalizer : public FeatureVectorConsumer {
 public:
-	ChromaNormalizer(FeatureVectorConsumer *consumer) : m_consumer(consumer) {}
-	~ChromaNormalizer() {}
+	BasicChromaNormalizer(Consumer *consumer) : m_consumer(consumer) {}
+	~BasicChromaNormalizer() {}
 	void Reset() {}
 
-	void Consume(std::vector<double> &features)
+	void Consume(FeatureVector &features) override final
 	{
+		CHROMAPRINT_STAGE_TIMER(ChromaNormalizer, 1);
 		NormalizeVector(features.begin(), features.end(),
-						chromaprint::EuclideanNorm<std::vector<double>::iterator>,
+						chromaprint::EuclideanNorm<FeatureVector::iterator>,
 						0.01);
 		m_consumer->Consume(features);
 	}
 
 private:
-	CHROMAPRINT_DISABLE_COPY(ChromaNormalizer);
+	CHROMAPRINT_DISABLE_COPY(BasicChromaNormalizer);
 
-	FeatureVectorConsumer *m_consumer;
+	Consumer *m_consumer;
 };
 
+typedef BasicChromaNormalizer<FeatureVectorConsumer> ChromaNormalizer;
+
 }; // namespace chromaprint
 
 #endif
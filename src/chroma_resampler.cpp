@@ -15,6 +15,7 @@ ChromaResampler::ChromaResampler(int factor, FeatureVectorConsumer *consumer)
 	  m_factor(factor),
 	  m_consumer(consumer)
 {
+	m_sum.fill(0.0);
 }
 
 ChromaResampler::~ChromaResampler()
@@ -24,18 +25,18 @@ ChromaResampler::~ChromaResampler()
 void ChromaResampler::Reset()
 {
 	m_iteration = 0;
-	fill(m_result.begin(), m_result.end(), 0.0);
+	m_sum.fill(0.0);
 }
 
-void ChromaResampler::Consume(std::vector<double> &features)
+void ChromaResampler::Consume(FeatureVector &features)
 {
 	for (int i = 0; i < 12; i++) {
-		m_result[i] += features[i];
+		m_sum[i] += features[i];
 	}
 	m_iteration += 1;
 	if (m_iteration == m_factor) {
 		for (int i = 0; i < 12; i++) {
-			m_result[i] /= m_factor;
+			m_result[i] = m_sum[i] / m_factor;
 		}
 		m_consumer->Consume(m_result);
 		Reset();
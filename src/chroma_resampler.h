@@ -4,6 +4,7 @@
 #ifndef CHROMAPRINT_CHROMA_RESAMPLER_H_
 #define CHROMAPRINT_CHROMA_RESAMPLER_H_
 
+#include <array>
 #include <vector>
 #include "image.h"
 #include "feature_vector_consumer.h"
@@ -16,13 +17,14 @@ public:
 	~ChromaResampler();
 
 	void Reset();
-	void Consume(std::vector<double> &features);
+	void Consume(FeatureVector &features);
 
 	FeatureVectorConsumer *consumer() { return m_consumer; }
 	void set_consumer(FeatureVectorConsumer *consumer) { m_consumer = consumer; }
 
 private:
-	std::vector<double> m_result;
+	std::array<FeatureScalar, 12> m_sum;
+	FeatureVector m_result;
 	int m_iteration;
 	int m_factor;
 	FeatureVectorConsumer *m_consumer;
@@ -11,13 +11,21 @@
 #include "fingerprint_compressor.h"
 #include "fingerprint_decompressor.h"
 #include "fingerprint_matcher.h"
+#include "fingerprint_index.h"
+#include "fingerprint_searcher.h"
 #include "fingerprinter_configuration.h"
 #include "utils/base64.h"
+#include "utils/state_buffer.h"
 #include "simhash.h"
+#include "stats.h"
 #include "debug.h"
 
 using namespace chromaprint;
 
+static_assert(kNumStages == CHROMAPRINT_NUM_STAGES, "ChromaprintStage does not match chromaprint::Stage");
+
+static const uint32_t kStateMagic = 0x54535043; // "CPST"
+
 struct ChromaprintContextPrivate {
 	ChromaprintContextPrivate(int algorithm)
 		: algorithm(algorithm),
@@ -26,13 +34,92 @@ struct ChromaprintContextPrivate {
 	Fingerprinter fingerprinter;
 	FingerprintCompressor compressor;
 	std::string tmp_fingerprint;
+	size_t fingerprint_cursor = 0;
+	ChromaprintRawFingerprintCallback fingerprint_callback = nullptr;
+	void *fingerprint_callback_data = nullptr;
+	Stats stats;
+
+	size_t GetNewItems(const uint32_t **data) {
+		const auto &fingerprint = fingerprinter.GetFingerprint();
+		const auto size = fingerprint.size() - fingerprint_cursor;
+		*data = fingerprint.data() + fingerprint_cursor;
+		fingerprint_cursor = fingerprint.size();
+		return size;
+	}
+
+	void NotifyNewItems() {
+		if (fingerprint_callback) {
+			const uint32_t *data;
+			const auto size = GetNewItems(&data);
+			if (size > 0) {
+				fingerprint_callback(fingerprint_callback_data, data, size);
+			}
+		}
+	}
 };
 
 struct ChromaprintMatcherContextPrivate {
 	int algorithm = -1;
 	std::unique_ptr<FingerprintMatcher> matcher;
 	std::vector<uint32_t> fp[2];
+	int fp_algorithm[2] = { -1, -1 };
 	FingerprintDecompressor decompressor;
+	std::string tmp_encoded;
+	std::string tmp_decoded;
+
+	bool SetAlgorithm(int new_algorithm) {
+		if (matcher && algorithm == new_algorithm) {
+			return true;
+		}
+		auto config = CreateFingerprinterConfiguration(new_algorithm);
+		if (!config) {
+			return false;
+		}
+		matcher.reset(new FingerprintMatcher(config));
+		algorithm = new_algorithm;
+		return true;
+	}
+};
+
+struct ChromaprintIndexContextPrivate {
+	int algorithm;
+	FingerprintIndex index;
+};
+
+struct ChromaprintSearcherContextPrivate {
+	struct Result {
+		uint32_t id;
+		size_t segments_begin;
+		size_t segments_end;
+	};
+
+	ChromaprintSearcherContextPrivate(const ChromaprintIndexContextPrivate *index)
+		: index(&index->index),
+		  searcher(&index->index),
+		  matcher(CreateFingerprinterConfiguration(index->algorithm)) {}
+	const FingerprintIndex *index;
+	FingerprintSearcher searcher;
+	FingerprintMatcher matcher;
+	size_t max_candidates = 10;
+	std::vector<FingerprintSearchResult> candidates;
+	std::vector<Result> results;
+	std::vector<Segment> segments;
+
+	// Compare the candidates with the query and keep those with matching segments.
+	void Search(const uint32_t *fp, size_t size) {
+		searcher.Search(fp, size, max_candidates, candidates);
+		results.clear();
+		segments.clear();
+		for (const auto &candidate : candidates) {
+			size_t candidate_size;
+			const auto candidate_fp = index->GetFingerprint(candidate.doc, &candidate_size);
+			if (!matcher.Match(fp, size, candidate_fp, candidate_size) || matcher.segments().empty()) {
+				continue;
+			}
+			results.push_back({ candidate.id, segments.size(), segments.size() + matcher.segments().size() });
+			segments.insert(segments.end(), matcher.segments().begin(), matcher.segments().end());
+		}
+	}
 };
 
 extern "C" {
@@ -104,26 +191,111 @@ int chromaprint_get_delay_ms(ChromaprintContext *ctx)
 int chromaprint_start(ChromaprintContext *ctx, int sample_rate, int num_channels)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	ctx->fingerprint_cursor = 0;
 	return ctx->fingerprinter.Start(sample_rate, num_channels) ? 1 : 0;
 }
 
 int chromaprint_feed(ChromaprintContext *ctx, const int16_t *data, int length)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	CHROMAPRINT_STATS_SCOPE(&ctx->stats);
 	ctx->fingerprinter.Consume(data, length);
+	ctx->NotifyNewItems();
+	return 1;
+}
+
+int chromaprint_feed_planar(ChromaprintContext *ctx, const int16_t *const *data, int length)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	CHROMAPRINT_STATS_SCOPE(&ctx->stats);
+	ctx->fingerprinter.ConsumePlanar(data, length);
+	ctx->NotifyNewItems();
+	return 1;
+}
+
+int chromaprint_feed_float(ChromaprintContext *ctx, const float *data, int length)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	CHROMAPRINT_STATS_SCOPE(&ctx->stats);
+	ctx->fingerprinter.ConsumeFloat(data, length);
+	ctx->NotifyNewItems();
+	return 1;
+}
+
+int chromaprint_feed_planar_float(ChromaprintContext *ctx, const float *const *data, int length)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	CHROMAPRINT_STATS_SCOPE(&ctx->stats);
+	ctx->fingerprinter.ConsumePlanarFloat(data, length);
+	ctx->NotifyNewItems();
 	return 1;
 }
 
 int chromaprint_finish(ChromaprintContext *ctx)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	CHROMAPRINT_STATS_SCOPE(&ctx->stats);
 	ctx->fingerprinter.Finish();
+	ctx->NotifyNewItems();
+	return 1;
+}
+
+int chromaprint_process_parallel(ChromaprintContext *ctx, int sample_rate, int num_channels, const int16_t *data, int size, int num_threads)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(size < 0, "size can't be negative");
+	CHROMAPRINT_STATS_SCOPE(&ctx->stats);
+	ctx->fingerprint_cursor = 0;
+	if (!ctx->fingerprinter.ProcessParallel(sample_rate, num_channels, data, size, num_threads)) {
+		return 0;
+	}
+	ctx->NotifyNewItems();
+	return 1;
+}
+
+int chromaprint_save_state(ChromaprintContext *ctx, void **data, int *size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	std::string state;
+	StateWriter writer(&state);
+	writer.Write(kStateMagic);
+	writer.Write(int32_t(ctx->algorithm));
+	FAIL_IF(!ctx->fingerprinter.SaveState(writer), "no audio stream was started");
+	writer.Write(uint64_t(ctx->fingerprint_cursor));
+	*data = malloc(state.size());
+	FAIL_IF(!*data, "can't allocate memory for the result");
+	memcpy(*data, state.data(), state.size());
+	*size = state.size();
+	return 1;
+}
+
+int chromaprint_restore_state(ChromaprintContext *ctx, const void *data, int size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!data || size < 0, "invalid state");
+	StateReader reader(reinterpret_cast<const char *>(data), size);
+	uint32_t magic;
+	int32_t algorithm;
+	FAIL_IF(!reader.Read(&magic) || magic != kStateMagic, "invalid state");
+	FAIL_IF(!reader.Read(&algorithm) || algorithm != ctx->algorithm, "state was saved with a different algorithm");
+	// the previous fingerprint is gone even if the restore fails
+	ctx->fingerprint_cursor = 0;
+	uint64_t cursor;
+	if (!ctx->fingerprinter.RestoreState(reader) ||
+		!reader.Read(&cursor) || cursor > ctx->fingerprinter.GetFingerprint().size() ||
+		!reader.AtEnd()) {
+		ctx->fingerprinter.ClearFingerprint();
+		DEBUG("invalid state");
+		return 0;
+	}
+	ctx->fingerprint_cursor = cursor;
 	return 1;
 }
 
 int chromaprint_get_fingerprint(ChromaprintContext *ctx, char **data)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
+	CHROMAPRINT_STATS_SCOPE(&ctx->stats);
 	ctx->compressor.Compress(ctx->fingerprinter.GetFingerprint(), ctx->algorithm, ctx->tmp_fingerprint);
 	*data = (char *) malloc(GetBase64EncodedSize(ctx->tmp_fingerprint.size()) + 1);
 	FAIL_IF(!*data, "can't allocate memory for the result");
@@ -134,7 +306,7 @@ int chromaprint_get_fingerprint(ChromaprintContext *ctx, char **data)
 int chromaprint_get_raw_fingerprint(ChromaprintContext *ctx, uint32_t **data, int *size)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
-	const auto fingerprint = ctx->fingerprinter.GetFingerprint();
+	const auto &fingerprint = ctx->fingerprinter.GetFingerprint();
 	*data = (uint32_t *) malloc(sizeof(uint32_t) * fingerprint.size());
 	FAIL_IF(!*data, "can't allocate memory for the result");
 	*size = fingerprint.size();
@@ -142,14 +314,47 @@ int chromaprint_get_raw_fingerprint(ChromaprintContext *ctx, uint32_t **data, in
 	return 1;
 }
 
-int chromaprint_get_raw_fingerprint_size(ChromaprintContext *ctx, int *size)
+int chromaprint_get_raw_fingerprint_into(ChromaprintContext *ctx, uint32_t *data, int capacity, int *size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	const auto &fingerprint = ctx->fingerprinter.GetFingerprint();
+	*size = fingerprint.size();
+	FAIL_IF(capacity < 0 || fingerprint.size() > size_t(capacity), "buffer is too small");
+	std::copy(fingerprint.begin(), fingerprint.end(), data);
+	return 1;
+}
+
+int chromaprint_borrow_raw_fingerprint(ChromaprintContext *ctx, const uint32_t **data, int *size)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
-	const auto fingerprint = ctx->fingerprinter.GetFingerprint();
+	const auto &fingerprint = ctx->fingerprinter.GetFingerprint();
+	*data = fingerprint.data();
 	*size = fingerprint.size();
 	return 1;
 }
 
+int chromaprint_get_raw_fingerprint_size(ChromaprintContext *ctx, int *size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	*size = ctx->fingerprinter.GetFingerprint().size();
+	return 1;
+}
+
+int chromaprint_get_new_raw_fingerprint(ChromaprintContext *ctx, const uint32_t **data, int *size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	*size = ctx->GetNewItems(data);
+	return 1;
+}
+
+int chromaprint_set_raw_fingerprint_callback(ChromaprintContext *ctx, ChromaprintRawFingerprintCallback callback, void *user_data)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	ctx->fingerprint_callback = callback;
+	ctx->fingerprint_callback_data = user_data;
+	return 1;
+}
+
 int chromaprint_get_fingerprint_hash(ChromaprintContext *ctx, uint32_t *hash)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
@@ -161,9 +366,41 @@ int chromaprint_clear_fingerprint(ChromaprintContext *ctx)
 {
 	FAIL_IF(!ctx, "context can't be NULL");
 	ctx->fingerprinter.ClearFingerprint();
+	ctx->fingerprint_cursor = 0;
+	return 1;
+}
+
+int chromaprint_get_stats(ChromaprintContext *ctx, int stage, uint64_t *time_ns, uint64_t *count)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(stage < 0 || stage >= kNumStages, "invalid stage");
+#ifdef USE_STATS
+	const auto &stats = ctx->stats.stage(Stage(stage));
+	*time_ns = stats.time_ns;
+	*count = stats.count;
+	return 1;
+#else
+	*time_ns = 0;
+	*count = 0;
+	FAIL_IF(true, "statistics are not enabled, rebuild with USE_STATS");
+#endif
+}
+
+int chromaprint_reset_stats(ChromaprintContext *ctx)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	ctx->stats.Reset();
 	return 1;
 }
 
+const char *chromaprint_get_stage_name(int stage)
+{
+	if (stage < 0 || stage >= kNumStages) {
+		return nullptr;
+	}
+	return GetStageName(Stage(stage));
+}
+
 int chromaprint_encode_fingerprint(const uint32_t *fp, int size, int algorithm, char **encoded_fp, int *encoded_size, int base64)
 {
 	std::vector<uint32_t> uncompressed(fp, fp + size);
@@ -212,6 +449,241 @@ int chromaprint_hash_fingerprint(const uint32_t *fp, int size, uint32_t *hash)
 	return 1;
 }
 
+ChromaprintMatcherContext *chromaprint_matcher_new(void)
+{
+	return new ChromaprintMatcherContextPrivate();
+}
+
+void chromaprint_matcher_free(ChromaprintMatcherContext *ctx)
+{
+	if (ctx) {
+		delete ctx;
+	}
+}
+
+int chromaprint_matcher_set_fingerprint(ChromaprintMatcherContext *ctx, int idx, const uint32_t *fp, int size, int algorithm)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(idx < 0 || idx > 1, "invalid fingerprint index");
+	FAIL_IF(!fp && size > 0, "fingerprint can't be NULL");
+	FAIL_IF(size < 0, "invalid fingerprint size");
+	FAIL_IF(!ctx->SetAlgorithm(algorithm), "invalid algorithm");
+	ctx->fp[idx].assign(fp, fp + size);
+	ctx->fp_algorithm[idx] = algorithm;
+	return 1;
+}
+
+int chromaprint_matcher_set_encoded_fingerprint(ChromaprintMatcherContext *ctx, int idx, const char *fp, int size, int base64)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(idx < 0 || idx > 1, "invalid fingerprint index");
+	FAIL_IF(!fp || size < 0, "invalid fingerprint");
+	ctx->tmp_encoded.assign(fp, size);
+	if (base64) {
+		Base64Decode(ctx->tmp_encoded, ctx->tmp_decoded);
+		ctx->tmp_encoded.swap(ctx->tmp_decoded);
+	}
+	FAIL_IF(!ctx->decompressor.Decompress(ctx->tmp_encoded), "can't decode the fingerprint");
+	FAIL_IF(!ctx->SetAlgorithm(ctx->decompressor.GetAlgorithm()), "invalid algorithm");
+	const auto &output = ctx->decompressor.GetOutput();
+	ctx->fp[idx].assign(output.begin(), output.end());
+	ctx->fp_algorithm[idx] = ctx->algorithm;
+	return 1;
+}
+
+int chromaprint_matcher_run(ChromaprintMatcherContext *ctx)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "fingerprints are not set");
+	FAIL_IF(ctx->fp_algorithm[0] != ctx->fp_algorithm[1], "fingerprints were generated by different algorithms");
+	return ctx->matcher->Match(ctx->fp[0], ctx->fp[1]) ? 1 : 0;
+}
+
+int chromaprint_matcher_get_num_segments(ChromaprintMatcherContext *ctx, int *num)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "fingerprints are not set");
+	*num = ctx->matcher->segments().size();
+	return 1;
+}
+
+int chromaprint_matcher_get_segment_position(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "fingerprints are not set");
+	const auto &segments = ctx->matcher->segments();
+	FAIL_IF(idx < 0 || idx >= int(segments.size()), "invalid segment index");
+	const auto &segment = segments[idx];
+	*pos1 = segment.pos1;
+	*pos2 = segment.pos2;
+	*duration = segment.duration;
+	return 1;
+}
+
+int chromaprint_matcher_get_segment_position_ms(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "fingerprints are not set");
+	const auto &segments = ctx->matcher->segments();
+	FAIL_IF(idx < 0 || idx >= int(segments.size()), "invalid segment index");
+	const auto &segment = segments[idx];
+	*pos1 = int(ctx->matcher->GetHashTime(segment.pos1) * 1000.0 + 0.5);
+	*pos2 = int(ctx->matcher->GetHashTime(segment.pos2) * 1000.0 + 0.5);
+	*duration = int(ctx->matcher->GetHashDuration(segment.duration) * 1000.0 + 0.5);
+	return 1;
+}
+
+int chromaprint_matcher_get_segment_score(ChromaprintMatcherContext *ctx, int idx, int *score)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!ctx->matcher, "fingerprints are not set");
+	const auto &segments = ctx->matcher->segments();
+	FAIL_IF(idx < 0 || idx >= int(segments.size()), "invalid segment index");
+	*score = segments[idx].public_score();
+	return 1;
+}
+
+ChromaprintIndexContext *chromaprint_index_new(int algorithm)
+{
+	std::unique_ptr<FingerprinterConfiguration> config(CreateFingerprinterConfiguration(algorithm));
+	if (!config) {
+		return nullptr;
+	}
+	auto ctx = new ChromaprintIndexContextPrivate();
+	ctx->algorithm = algorithm;
+	return ctx;
+}
+
+void chromaprint_index_free(ChromaprintIndexContext *ctx)
+{
+	if (ctx) {
+		delete ctx;
+	}
+}
+
+int chromaprint_index_add_fingerprint(ChromaprintIndexContext *ctx, uint32_t id, const uint32_t *fp, int size)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!fp && size > 0, "fingerprint can't be NULL");
+	FAIL_IF(size < 0, "invalid fingerprint size");
+	ctx->index.AddFingerprint(id, fp, size);
+	return 1;
+}
+
+int chromaprint_index_build(ChromaprintIndexContext *ctx)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	ctx->index.Build();
+	return 1;
+}
+
+int chromaprint_index_save(ChromaprintIndexContext *ctx, const char *file_name)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!file_name, "file name can't be NULL");
+	return ctx->index.Save(file_name) ? 1 : 0;
+}
+
+int chromaprint_index_open(ChromaprintIndexContext *ctx, const char *file_name)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!file_name, "file name can't be NULL");
+	return ctx->index.Open(file_name) ? 1 : 0;
+}
+
+int chromaprint_index_get_num_fingerprints(ChromaprintIndexContext *ctx, int *num)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	*num = ctx->index.num_docs();
+	return 1;
+}
+
+ChromaprintSearcherContext *chromaprint_searcher_new(ChromaprintIndexContext *index)
+{
+	if (!index) {
+		return nullptr;
+	}
+	return new ChromaprintSearcherContextPrivate(index);
+}
+
+void chromaprint_searcher_free(ChromaprintSearcherContext *ctx)
+{
+	if (ctx) {
+		delete ctx;
+	}
+}
+
+int chromaprint_searcher_set_max_candidates(ChromaprintSearcherContext *ctx, int num)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(num < 0, "invalid number of candidates");
+	ctx->max_candidates = num;
+	return 1;
+}
+
+int chromaprint_searcher_search(ChromaprintSearcherContext *ctx, const uint32_t *fp, int size, int *num_results)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(!fp && size > 0, "fingerprint can't be NULL");
+	FAIL_IF(size < 0, "invalid fingerprint size");
+	ctx->Search(fp, size);
+	*num_results = ctx->results.size();
+	return 1;
+}
+
+int chromaprint_searcher_get_result(ChromaprintSearcherContext *ctx, int idx, uint32_t *id, int *num_segments)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	FAIL_IF(idx < 0 || idx >= int(ctx->results.size()), "invalid result index");
+	const auto &result = ctx->results[idx];
+	*id = result.id;
+	*num_segments = result.segments_end - result.segments_begin;
+	return 1;
+}
+
+static const Segment *GetSearcherSegment(ChromaprintSearcherContext *ctx, int idx, int segment_idx)
+{
+	if (idx < 0 || idx >= int(ctx->results.size())) {
+		return nullptr;
+	}
+	const auto &result = ctx->results[idx];
+	if (segment_idx < 0 || segment_idx >= int(result.segments_end - result.segments_begin)) {
+		return nullptr;
+	}
+	return &ctx->segments[result.segments_begin + segment_idx];
+}
+
+int chromaprint_searcher_get_segment_position(ChromaprintSearcherContext *ctx, int idx, int segment_idx, int *pos1, int *pos2, int *duration)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	const auto segment = GetSearcherSegment(ctx, idx, segment_idx);
+	FAIL_IF(!segment, "invalid segment index");
+	*pos1 = segment->pos1;
+	*pos2 = segment->pos2;
+	*duration = segment->duration;
+	return 1;
+}
+
+int chromaprint_searcher_get_segment_position_ms(ChromaprintSearcherContext *ctx, int idx, int segment_idx, int *pos1, int *pos2, int *duration)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	const auto segment = GetSearcherSegment(ctx, idx, segment_idx);
+	FAIL_IF(!segment, "invalid segment index");
+	*pos1 = int(ctx->matcher.GetHashTime(segment->pos1) * 1000.0 + 0.5);
+	*pos2 = int(ctx->matcher.GetHashTime(segment->pos2) * 1000.0 + 0.5);
+	*duration = int(ctx->matcher.GetHashDuration(segment->duration) * 1000.0 + 0.5);
+	return 1;
+}
+
+int chromaprint_searcher_get_segment_score(ChromaprintSearcherContext *ctx, int idx, int segment_idx, int *score)
+{
+	FAIL_IF(!ctx, "context can't be NULL");
+	const auto segment = GetSearcherSegment(ctx, idx, segment_idx);
+	FAIL_IF(!segment, "invalid segment index");
+	*score = segment->public_score();
+	return 1;
+}
+
 void chromaprint_dealloc(void *ptr)
 {
 	free(ptr);
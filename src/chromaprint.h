@@ -82,6 +82,12 @@ typedef struct ChromaprintContextPrivate ChromaprintContext;
 struct ChromaprintMatcherContextPrivate;
 typedef struct ChromaprintMatcherContextPrivate ChromaprintMatcherContext;
 
+struct ChromaprintIndexContextPrivate;
+typedef struct ChromaprintIndexContextPrivate ChromaprintIndexContext;
+
+struct ChromaprintSearcherContextPrivate;
+typedef struct ChromaprintSearcherContextPrivate ChromaprintSearcherContext;
+
 #define CHROMAPRINT_VERSION_MAJOR 1
 #define CHROMAPRINT_VERSION_MINOR 5
 #define CHROMAPRINT_VERSION_PATCH 0
@@ -95,6 +101,17 @@ enum ChromaprintAlgorithm {
 	CHROMAPRINT_ALGORITHM_DEFAULT = CHROMAPRINT_ALGORITHM_TEST2,
 };
 
+enum ChromaprintStage {
+	CHROMAPRINT_STAGE_AUDIO_PROCESSOR = 0,         // downmixing and resampling
+	CHROMAPRINT_STAGE_FFT,
+	CHROMAPRINT_STAGE_CHROMA,
+	CHROMAPRINT_STAGE_CHROMA_FILTER,
+	CHROMAPRINT_STAGE_CHROMA_NORMALIZER,
+	CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR,
+	CHROMAPRINT_STAGE_COMPRESSOR,
+	CHROMAPRINT_NUM_STAGES,
+};
+
 /**
  * Return the version number of Chromaprint.
  */
@@ -214,9 +231,22 @@ CHROMAPRINT_API int chromaprint_get_delay_ms(ChromaprintContext *ctx);
 /**
  * Restart the computation of a fingerprint with a new audio stream.
  *
+ * Audio with any number of channels is accepted and downmixed to mono.
+ * Streams with 6 or 8 channels are assumed to be 5.1 or 7.1 in the WAVE
+ * channel order (FL, FR, FC, LFE, BL, BR, SL, SR). The LFE channel is
+ * ignored and the center and surround channels are mixed at -3 dB, which
+ * gives the weights 0.485 (FL, FR) and 0.343 (FC, BL, BR) for 5.1, and
+ * 0.361 (FL, FR) and 0.255 (FC, BL, BR, SL, SR) for 7.1. All the channels
+ * of other streams are averaged with equal weights.
+ *
+ * @note Fingerprints of 6 and 8 channel streams are different from the ones
+ *       calculated by version 1.5 and older, which averaged all channels
+ *       including the LFE.
+ *
  * @param[in] ctx Chromaprint context pointer
  * @param[in] sample_rate sample rate of the audio stream (in Hz)
- * @param[in] num_channels numbers of channels in the audio stream (1 or 2)
+ * @param[in] num_channels numbers of channels in the audio stream (1 or more,
+ *          see above for how they are downmixed)
  *
  * @return 0 on error, 1 on success
  */
@@ -226,14 +256,63 @@ CHROMAPRINT_API int chromaprint_start(ChromaprintContext *ctx, int sample_rate,
  * Send audio data to the fingerprint calculator.
  *
  * @param[in] ctx Chromaprint context pointer
- * @param[in] data raw audio data, should point to an array of 16-bit signed
- *          integers in native byte-order
+ * @param[in] data raw audio data, should point to an array of interleaved
+ *          16-bit signed integers in native byte-order, with the number of
+ *          channels passed to chromaprint_start()
  * @param[in] size size of the data buffer (in samples)
  *
  * @return 0 on error, 1 on success
  */
 CHROMAPRINT_API int chromaprint_feed(ChromaprintContext *ctx, const int16_t *data, int size);
 
+/**
+ * Send planar audio data to the fingerprint calculator.
+ *
+ * This is the same as chromaprint_feed(), but each channel is in a separate
+ * array, like in the frames decoded by FFmpeg in the planar 16-bit format,
+ * so the data doesn't have to be interleaved first.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data array of pointers to the audio data of each channel
+ *          passed to chromaprint_start()
+ * @param[in] size number of samples in each channel
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_feed_planar(ChromaprintContext *ctx, const int16_t *const *data, int size);
+
+/**
+ * Send audio data in the float format to the fingerprint calculator.
+ *
+ * The samples are downmixed and converted to the internal format in one
+ * pass, so there is no need to convert float audio before feeding it.
+ * Samples outside of the [-1, 1] range are clipped.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data raw audio data, should point to an array of interleaved
+ *          32-bit floats in the [-1, 1] range
+ * @param[in] size size of the data buffer (in samples)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_feed_float(ChromaprintContext *ctx, const float *data, int size);
+
+/**
+ * Send planar audio data in the float format to the fingerprint calculator.
+ *
+ * This is the same as chromaprint_feed_float(), but each channel is in
+ * a separate array, like in the frames decoded by FFmpeg in the planar
+ * float format.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data array of pointers to the audio data of each channel
+ *          passed to chromaprint_start()
+ * @param[in] size number of samples in each channel
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_feed_planar_float(ChromaprintContext *ctx, const float *const *data, int size);
+
 /**
  * Process any remaining buffered audio data.
  *
@@ -243,6 +322,66 @@ CHROMAPRINT_API int chromaprint_feed(ChromaprintContext *ctx, const int16_t *dat
  */
 CHROMAPRINT_API int chromaprint_finish(ChromaprintContext *ctx);
 
+/**
+ * Calculate the fingerprint of a complete audio stream, using multiple threads.
+ *
+ * This is equivalent to calling chromaprint_start(), chromaprint_feed() with
+ * all the data and chromaprint_finish(), and it produces exactly the same
+ * fingerprint, but the audio is split into segments that are processed in
+ * parallel. This is useful for long recordings that are already in memory.
+ * The fingerprint can be retrieved as usual afterwards.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] sample_rate sample rate of the audio stream (in Hz)
+ * @param[in] num_channels numbers of channels in the audio stream (1 or more,
+ *          downmixed the same way as in chromaprint_start())
+ * @param[in] data raw audio data, should point to an array of interleaved
+ *          16-bit signed integers in native byte-order
+ * @param[in] size size of the data buffer (in samples)
+ * @param[in] num_threads maximum number of threads to use, 0 means one per CPU core
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_process_parallel(ChromaprintContext *ctx, int sample_rate, int num_channels, const int16_t *data, int size, int num_threads);
+
+/**
+ * Save the state of the fingerprint calculation.
+ *
+ * The state contains the buffered audio data and the fingerprint calculated
+ * so far, so the calculation can be continued in another context, even in
+ * another process, with chromaprint_restore_state(), without processing the
+ * audio data again. The state can only be restored by the same version of
+ * the library on the same platform.
+ *
+ * This can only be called after chromaprint_start().
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[out] data pointer to a pointer, where the address of the state will
+ *          be stored, the memory must be freed with chromaprint_dealloc()
+ * @param[out] size size of the state (in bytes)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_save_state(ChromaprintContext *ctx, void **data, int *size);
+
+/**
+ * Restore the state of the fingerprint calculation saved by
+ * chromaprint_save_state().
+ *
+ * The context must have been created with the same algorithm as the one the
+ * state was saved from. This replaces chromaprint_start(), continue by
+ * calling chromaprint_feed() with the audio data that follows the saved
+ * state. If it fails, the fingerprint calculated so far is cleared and
+ * chromaprint_start() must be called before the context can be used again.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] data pointer to the saved state
+ * @param[in] size size of the saved state (in bytes)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_restore_state(ChromaprintContext *ctx, const void *data, int size);
+
 /**
  * Return the calculated fingerprint as a compressed string.
  *
@@ -272,6 +411,43 @@ CHROMAPRINT_API int chromaprint_get_fingerprint(ChromaprintContext *ctx, char **
  */
 CHROMAPRINT_API int chromaprint_get_raw_fingerprint(ChromaprintContext *ctx, uint32_t **fingerprint, int *size);
 
+/**
+ * Copy the calculated fingerprint into a buffer provided by the caller.
+ *
+ * This is the same as chromaprint_get_raw_fingerprint(), but without
+ * allocating memory for the result, so the same buffer can be reused for
+ * many fingerprints. If the buffer is too small, nothing is copied, but the
+ * size of the fingerprint is still returned, so that the caller can resize
+ * the buffer and try again.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[out] fingerprint pointer to an array of at least capacity items,
+ *                 it can be NULL if capacity is 0
+ * @param[in] capacity number of items the array can hold
+ * @param[out] size number of items in the raw fingerprint
+ *
+ * @return 0 on error or if the buffer is too small, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_get_raw_fingerprint_into(ChromaprintContext *ctx, uint32_t *fingerprint, int capacity, int *size);
+
+/**
+ * Return a pointer to the calculated fingerprint, without copying it.
+ *
+ * The returned pointer points to the internal buffer, it must not be freed
+ * and it is only valid until the next call to chromaprint_feed() (or its
+ * other variants), chromaprint_finish(), chromaprint_start(),
+ * chromaprint_process_parallel(), chromaprint_restore_state() or
+ * chromaprint_clear_fingerprint().
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[out] fingerprint pointer to a pointer, where a pointer to the raw
+ *                 fingerprint will be stored
+ * @param[out] size number of items in the raw fingerprint
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_borrow_raw_fingerprint(ChromaprintContext *ctx, const uint32_t **fingerprint, int *size);
+
 /**
  * Return the length of the current raw fingerprint.
  *
@@ -282,6 +458,54 @@ CHROMAPRINT_API int chromaprint_get_raw_fingerprint(ChromaprintContext *ctx, uin
  */
 CHROMAPRINT_API int chromaprint_get_raw_fingerprint_size(ChromaprintContext *ctx, int *size);
 
+/**
+ * Return the items of the raw fingerprint that were calculated since the
+ * last call to this function.
+ *
+ * This is useful for processing long streams, where you want to handle
+ * the fingerprint incrementally, without copying the whole fingerprint
+ * after each chromaprint_feed() call. The returned pointer points to the
+ * internal buffer, it must not be freed and it is only valid until the next
+ * call to chromaprint_feed() (or its float variants), chromaprint_finish(),
+ * chromaprint_start() or chromaprint_clear_fingerprint().
+ *
+ * You can call chromaprint_clear_fingerprint() after processing the new
+ * items to keep the memory usage constant.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[out] fingerprint pointer to a pointer, where a pointer to the new items
+ *                 will be stored
+ * @param[out] size number of new items
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_get_new_raw_fingerprint(ChromaprintContext *ctx, const uint32_t **fingerprint, int *size);
+
+/**
+ * Callback for receiving new items of the raw fingerprint.
+ *
+ * @param user_data pointer passed to chromaprint_set_raw_fingerprint_callback()
+ * @param fingerprint pointer to the new items, only valid during the callback
+ * @param size number of new items
+ */
+typedef void (*ChromaprintRawFingerprintCallback)(void *user_data, const uint32_t *fingerprint, int size);
+
+/**
+ * Set a callback which is called with new items of the raw fingerprint at
+ * the end of chromaprint_feed() and its float variants, chromaprint_finish()
+ * and chromaprint_process_parallel().
+ *
+ * The callback receives the same items as chromaprint_get_new_raw_fingerprint()
+ * would return, so you should use only one of these two functions.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] callback callback function, or NULL to disable the callback
+ * @param[in] user_data pointer passed to the callback
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_set_raw_fingerprint_callback(ChromaprintContext *ctx, ChromaprintRawFingerprintCallback callback, void *user_data);
+
 /**
  * Return 32-bit hash of the calculated fingerprint.
  *
@@ -307,6 +531,47 @@ CHROMAPRINT_API int chromaprint_get_fingerprint_hash(ChromaprintContext *ctx, ui
  */
 CHROMAPRINT_API int chromaprint_clear_fingerprint(ChromaprintContext *ctx);
 
+/**
+ * Return statistics about one stage of the fingerprinting pipeline.
+ *
+ * The statistics are only collected if the library was built with the
+ * USE_STATS option, otherwise this function always fails. The values are
+ * cumulative over the lifetime of the context, or since the last call to
+ * chromaprint_reset_stats(). The time of each stage does not include the
+ * time spent in the stages it passed its output to.
+ *
+ * The count is the number of items the stage processed. That is the number
+ * of samples per channel for the audio processor, the number of samples for
+ * the FFT, the number of frames for the chroma stages and the fingerprint
+ * calculator, and the number of fingerprint items for the compressor.
+ *
+ * @param[in] ctx Chromaprint context pointer
+ * @param[in] stage one of the CHROMAPRINT_STAGE_XXX constants
+ * @param[out] time_ns total time spent in the stage, in nanoseconds
+ * @param[out] count total number of items processed by the stage
+ *
+ * @return 0 on error (including builds without statistics), 1 on success
+ */
+CHROMAPRINT_API int chromaprint_get_stats(ChromaprintContext *ctx, int stage, uint64_t *time_ns, uint64_t *count);
+
+/**
+ * Reset the statistics returned by chromaprint_get_stats().
+ *
+ * @param[in] ctx Chromaprint context pointer
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_reset_stats(ChromaprintContext *ctx);
+
+/**
+ * Return a short name of a stage of the fingerprinting pipeline, e.g. "fft".
+ *
+ * @param[in] stage one of the CHROMAPRINT_STAGE_XXX constants
+ *
+ * @return the name, or NULL if the stage is not valid
+ */
+CHROMAPRINT_API const char *chromaprint_get_stage_name(int stage);
+
 /**
  * Compress and optionally base64-encode a raw fingerprint
  *
@@ -373,6 +638,306 @@ CHROMAPRINT_API int chromaprint_decode_fingerprint(const char *encoded_fp, int e
  */
 CHROMAPRINT_API int chromaprint_hash_fingerprint(const uint32_t *fp, int size, uint32_t *hash);
 
+/**
+ * Allocate and initialize the fingerprint matcher context.
+ *
+ * The matcher context keeps its internal buffers between runs, so a single
+ * long-lived context can be used to compare many pairs of fingerprints
+ * without allocating memory for each comparison.
+ *
+ * @return ctx Chromaprint matcher context pointer
+ */
+CHROMAPRINT_API ChromaprintMatcherContext *chromaprint_matcher_new(void);
+
+/**
+ * Deallocate the fingerprint matcher context.
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ */
+CHROMAPRINT_API void chromaprint_matcher_free(ChromaprintMatcherContext *ctx);
+
+/**
+ * Set one of the two raw fingerprints to be compared.
+ *
+ * Both fingerprints must be generated by the same algorithm.
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ * @param[in] idx index of the fingerprint, 0 or 1
+ * @param[in] fp pointer to an array of 32-bit integers representing the raw
+ *        fingerprint
+ * @param[in] size number of items in the raw fingerprint
+ * @param[in] algorithm Chromaprint algorithm version which was used to generate
+ *        the raw fingerprint
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_set_fingerprint(ChromaprintMatcherContext *ctx, int idx, const uint32_t *fp, int size, int algorithm);
+
+/**
+ * Set one of the two encoded fingerprints to be compared.
+ *
+ * The fingerprint is decoded into the context's internal buffers, the
+ * algorithm is read from the encoded data.
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ * @param[in] idx index of the fingerprint, 0 or 1
+ * @param[in] fp pointer to an encoded fingerprint
+ * @param[in] size size of the encoded fingerprint in bytes
+ * @param[in] base64 Whether the fp parameter contains binary data or
+ *            base64-encoded ASCII data.
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_set_encoded_fingerprint(ChromaprintMatcherContext *ctx, int idx, const char *fp, int size, int base64);
+
+/**
+ * Compare the two fingerprints and find matching segments.
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_run(ChromaprintMatcherContext *ctx);
+
+/**
+ * Return the number of matching segments found by the last call to
+ * chromaprint_matcher_run().
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ * @param[out] num number of segments
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_num_segments(ChromaprintMatcherContext *ctx, int *num);
+
+/**
+ * Return the position of a matching segment in both fingerprints.
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ * @param[in] idx index of the segment
+ * @param[out] pos1 position of the segment in the first fingerprint (in items)
+ * @param[out] pos2 position of the segment in the second fingerprint (in items)
+ * @param[out] duration duration of the segment (in items)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_segment_position(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration);
+
+/**
+ * Return the position of a matching segment in both fingerprints.
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ * @param[in] idx index of the segment
+ * @param[out] pos1 position of the segment in the first fingerprint (in milliseconds)
+ * @param[out] pos2 position of the segment in the second fingerprint (in milliseconds)
+ * @param[out] duration duration of the segment (in milliseconds)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_segment_position_ms(ChromaprintMatcherContext *ctx, int idx, int *pos1, int *pos2, int *duration);
+
+/**
+ * Return the score of a matching segment.
+ *
+ * The score is the average number of different bits between the aligned
+ * items, multiplied by 100, so lower values mean better matches.
+ *
+ * @param[in] ctx Chromaprint matcher context pointer
+ * @param[in] idx index of the segment
+ * @param[out] score score of the segment
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_matcher_get_segment_score(ChromaprintMatcherContext *ctx, int idx, int *score);
+
+/**
+ * Allocate and initialize a fingerprint index.
+ *
+ * The index is used to search a catalogue of raw fingerprints for the ones
+ * that match a query, see chromaprint_searcher_new(). All fingerprints in
+ * the index must be generated by the same algorithm.
+ *
+ * @param[in] algorithm Chromaprint algorithm version which was used to
+ *        generate the indexed fingerprints
+ *
+ * @return ctx Chromaprint index context pointer, NULL if the algorithm is
+ *         not supported
+ */
+CHROMAPRINT_API ChromaprintIndexContext *chromaprint_index_new(int algorithm);
+
+/**
+ * Deallocate the fingerprint index.
+ *
+ * All searchers using the index must be deallocated first.
+ *
+ * @param[in] ctx Chromaprint index context pointer
+ */
+CHROMAPRINT_API void chromaprint_index_free(ChromaprintIndexContext *ctx);
+
+/**
+ * Add a raw fingerprint to the index.
+ *
+ * The fingerprint is copied. It can't be found until chromaprint_index_build()
+ * is called.
+ *
+ * @param[in] ctx Chromaprint index context pointer
+ * @param[in] id ID of the fingerprint, returned by the searcher
+ * @param[in] fp pointer to an array of 32-bit integers representing the raw
+ *        fingerprint
+ * @param[in] size number of items in the raw fingerprint
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_index_add_fingerprint(ChromaprintIndexContext *ctx, uint32_t id, const uint32_t *fp, int size);
+
+/**
+ * Make all fingerprints added so far searchable.
+ *
+ * @param[in] ctx Chromaprint index context pointer
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_index_build(ChromaprintIndexContext *ctx);
+
+/**
+ * Write the built index to a file.
+ *
+ * @param[in] ctx Chromaprint index context pointer
+ * @param[in] file_name name of the file
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_index_save(ChromaprintIndexContext *ctx, const char *file_name);
+
+/**
+ * Replace the contents of the index with an index file written by
+ * chromaprint_index_save().
+ *
+ * The file is mapped into memory and used directly, so opening takes the
+ * same time regardless of the size of the index. The file must have been
+ * written from fingerprints of the algorithm the index was created with.
+ *
+ * @param[in] ctx Chromaprint index context pointer
+ * @param[in] file_name name of the file
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_index_open(ChromaprintIndexContext *ctx, const char *file_name);
+
+/**
+ * Return the number of searchable fingerprints in the index.
+ *
+ * @param[in] ctx Chromaprint index context pointer
+ * @param[out] num number of fingerprints
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_index_get_num_fingerprints(ChromaprintIndexContext *ctx, int *num);
+
+/**
+ * Allocate and initialize a searcher over a fingerprint index.
+ *
+ * The searcher finds candidate fingerprints that share hashes with the
+ * query and compares each of them with the query, the same way as
+ * chromaprint_matcher_run() does. It keeps its internal buffers between
+ * searches. A searcher must only be used by one thread at a time, but
+ * any number of searchers can share the same index, as long as it is not
+ * modified. The index must not be deallocated before the searcher.
+ *
+ * @param[in] index Chromaprint index context pointer
+ *
+ * @return ctx Chromaprint searcher context pointer
+ */
+CHROMAPRINT_API ChromaprintSearcherContext *chromaprint_searcher_new(ChromaprintIndexContext *index);
+
+/**
+ * Deallocate the searcher.
+ *
+ * @param[in] ctx Chromaprint searcher context pointer
+ */
+CHROMAPRINT_API void chromaprint_searcher_free(ChromaprintSearcherContext *ctx);
+
+/**
+ * Set the number of best candidates that are compared with the query.
+ *
+ * @param[in] ctx Chromaprint searcher context pointer
+ * @param[in] num number of candidates (default 10)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_searcher_set_max_candidates(ChromaprintSearcherContext *ctx, int num);
+
+/**
+ * Search the index for fingerprints matching the query.
+ *
+ * Only candidates with at least one matching segment are returned, ordered
+ * by the number of hashes they share with the query.
+ *
+ * @param[in] ctx Chromaprint searcher context pointer
+ * @param[in] fp pointer to an array of 32-bit integers representing the raw
+ *        query fingerprint
+ * @param[in] size number of items in the raw fingerprint
+ * @param[out] num_results number of matching fingerprints
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_searcher_search(ChromaprintSearcherContext *ctx, const uint32_t *fp, int size, int *num_results);
+
+/**
+ * Return a fingerprint found by the last call to chromaprint_searcher_search().
+ *
+ * @param[in] ctx Chromaprint searcher context pointer
+ * @param[in] idx index of the result
+ * @param[out] id ID of the fingerprint, as passed to chromaprint_index_add_fingerprint()
+ * @param[out] num_segments number of matching segments
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_searcher_get_result(ChromaprintSearcherContext *ctx, int idx, uint32_t *id, int *num_segments);
+
+/**
+ * Return the position of a matching segment in the query and in the found
+ * fingerprint.
+ *
+ * @param[in] ctx Chromaprint searcher context pointer
+ * @param[in] idx index of the result
+ * @param[in] segment_idx index of the segment
+ * @param[out] pos1 position of the segment in the query (in items)
+ * @param[out] pos2 position of the segment in the found fingerprint (in items)
+ * @param[out] duration duration of the segment (in items)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_searcher_get_segment_position(ChromaprintSearcherContext *ctx, int idx, int segment_idx, int *pos1, int *pos2, int *duration);
+
+/**
+ * Return the position of a matching segment in the query and in the found
+ * fingerprint.
+ *
+ * @param[in] ctx Chromaprint searcher context pointer
+ * @param[in] idx index of the result
+ * @param[in] segment_idx index of the segment
+ * @param[out] pos1 position of the segment in the query (in milliseconds)
+ * @param[out] pos2 position of the segment in the found fingerprint (in milliseconds)
+ * @param[out] duration duration of the segment (in milliseconds)
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_searcher_get_segment_position_ms(ChromaprintSearcherContext *ctx, int idx, int segment_idx, int *pos1, int *pos2, int *duration);
+
+/**
+ * Return the score of a matching segment, same as
+ * chromaprint_matcher_get_segment_score().
+ *
+ * @param[in] ctx Chromaprint searcher context pointer
+ * @param[in] idx index of the result
+ * @param[in] segment_idx index of the segment
+ * @param[out] score score of the segment
+ *
+ * @return 0 on error, 1 on success
+ */
+CHROMAPRINT_API int chromaprint_searcher_get_segment_score(ChromaprintSearcherContext *ctx, int idx, int segment_idx, int *score);
+
 /**
  * Free memory allocated by any function from the Chromaprint API.
  *
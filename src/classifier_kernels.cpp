@@ -0,0 +1,115 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <cmath>
+#include "classifier_kernels.h"
+#include "classifier_tables.h"
+#include "classifier.h"
+#include "filter_utils.h"
+
+namespace chromaprint {
+
+namespace {
+
+// SubtractLog() without the log.
+inline double Ratio(double a, double b) {
+	return (1.0 + a) / (1.0 + b);
+}
+
+template <int Type, int Y, int Height, int Width>
+inline double ApplyFilter(const ChromaIntegralImage &image, size_t x) {
+	switch (Type) {
+		case 0:
+			return Filter0(image, x, Y, Width, Height, Ratio);
+		case 1:
+			return Filter1(image, x, Y, Width, Height, Ratio);
+		case 2:
+			return Filter2(image, x, Y, Width, Height, Ratio);
+		case 3:
+			return Filter3(image, x, Y, Width, Height, Ratio);
+		case 4:
+			return Filter4(image, x, Y, Width, Height, Ratio);
+		case 5:
+			return Filter5(image, x, Y, Width, Height, Ratio);
+	}
+	return 1.0;
+}
+
+struct Thresholds {
+	Quantizer quantizer;
+	double exp_t0;
+	double exp_t1;
+	double exp_t2;
+};
+
+// Same as quantizer.Quantize(log(ratio)).
+inline int QuantizeRatio(double ratio, const Thresholds &t) {
+	const int value = (ratio >= t.exp_t0) + (ratio >= t.exp_t1) + (ratio >= t.exp_t2);
+	// log() and exp() are not exact, so very close to a threshold the
+	// comparison could go the other way, use the log there to be sure
+	const double eps = ratio * 1e-9;
+	const bool near = (std::fabs(ratio - t.exp_t0) < eps) | (std::fabs(ratio - t.exp_t1) < eps) | (std::fabs(ratio - t.exp_t2) < eps);
+	if (near) {
+		return t.quantizer.Quantize(std::log(ratio));
+	}
+	return value;
+}
+
+#define CHROMAPRINT_THRESHOLDS(type, y, height, width, t0, t1, t2) \
+	{ Quantizer(t0, t1, t2), std::exp(t0), std::exp(t1), std::exp(t2) },
+
+#define CHROMAPRINT_CLASSIFY(type, y, height, width, t0, t1, t2) \
+	bits = (bits << 2) | GrayCode(QuantizeRatio(ApplyFilter<type, y, height, width>(image, offset), *thresholds++));
+
+#define CHROMAPRINT_MATCH_CLASSIFIER(type, y, height, width, t0, t1, t2) \
+	&& MatchClassifier(*classifiers++, type, y, height, width, t0, t1, t2)
+
+bool MatchClassifier(const Classifier &c, int type, int y, int height, int width, double t0, double t1, double t2) {
+	return c.filter().type() == type && c.filter().y() == y &&
+		c.filter().height() == height && c.filter().width() == width &&
+		c.quantizer().t0() == t0 && c.quantizer().t1() == t1 && c.quantizer().t2() == t2;
+}
+
+const Thresholds kThresholdsTest1[] = {
+	CHROMAPRINT_CLASSIFIERS_TEST1(CHROMAPRINT_THRESHOLDS)
+};
+
+uint32_t CalculateSubfingerprintTest1(const ChromaIntegralImage &image, size_t offset) {
+	const Thresholds *thresholds = kThresholdsTest1;
+	uint32_t bits = 0;
+	CHROMAPRINT_CLASSIFIERS_TEST1(CHROMAPRINT_CLASSIFY)
+	return bits;
+}
+
+bool IsClassifierSetTest1(const Classifier *classifiers, size_t num_classifiers) {
+	return num_classifiers == 16 CHROMAPRINT_CLASSIFIERS_TEST1(CHROMAPRINT_MATCH_CLASSIFIER);
+}
+
+const Thresholds kThresholdsTest2[] = {
+	CHROMAPRINT_CLASSIFIERS_TEST2(CHROMAPRINT_THRESHOLDS)
+};
+
+uint32_t CalculateSubfingerprintTest2(const ChromaIntegralImage &image, size_t offset) {
+	const Thresholds *thresholds = kThresholdsTest2;
+	uint32_t bits = 0;
+	CHROMAPRINT_CLASSIFIERS_TEST2(CHROMAPRINT_CLASSIFY)
+	return bits;
+}
+
+bool IsClassifierSetTest2(const Classifier *classifiers, size_t num_classifiers) {
+	return num_classifiers == 16 CHROMAPRINT_CLASSIFIERS_TEST2(CHROMAPRINT_MATCH_CLASSIFIER);
+}
+
+};
+
+SubfingerprintKernel GetSubfingerprintKernel(const Classifier *classifiers, size_t num_classifiers) {
+	if (IsClassifierSetTest1(classifiers, num_classifiers)) {
+		return CalculateSubfingerprintTest1;
+	}
+	if (IsClassifierSetTest2(classifiers, num_classifiers)) {
+		return CalculateSubfingerprintTest2;
+	}
+	return nullptr;
+}
+
+}; // namespace chromaprint
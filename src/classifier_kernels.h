@@ -0,0 +1,30 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_CLASSIFIER_KERNELS_H_
+#define CHROMAPRINT_CLASSIFIER_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "utils/rolling_integral_image.h"
+
+namespace chromaprint {
+
+class Classifier;
+
+typedef FixedRollingIntegralImage<double, 12> ChromaIntegralImage;
+
+//! Calculate one subfingerprint from the image rows starting at offset.
+typedef uint32_t (*SubfingerprintKernel)(const ChromaIntegralImage &image, size_t offset);
+
+//! Get a kernel specialized for one of the built-in classifier sets.
+//
+// The kernels have the filter geometry compiled in and compare the filter
+// ratios with exp-transformed thresholds instead of taking the log. They
+// return the same bits as classifying with the Classifier objects. Returns
+// nullptr if the classifiers are not one of the built-in sets.
+SubfingerprintKernel GetSubfingerprintKernel(const Classifier *classifiers, size_t num_classifiers);
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,65 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "classifier_kernels.h"
+#include "classifier.h"
+#include "fingerprinter_configuration.h"
+#include "utils.h"
+
+namespace chromaprint {
+
+namespace {
+
+uint32_t CalculateSubfingerprint(const Classifier *classifiers, size_t num_classifiers, const ChromaIntegralImage &image, size_t offset) {
+	uint32_t bits = 0;
+	for (size_t i = 0; i < num_classifiers; i++) {
+		bits = (bits << 2) | GrayCode(classifiers[i].Classify(image, offset));
+	}
+	return bits;
+}
+
+void CheckKernel(const FingerprinterConfiguration &config) {
+	const auto kernel = GetSubfingerprintKernel(config.classifiers(), config.num_classifiers());
+	ASSERT_TRUE(kernel != nullptr);
+
+	const size_t width = config.max_filter_width();
+	ChromaIntegralImage image(width);
+	uint32_t seed = 1;
+	for (size_t i = 0; i < 2000; i++) {
+		// features like the ones coming from ChromaNormalizer, often with some zeros
+		std::vector<double> row(12);
+		for (auto &x : row) {
+			seed = seed * 1103515245 + 12345;
+			x = (seed >> 16) % 4 == 0 ? 0.0 : ((seed >> 8) % 1000) / 1000.0;
+		}
+		image.AddRow(row);
+		if (image.num_rows() >= width) {
+			const size_t offset = image.num_rows() - width;
+			ASSERT_EQ(CalculateSubfingerprint(config.classifiers(), config.num_classifiers(), image, offset), kernel(image, offset)) << "row " << i;
+		}
+	}
+}
+
+};
+
+TEST(ClassifierKernelsTest, Test1) {
+	CheckKernel(FingerprinterConfigurationTest1());
+}
+
+TEST(ClassifierKernelsTest, Test2) {
+	CheckKernel(FingerprinterConfigurationTest2());
+	CheckKernel(FingerprinterConfigurationTest3());
+}
+
+TEST(ClassifierKernelsTest, Unknown) {
+	FingerprinterConfigurationTest2 config;
+	std::vector<Classifier> classifiers(config.classifiers(), config.classifiers() + config.num_classifiers());
+	ASSERT_TRUE(GetSubfingerprintKernel(classifiers.data(), classifiers.size()) != nullptr);
+	ASSERT_TRUE(GetSubfingerprintKernel(classifiers.data(), classifiers.size() - 1) == nullptr);
+	classifiers[3] = Classifier(Filter(3, 8, 2, 12), Quantizer(-0.105439, 0.0153946, 0.1359));
+	ASSERT_TRUE(GetSubfingerprintKernel(classifiers.data(), classifiers.size()) == nullptr);
+}
+
+}; // namespace chromaprint
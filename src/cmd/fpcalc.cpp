@@ -1,8 +1,15 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cstdarg>
 #include <sstream>
 #include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <chromaprint.h>
 #include "audio/ffmpeg_audio_reader.h"
 #include "utils/scope_exit.h"
@@ -30,6 +37,7 @@ static bool g_raw = false;
 static bool g_signed = false;
 static bool g_abs_ts = false;
 static bool g_ignore_errors = false;
+static int g_jobs = 1;
 static ChromaprintAlgorithm g_algorithm = CHROMAPRINT_ALGORITHM_DEFAULT;
 
 
@@ -52,6 +60,8 @@ const char *g_help =
 	"  -json          Print the output in JSON format\n"
 	"  -text          Print the output in text format\n"
 	"  -plain         Print the just the fingerprint in text format\n"
+	"  -jobs NUM      Process NUM files in parallel (default 1, 0 means the number of CPU cores),\n"
+	"                 the results are still printed in the order of the input files\n"
 	"  -version       Print version information\n"
 	;
 
@@ -109,6 +119,17 @@ static void ParseOptions(int &argc, char **argv) {
                 exit(2);
             }
             i++;
+		} else if (!strcmp(argv[i], "-jobs") && i + 1 < argc) {
+			auto value = atoi(argv[i + 1]);
+			if (value > 0) {
+				g_jobs = value;
+			} else if (value == 0 && !strcmp(argv[i + 1], "0")) {
+				g_jobs = std::max(1u, std::thread::hardware_concurrency());
+			} else {
+				fprintf(stderr, "ERROR: The argument for %s must be a positive number\n", argv[i]);
+				exit(2);
+			}
+			i++;
 		} else if (!strcmp(argv[i], "-text")) {
 			g_format = TEXT;
 		} else if (!strcmp(argv[i], "-json")) {
@@ -153,33 +174,82 @@ static void ParseOptions(int &argc, char **argv) {
 	argc = j;
 }
 
-void PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first, double timestamp, double duration) {
+// Output of one input file. When processing files in parallel, the output is
+// kept in memory until all the previous files are printed.
+class Output {
+public:
+	Output(bool buffered) : m_buffered(buffered) {}
+
+	void Print(FILE *stream, const char *format, ...) {
+		va_list args;
+		va_start(args, format);
+		if (m_buffered) {
+			va_list args2;
+			va_copy(args2, args);
+			const int size = vsnprintf(nullptr, 0, format, args2);
+			va_end(args2);
+			if (size > 0) {
+				if (m_chunks.empty() || m_chunks.back().first != stream) {
+					m_chunks.emplace_back(stream, std::string());
+				}
+				auto &chunk = m_chunks.back().second;
+				const auto offset = chunk.size();
+				chunk.resize(offset + size + 1);
+				vsnprintf(&chunk[offset], size + 1, format, args);
+				chunk.resize(offset + size);
+			}
+		} else {
+			vfprintf(stream, format, args);
+		}
+		va_end(args);
+	}
+
+	void Flush() {
+		for (const auto &chunk : m_chunks) {
+			fputs(chunk.second.c_str(), chunk.first);
+		}
+		m_chunks.clear();
+		fflush(stdout);
+	}
+
+	// Buffered output must only be flushed in the order of the input files.
+	void FlushIfUnbuffered() {
+		if (!m_buffered) {
+			fflush(stdout);
+		}
+	}
+
+private:
+	bool m_buffered;
+	std::vector<std::pair<FILE *, std::string>> m_chunks;
+};
+
+int PrintResult(Output &out, ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first, double timestamp, double duration) {
 	std::string tmp_fp;
 	const char *fp;
 	bool dealloc_fp = false;
 
 	int size;
 	if (!chromaprint_get_raw_fingerprint_size(ctx, &size)) {
-		fprintf(stderr, "ERROR: Could not get the fingerprinting size\n");
-		exit(2);
+		out.Print(stderr, "ERROR: Could not get the fingerprinting size\n");
+		return 2;
 	}
 	if (size <= 0) {
 		if (first) {
-			fprintf(stderr, "ERROR: Empty fingerprint\n");
-			exit(2);
+			out.Print(stderr, "ERROR: Empty fingerprint\n");
+			return 2;
 		}
-		return;
+		return 0;
 	}
 
 	if (g_raw) {
 		std::stringstream ss;
-		uint32_t *raw_fp_data = nullptr;
+		const uint32_t *raw_fp_data = nullptr;
 		int raw_fp_size = 0;
-		if (!chromaprint_get_raw_fingerprint(ctx, &raw_fp_data, &raw_fp_size)) {
-			fprintf(stderr, "ERROR: Could not get the fingerprinting\n");
-			exit(2);
+		if (!chromaprint_borrow_raw_fingerprint(ctx, &raw_fp_data, &raw_fp_size)) {
+			out.Print(stderr, "ERROR: Could not get the fingerprinting\n");
+			return 2;
 		}
-		SCOPE_EXIT(chromaprint_dealloc(raw_fp_data));
 		for (int i = 0; i < raw_fp_size; i++) {
 			if (i > 0) {
 				ss << ',';
@@ -195,8 +265,8 @@ void PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first,
 	} else {
 		char *tmp_fp2;
 		if (!chromaprint_get_fingerprint(ctx, &tmp_fp2)) {
-			fprintf(stderr, "ERROR: Could not get the fingerprinting\n");
-			exit(2);
+			out.Print(stderr, "ERROR: Could not get the fingerprinting\n");
+			return 2;
 		}
 		fp = tmp_fp2;
 		dealloc_fp = true;
@@ -215,34 +285,35 @@ void PrintResult(ChromaprintContext *ctx, FFmpegAudioReader &reader, bool first,
 	switch (g_format) {
 		case TEXT:
 			if (!first) {
-				printf("\n");
+				out.Print(stdout, "\n");
 			}
 			if (g_abs_ts) {
-				printf("TIMESTAMP=%.2f\n", timestamp);
+				out.Print(stdout, "TIMESTAMP=%.2f\n", timestamp);
 			}
-			printf("DURATION=%d\nFINGERPRINT=%s\n", int(duration), fp);
+			out.Print(stdout, "DURATION=%d\nFINGERPRINT=%s\n", int(duration), fp);
 			break;
 		case JSON:
 			if (g_max_chunk_duration != 0) {
 				if (g_raw) {
-					printf("{\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": [%s]}\n", timestamp, duration, fp);
+					out.Print(stdout, "{\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": [%s]}\n", timestamp, duration, fp);
 				} else {
-					printf("{\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": \"%s\"}\n", timestamp, duration, fp);
+					out.Print(stdout, "{\"timestamp\": %.2f, \"duration\": %.2f, \"fingerprint\": \"%s\"}\n", timestamp, duration, fp);
 				}
 			} else {
 				if (g_raw) {
-					printf("{\"duration\": %.2f, \"fingerprint\": [%s]}\n", duration, fp);
+					out.Print(stdout, "{\"duration\": %.2f, \"fingerprint\": [%s]}\n", duration, fp);
 				} else {
-					printf("{\"duration\": %.2f, \"fingerprint\": \"%s\"}\n", duration, fp);
+					out.Print(stdout, "{\"duration\": %.2f, \"fingerprint\": \"%s\"}\n", duration, fp);
 				}
 			}
 			break;
 		case PLAIN:
-			printf("%s\n", fp);
+			out.Print(stdout, "%s\n", fp);
 			break;
 	}
 
-	fflush(stdout);
+	out.FlushIfUnbuffered();
+	return 0;
 }
 
 double GetCurrentTimestamp() {
@@ -251,7 +322,7 @@ double GetCurrentTimestamp() {
 	return usec.count() / 1000000.0;
 }
 
-void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char *file_name) {
+int ProcessFile(Output &out, ChromaprintContext *ctx, FFmpegAudioReader &reader, const char *file_name) {
 	double ts = 0.0;
 	if (g_abs_ts) {
 		ts = GetCurrentTimestamp();
@@ -262,13 +333,13 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 	}
 
 	if (!reader.Open(file_name)) {
-		fprintf(stderr, "ERROR: %s\n", reader.GetError().c_str());
-		exit(2);
+		out.Print(stderr, "ERROR: %s\n", reader.GetError().c_str());
+		return 2;
 	}
 
 	if (!chromaprint_start(ctx, reader.GetSampleRate(), reader.GetChannels())) {
-		fprintf(stderr, "ERROR: Could not initialize the fingerprinting process\n");
-		exit(2);
+		out.Print(stderr, "ERROR: Could not initialize the fingerprinting process\n");
+		return 2;
 	}
 
 	size_t stream_size = 0;
@@ -292,7 +363,7 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 		const int16_t *frame_data = nullptr;
 		size_t frame_size = 0;
 		if (!reader.Read(&frame_data, &frame_size)) {
-			fprintf(stderr, "ERROR: %s\n", reader.GetError().c_str());
+			out.Print(stderr, "ERROR: %s\n", reader.GetError().c_str());
 			read_failed = true;
 			break;
 		}
@@ -326,20 +397,23 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 		}
 
 		if (!chromaprint_feed(ctx, frame_data, first_part_size * reader.GetChannels())) {
-			fprintf(stderr, "ERROR: Could not process audio data\n");
-			exit(2);
+			out.Print(stderr, "ERROR: Could not process audio data\n");
+			return 2;
 		}
 
 		chunk_size += first_part_size;
 
 		if (chunk_done) {
 			if (!chromaprint_finish(ctx)) {
-				fprintf(stderr, "ERROR: Could not finish the fingerprinting process\n");
-				exit(2);
+				out.Print(stderr, "ERROR: Could not finish the fingerprinting process\n");
+				return 2;
 			}
 
 			const auto chunk_duration = (chunk_size - extra_chunk_limit) * 1.0 / reader.GetSampleRate() + overlap;
-			PrintResult(ctx, reader, first_chunk, ts, chunk_duration);
+			const int ret = PrintResult(out, ctx, reader, first_chunk, ts, chunk_duration);
+			if (ret) {
+				return ret;
+			}
 			got_results = true;
 
 			if (g_abs_ts) {
@@ -350,14 +424,14 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 
 			if (g_overlap) {
 				if (!chromaprint_clear_fingerprint(ctx)) {
-					fprintf(stderr, "ERROR: Could not initialize the fingerprinting process\n");
-					exit(2);
+					out.Print(stderr, "ERROR: Could not initialize the fingerprinting process\n");
+					return 2;
 				}
 				ts -= overlap;
 			} else {
 				if (!chromaprint_start(ctx, reader.GetSampleRate(), reader.GetChannels())) {
-					fprintf(stderr, "ERROR: Could not initialize the fingerprinting process\n");
-					exit(2);
+					out.Print(stderr, "ERROR: Could not initialize the fingerprinting process\n");
+					return 2;
 				}
 			}
 
@@ -374,8 +448,8 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 
 		if (frame_size > 0) {
 			if (!chromaprint_feed(ctx, frame_data, frame_size * reader.GetChannels())) {
-				fprintf(stderr, "ERROR: Could not process audio data\n");
-				exit(2);
+				out.Print(stderr, "ERROR: Could not process audio data\n");
+				return 2;
 			}
 		}
 
@@ -387,62 +461,171 @@ void ProcessFile(ChromaprintContext *ctx, FFmpegAudioReader &reader, const char
 	}
 
 	if (!chromaprint_finish(ctx)) {
-		fprintf(stderr, "ERROR: Could not finish the fingerprinting process\n");
-		exit(2);
+		out.Print(stderr, "ERROR: Could not finish the fingerprinting process\n");
+		return 2;
 	}
 
 	if (chunk_size > 0) {
 		const auto chunk_duration = (chunk_size - extra_chunk_limit) * 1.0 / reader.GetSampleRate() + overlap;
-		PrintResult(ctx, reader, first_chunk, ts, chunk_duration);
+		const int ret = PrintResult(out, ctx, reader, first_chunk, ts, chunk_duration);
+		if (ret) {
+			return ret;
+		}
 		got_results = true;
 	} else if (first_chunk) {
-		fprintf(stderr, "ERROR: Not enough audio data\n");
-		exit(2);
+		out.Print(stderr, "ERROR: Not enough audio data\n");
+		return 2;
 	}
 
 	if (!g_ignore_errors) {
 		if (read_failed) {
-			exit(got_results ? 3 : 2);
+			return got_results ? 3 : 2;
 		}
 	}
-}
 
-int fpcalc_main(int argc, char **argv) {
-	ParseOptions(argc, argv);
+	return 0;
+}
 
-	FFmpegAudioReader reader;
+bool SetupReader(FFmpegAudioReader &reader, ChromaprintContext *ctx) {
 	if (g_input_format) {
 		if (!reader.SetInputFormat(g_input_format)) {
 			fprintf(stderr, "ERROR: Invalid format\n");
-			return 2;
+			return false;
 		}
 	}
 	if (g_input_channels) {
 		if (!reader.SetInputChannels(g_input_channels)) {
 			fprintf(stderr, "ERROR: Invalid number of channels\n");
-			return 2;
+			return false;
 		}
 	}
 	if (g_input_sample_rate) {
 		if (!reader.SetInputSampleRate(g_input_sample_rate)) {
 			fprintf(stderr, "ERROR: Invalid sample rate\n");
-			return 2;
+			return false;
 		}
 	}
 
+	reader.SetOutputChannels(chromaprint_get_num_channels(ctx));
+	reader.SetOutputSampleRate(chromaprint_get_sample_rate(ctx));
+	return true;
+}
+
+int ProcessFiles(int num_files, char **file_names) {
 	ChromaprintContext *chromaprint_ctx = chromaprint_new(g_algorithm);
 	SCOPE_EXIT(chromaprint_free(chromaprint_ctx));
 
-	reader.SetOutputChannels(chromaprint_get_num_channels(chromaprint_ctx));
-	reader.SetOutputSampleRate(chromaprint_get_sample_rate(chromaprint_ctx));
+	FFmpegAudioReader reader;
+	if (!SetupReader(reader, chromaprint_ctx)) {
+		return 2;
+	}
 
-	for (int i = 1; i < argc; i++) {
-		ProcessFile(chromaprint_ctx, reader, argv[i]);
+	for (int i = 0; i < num_files; i++) {
+		Output out(false);
+		const int ret = ProcessFile(out, chromaprint_ctx, reader, file_names[i]);
+		if (ret) {
+			return ret;
+		}
 	}
 
 	return 0;
 }
 
+// Each worker thread has its own reader and context. The output of each file
+// is printed as soon as all the previous files are done, and processing stops
+// at the first failed file, so the result is the same as in ProcessFiles().
+int ProcessFilesInParallel(int num_files, char **file_names, int num_workers) {
+	struct Job {
+		Job() : output(true) {}
+		Output output;
+		int result = 0;
+		bool done = false;
+	};
+
+	// create the contexts here, because chromaprint_new() is not reentrant with FFTW
+	std::vector<ChromaprintContext *> contexts;
+	std::vector<std::unique_ptr<FFmpegAudioReader>> readers;
+	SCOPE_EXIT(for (auto ctx : contexts) { chromaprint_free(ctx); });
+	for (int i = 0; i < num_workers; i++) {
+		contexts.push_back(chromaprint_new(g_algorithm));
+		readers.emplace_back(new FFmpegAudioReader());
+		if (!SetupReader(*readers.back(), contexts.back())) {
+			return 2;
+		}
+	}
+
+	// limit the number of files whose output is waiting to be printed
+	const int max_pending_jobs = num_workers * 4;
+
+	std::vector<Job> jobs(num_files);
+	std::mutex mutex;
+	std::condition_variable cond;
+	int next_job = 0;
+	int next_output = 0;
+	bool stop = false;
+
+	auto worker = [&](int worker_id) {
+		while (true) {
+			int i;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cond.wait(lock, [&]() { return stop || next_job >= num_files || next_job < next_output + max_pending_jobs; });
+				if (stop || next_job >= num_files) {
+					return;
+				}
+				i = next_job++;
+			}
+			const int result = ProcessFile(jobs[i].output, contexts[worker_id], *readers[worker_id], file_names[i]);
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				jobs[i].result = result;
+				jobs[i].done = true;
+			}
+			cond.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < num_workers; i++) {
+		threads.emplace_back(worker, i);
+	}
+
+	int ret = 0;
+	for (int i = 0; i < num_files && ret == 0; i++) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [&]() { return jobs[i].done; });
+		}
+		jobs[i].output.Flush();
+		ret = jobs[i].result;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			next_output = i + 1;
+			if (ret) {
+				stop = true;
+			}
+		}
+		cond.notify_all();
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	return ret;
+}
+
+int fpcalc_main(int argc, char **argv) {
+	ParseOptions(argc, argv);
+
+	const int num_files = argc - 1;
+	const int num_workers = std::min(g_jobs, num_files);
+	if (num_workers > 1) {
+		return ProcessFilesInParallel(num_files, argv + 1, num_workers);
+	}
+	return ProcessFiles(num_files, argv + 1);
+}
+
 #ifdef _WIN32
 int main(int win32_argc, char **win32_argv)
 {
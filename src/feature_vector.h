@@ -0,0 +1,29 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FEATURE_VECTOR_H_
+#define CHROMAPRINT_FEATURE_VECTOR_H_
+
+#if defined(HAVE_CONFIG_H)
+#include <config.h>
+#endif
+
+#include <vector>
+
+namespace chromaprint {
+
+// Type used for the spectrum and the features computed from it. Building
+// with USE_FLOAT_FEATURES switches the whole feature pipeline to single
+// precision. The integral image used by the classifiers accumulates values
+// over the entire stream, so it stays in double precision in both cases.
+#ifdef USE_FLOAT_FEATURES
+typedef float FeatureScalar;
+#else
+typedef double FeatureScalar;
+#endif
+
+typedef std::vector<FeatureScalar> FeatureVector;
+
+}; // namespace chromaprint
+
+#endif
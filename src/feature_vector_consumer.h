@@ -5,13 +5,14 @@
 #define CHROMAPRINT_FEATURE_VECTOR_CONSUMER_H_
 
 #include <vector>
+#include "feature_vector.h"
 
 namespace chromaprint {
 
 class FeatureVectorConsumer {
 public:
 	virtual ~FeatureVectorConsumer() {}
-	virtual void Consume(std::vector<double> &features) = 0;
+	virtual void Consume(FeatureVector &features) = 0;
 };
 
 }; // namespace chromaprint
@@ -1,29 +1,71 @@
 // Copyright (C) 2010-2016  Lukas Lalinsky
 // Distributed under the MIT license, see the LICENSE file for details.
 
+#include <algorithm>
 #include "audio/audio_slicer.h"
 #include "utils.h"
 #include "fft_lib.h"
 #include "fft.h"
+#include "stats.h"
 #include "debug.h"
 
 namespace chromaprint {
 
-FFT::FFT(size_t frame_size, size_t overlap, FFTFrameConsumer *consumer)
-	: m_frame(1 + frame_size / 2), m_slicer(frame_size, frame_size - overlap), m_lib(new FFTLib(frame_size)), m_consumer(consumer) {}
+FFT::FFT(size_t frame_size, size_t overlap, FFTFrameConsumer *consumer, size_t batch_size)
+	: m_frames(std::max(batch_size, size_t(1)), FFTFrame(1 + frame_size / 2)),
+	  m_slicer(frame_size, frame_size - overlap),
+	  m_lib(new FFTLib(frame_size, m_frames.size())),
+	  m_consumer(consumer)
+{
+	size_t begin, end;
+	if (consumer->GetBinRange(&begin, &end)) {
+		end = std::min(end, frame_size / 2 + 1);
+		m_lib->SetBinRange(std::min(begin, end), end);
+	}
+}
 
 FFT::~FFT() {}
 
 void FFT::Reset() {
 	m_slicer.Reset();
+	m_num_frames = 0;
+}
+
+// All complete frames are processed at the end of Consume(), so only the
+// input for the next frame needs to be saved.
+void FFT::SaveState(StateWriter &writer) const {
+	assert(m_num_frames == 0);
+	m_slicer.SaveState(writer);
 }
 
+bool FFT::RestoreState(StateReader &reader) {
+	m_num_frames = 0;
+	return m_slicer.RestoreState(reader);
+}
+
+// Frames are collected into batches, so that the FFT library can transform
+// them together, but all complete frames are still passed to the consumer
+// before Consume() returns.
 void FFT::Consume(const int16_t *input, int length) {
+	CHROMAPRINT_STAGE_TIMER(FFT, length);
 	m_slicer.Process(input, input + length, [&](const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
-		m_lib->Load(b1, e1, b2, e2);
-		m_lib->Compute(m_frame);
-		m_consumer->Consume(m_frame);
+		m_lib->Load(m_num_frames++, b1, e1, b2, e2);
+		if (m_num_frames == m_frames.size()) {
+			ComputeFrames();
+		}
 	});
+	ComputeFrames();
+}
+
+void FFT::ComputeFrames() {
+	if (!m_num_frames) {
+		return;
+	}
+	m_lib->Compute(m_num_frames, m_frames.data());
+	for (size_t i = 0; i < m_num_frames; i++) {
+		m_consumer->Consume(m_frames[i]);
+	}
+	m_num_frames = 0;
 }
 
 }; // namespace chromaprint
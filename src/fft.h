@@ -6,6 +6,7 @@
 
 #include <cmath>
 #include <memory>
+#include <vector>
 #include "utils.h"
 #include "fft_frame.h"
 #include "fft_frame_consumer.h"
@@ -16,10 +17,13 @@ namespace chromaprint {
 
 class FFTLib;
 
+// Number of frames transformed together, when enough input is available.
+static const size_t kFFTBatchSize = 8;
+
 class FFT : public AudioConsumer
 {
 public:
-	FFT(size_t frame_size, size_t overlap, FFTFrameConsumer *consumer);
+	FFT(size_t frame_size, size_t overlap, FFTFrameConsumer *consumer, size_t batch_size = kFFTBatchSize);
 	~FFT();
 
 	size_t frame_size() const {
@@ -34,13 +38,23 @@ public:
 		return m_slicer.size() - m_slicer.increment();
 	}
 
+	size_t batch_size() const {
+		return m_frames.size();
+	}
+
 	void Reset();
 	void Consume(const int16_t *input, int length) override;
 
+	void SaveState(StateWriter &writer) const;
+	bool RestoreState(StateReader &reader);
+
 private:
 	CHROMAPRINT_DISABLE_COPY(FFT);
 
-	FFTFrame m_frame;
+	void ComputeFrames();
+
+	std::vector<FFTFrame> m_frames;
+	size_t m_num_frames = 0;
 	AudioSlicer<int16_t> m_slicer;
 	std::unique_ptr<FFTLib> m_lib;
 	FFTFrameConsumer *m_consumer;
@@ -5,10 +5,11 @@
 #define CHROMAPRINT_FFT_FRAME_H_
 
 #include <vector>
+#include "feature_vector.h"
 
 namespace chromaprint {
 
-typedef std::vector<double> FFTFrame;
+typedef std::vector<FeatureScalar> FFTFrame;
 
 }; // namespace chromaprint
 
@@ -13,6 +13,14 @@ class FFTFrameConsumer
 public:
 	virtual ~FFTFrameConsumer() {}
 	virtual void Consume(const FFTFrame &frame) = 0;
+
+	//! Get the range of bins the consumer reads from the frames.
+	//
+	// The other bins don't need to be computed and their values are
+	// undefined. Returns false if all bins are needed.
+	virtual bool GetBinRange(size_t *begin, size_t *end) const {
+		return false;
+	}
 };
 
 }; // namespace chromaprint
@@ -28,4 +28,8 @@
 #include "fft_lib_kissfft.h"
 #endif
 
+#ifdef USE_BUILTIN_FFT
+#include "fft_lib_builtin.h"
+#endif
+
 #endif
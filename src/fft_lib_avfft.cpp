@@ -1,13 +1,15 @@
 // Copyright (C) 2010-2016  Lukas Lalinsky
 // Distributed under the MIT license, see the LICENSE file for details.
 
+#include <algorithm>
+#include <cassert>
 #include "fft_lib_avfft.h"
 
 namespace chromaprint {
 
-FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
+FFTLib::FFTLib(size_t frame_size, size_t batch_size) : m_frame_size(frame_size), m_batch_size(batch_size), m_bin_begin(0), m_bin_end(frame_size / 2 + 1), m_kernels(&GetSimdKernels()) {
 	m_window = (FFTSample *) av_malloc(sizeof(FFTSample) * frame_size);
-	m_input = (FFTSample *) av_malloc(sizeof(FFTSample) * frame_size);
+	m_input = (FFTSample *) av_malloc(sizeof(FFTSample) * frame_size * batch_size);
 	PrepareHammingWindow(m_window, m_window + frame_size, 1.0 / INT16_MAX);
 	int bits = -1;
 	while (frame_size) {
@@ -23,25 +25,39 @@ FFTLib::~FFTLib() {
 	av_free(m_window);
 }
 
-void FFTLib::Load(const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
-	auto window = m_window;
-	auto output = m_input;
-	ApplyWindow(b1, e1, window, output);
-	ApplyWindow(b2, e2, window, output);
+void FFTLib::Load(size_t index, const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
+	assert(index < m_batch_size);
+	const auto input = m_input + index * m_frame_size;
+	const size_t size1 = e1 - b1;
+	m_kernels->apply_window(b1, m_window, input, size1);
+	m_kernels->apply_window(b2, m_window + size1, input + size1, e2 - b2);
 }
 
-void FFTLib::Compute(FFTFrame &frame) {
-	av_rdft_calc(m_rdft_ctx, m_input);
-	auto input = m_input;
-	auto output = frame.begin();
-	output[0] = input[0] * input[0];
-	output[m_frame_size / 2] = input[1] * input[1];
-	output += 1;
-	input += 2;
-	for (size_t i = 1; i < m_frame_size / 2; i++) {
-		*output++ = input[0] * input[0] + input[1] * input[1];
-		input += 2;
+void FFTLib::Compute(size_t count, FFTFrame *frames) {
+	assert(count <= m_batch_size);
+	for (size_t i = 0; i < count; i++) {
+		const auto input = m_input + i * m_frame_size;
+		av_rdft_calc(m_rdft_ctx, input);
+		const size_t n = m_frame_size / 2;
+		const size_t begin = std::max(m_bin_begin, size_t(1));
+		const size_t end = std::min(m_bin_end, n);
+		auto output = frames[i].data();
+		if (m_bin_begin == 0) {
+			output[0] = input[0] * input[0];
+		}
+		if (m_bin_end > n) {
+			output[n] = input[1] * input[1];
+		}
+		if (begin < end) {
+			m_kernels->power_spectrum_interleaved(input + 2 * begin, output + begin, end - begin);
+		}
 	}
 }
 
+void FFTLib::SetBinRange(size_t begin, size_t end) {
+	assert(begin <= end && end <= m_frame_size / 2 + 1);
+	m_bin_begin = begin;
+	m_bin_end = end;
+}
+
 }; // namespace chromaprint
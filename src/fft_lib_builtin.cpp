@@ -0,0 +1,138 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "fft_lib_builtin.h"
+
+namespace chromaprint {
+
+FFTLib::FFTLib(size_t frame_size, size_t batch_size) : m_frame_size(frame_size), m_batch_size(batch_size), m_bin_begin(0), m_bin_end(frame_size / 2 + 1), m_kernels(&GetSimdKernels()) {
+	assert(frame_size >= 8 && (frame_size & (frame_size - 1)) == 0);
+	const size_t n = frame_size / 2;
+
+	m_window.resize(frame_size);
+	m_input.resize(frame_size);
+	m_real.resize(n * batch_size);
+	m_imag.resize(n * batch_size);
+	PrepareHammingWindow(m_window.begin(), m_window.end(), 1.0 / INT16_MAX);
+
+	m_twiddle_real.resize(n);
+	m_twiddle_imag.resize(n);
+	for (size_t h = 1; h < n; h *= 2) {
+		for (size_t j = 0; j < h; j++) {
+			m_twiddle_real[h + j] = cos(M_PI * j / h);
+			m_twiddle_imag[h + j] = -sin(M_PI * j / h);
+		}
+	}
+
+	m_split_real.resize(n);
+	m_split_imag.resize(n);
+	for (size_t k = 0; k < n; k++) {
+		m_split_real[k] = cos(2.0 * M_PI * k / frame_size);
+		m_split_imag[k] = -sin(2.0 * M_PI * k / frame_size);
+	}
+
+	size_t bits = 0;
+	while ((size_t(1) << bits) < n) {
+		bits++;
+	}
+	m_bit_reverse.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		uint32_t r = 0;
+		for (size_t b = 0; b < bits; b++) {
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		}
+		m_bit_reverse[i] = r;
+	}
+}
+
+FFTLib::~FFTLib() {
+}
+
+void FFTLib::Load(size_t index, const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
+	assert(index < m_batch_size);
+	const size_t size1 = e1 - b1;
+	m_kernels->apply_window(b1, m_window.data(), m_input.data(), size1);
+	m_kernels->apply_window(b2, m_window.data() + size1, m_input.data() + size1, e2 - b2);
+
+	const size_t n = m_frame_size / 2;
+	auto real = m_real.data() + index * n;
+	auto imag = m_imag.data() + index * n;
+	for (size_t i = 0; i < n; i++) {
+		real[i] = m_input[2 * i];
+		imag[i] = m_input[2 * i + 1];
+	}
+}
+
+void FFTLib::Transform(float *real, float *imag) {
+	const size_t n = m_frame_size / 2;
+	for (size_t h = n / 2; h > 2; h /= 2) {
+		for (size_t i = 0; i < n; i += 2 * h) {
+			m_kernels->fft_butterfly(real + i, imag + i, m_twiddle_real.data() + h, m_twiddle_imag.data() + h, h);
+		}
+	}
+	// the last two stages only need multiplications by 1 and -i
+	for (size_t i = 0; i < n; i += 4) {
+		float *re = real + i;
+		float *im = imag + i;
+		const float r0 = re[0] + re[2], i0 = im[0] + im[2];
+		const float r1 = re[1] + re[3], i1 = im[1] + im[3];
+		const float r2 = re[0] - re[2], i2 = im[0] - im[2];
+		const float r3 = im[1] - im[3], i3 = re[3] - re[1];
+		re[0] = r0 + r1;
+		im[0] = i0 + i1;
+		re[1] = r0 - r1;
+		im[1] = i0 - i1;
+		re[2] = r2 + r3;
+		im[2] = i2 + i3;
+		re[3] = r2 - r3;
+		im[3] = i2 - i3;
+	}
+}
+
+void FFTLib::ComputePowerSpectrum(const float *real, const float *imag, FFTFrame &frame) {
+	const size_t n = m_frame_size / 2;
+	const auto rev = m_bit_reverse.data();
+	auto output = frame.data();
+
+	const size_t begin = std::max(m_bin_begin, size_t(1));
+	const size_t end = std::min(m_bin_end, n);
+	if (m_bin_begin == 0) {
+		output[0] = (real[0] + imag[0]) * (real[0] + imag[0]);
+	}
+	if (m_bin_end > n) {
+		output[n] = (real[0] - imag[0]) * (real[0] - imag[0]);
+	}
+	for (size_t k = begin; k < end; k++) {
+		const float a = real[rev[k]], b = imag[rev[k]];
+		const float c = real[rev[n - k]], d = imag[rev[n - k]];
+		// spectra of the even and odd samples
+		const float er = 0.5f * (a + c), ei = 0.5f * (b - d);
+		const float or_ = 0.5f * (b + d), oi = 0.5f * (c - a);
+		const float wr = m_split_real[k], wi = m_split_imag[k];
+		const float xr = er + (wr * or_ - wi * oi);
+		const float xi = ei + (wr * oi + wi * or_);
+		output[k] = xr * xr + xi * xi;
+	}
+}
+
+void FFTLib::Compute(size_t count, FFTFrame *frames) {
+	assert(count <= m_batch_size);
+	const size_t n = m_frame_size / 2;
+	for (size_t i = 0; i < count; i++) {
+		auto real = m_real.data() + i * n;
+		auto imag = m_imag.data() + i * n;
+		Transform(real, imag);
+		ComputePowerSpectrum(real, imag, frames[i]);
+	}
+}
+
+void FFTLib::SetBinRange(size_t begin, size_t end) {
+	assert(begin <= end && end <= m_frame_size / 2 + 1);
+	m_bin_begin = begin;
+	m_bin_end = end;
+}
+
+}; // namespace chromaprint
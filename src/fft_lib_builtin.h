@@ -0,0 +1,60 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FFT_LIB_BUILTIN_H_
+#define CHROMAPRINT_FFT_LIB_BUILTIN_H_
+
+#include <vector>
+
+#include "fft_frame.h"
+#include "utils.h"
+#include "simd/simd.h"
+
+namespace chromaprint {
+
+// Real FFT for power-of-two frame sizes, without external dependencies.
+//
+// A real frame of size N is transformed as a complex sequence of size N/2,
+// with the even samples in the real part and the odd samples in the imaginary
+// part, using radix-2 decimation-in-frequency butterflies from SimdKernels.
+// The result is in bit-reversed order, which is undone while the spectrum of
+// the real frame is reconstructed and squared into the power spectrum.
+class FFTLib {
+public:
+	FFTLib(size_t frame_size, size_t batch_size = 1);
+	~FFTLib();
+
+	//! Apply the window to a frame and store it in the given slot of the batch.
+	void Load(size_t index, const int16_t *begin1, const int16_t *end1, const int16_t *begin2, const int16_t *end2);
+	//! Calculate the power spectrum of the first count frames of the batch.
+	void Compute(size_t count, FFTFrame *frames);
+	//! Only compute the power spectrum bins in [begin, end).
+	void SetBinRange(size_t begin, size_t end);
+
+private:
+	CHROMAPRINT_DISABLE_COPY(FFTLib);
+
+	void Transform(float *real, float *imag);
+	void ComputePowerSpectrum(const float *real, const float *imag, FFTFrame &frame);
+
+	size_t m_frame_size;
+	size_t m_batch_size;
+	size_t m_bin_begin;
+	size_t m_bin_end;
+	std::vector<float> m_window;
+	std::vector<float> m_input;
+	std::vector<float> m_real;
+	std::vector<float> m_imag;
+	// twiddle factors of the butterflies with half size h are at [h, 2h)
+	std::vector<float> m_twiddle_real;
+	std::vector<float> m_twiddle_imag;
+	// twiddle factors for splitting the complex spectrum into the real one
+	std::vector<float> m_split_real;
+	std::vector<float> m_split_imag;
+	std::vector<uint32_t> m_bit_reverse;
+	const SimdKernels *m_kernels;
+};
+
+}; // namespace chromaprint
+
+#endif // CHROMAPRINT_FFT_LIB_BUILTIN_H_
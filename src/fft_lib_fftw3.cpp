@@ -1,46 +1,96 @@
 // Copyright (C) 2010-2016  Lukas Lalinsky
 // Distributed under the MIT license, see the LICENSE file for details.
 
+#include <algorithm>
+#include <cassert>
 #include "fft_lib_fftw3.h"
 
 namespace chromaprint {
 
-FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
+FFTLib::FFTLib(size_t frame_size, size_t batch_size) : m_frame_size(frame_size), m_batch_size(batch_size), m_bin_begin(0), m_bin_end(frame_size / 2 + 1) {
+#ifdef USE_FFTW3F
+	m_kernels = &GetSimdKernels();
+#endif
+	// frames in the batch start at the same alignment, so that the single
+	// frame plan can be executed on any of them
+	m_stride = (frame_size + 15) & ~size_t(15);
 	m_window = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
-	m_input = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
-	m_output = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * frame_size);
+	m_input = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * m_stride * batch_size);
+	m_output = (FFTW_SCALAR *) fftw_malloc(sizeof(FFTW_SCALAR) * m_stride * batch_size);
 	PrepareHammingWindow(m_window, m_window + frame_size, 1.0 / INT16_MAX);
 	m_plan = fftw_plan_r2r_1d(frame_size, m_input, m_output, FFTW_R2HC, FFTW_ESTIMATE);
+	m_batch_plan = nullptr;
+	if (batch_size > 1) {
+		const int n = frame_size;
+		const fftw_r2r_kind kind = FFTW_R2HC;
+		m_batch_plan = fftw_plan_many_r2r(1, &n, batch_size,
+			m_input, nullptr, 1, m_stride,
+			m_output, nullptr, 1, m_stride,
+			&kind, FFTW_ESTIMATE);
+	}
 }
 
 FFTLib::~FFTLib() {
+	if (m_batch_plan) {
+		fftw_destroy_plan(m_batch_plan);
+	}
 	fftw_destroy_plan(m_plan);
 	fftw_free(m_output);
 	fftw_free(m_input);
 	fftw_free(m_window);
 }
 
-void FFTLib::Load(const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
+void FFTLib::Load(size_t index, const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
+	assert(index < m_batch_size);
+#ifdef USE_FFTW3F
+	const auto input = m_input + index * m_stride;
+	const size_t size1 = e1 - b1;
+	m_kernels->apply_window(b1, m_window, input, size1);
+	m_kernels->apply_window(b2, m_window + size1, input + size1, e2 - b2);
+#else
 	auto window = m_window;
-	auto output = m_input;
+	auto output = m_input + index * m_stride;
 	ApplyWindow(b1, e1, window, output);
 	ApplyWindow(b2, e2, window, output);
+#endif
 }
 
-void FFTLib::Compute(FFTFrame &frame) {
-	fftw_execute(m_plan);
-	auto output = frame.data();
-	auto in_ptr = m_output;
-	auto rev_in_ptr = m_output + m_frame_size - 1;
-	output[0] = in_ptr[0] * in_ptr[0];
-	output[m_frame_size / 2] = in_ptr[m_frame_size / 2] * in_ptr[m_frame_size / 2];
-	in_ptr += 1;
-	output += 1;
-	for (size_t i = 1; i < m_frame_size / 2; i++) {
-		*output++ = in_ptr[0] * in_ptr[0] + rev_in_ptr[0] * rev_in_ptr[0];
-		in_ptr++;
-		rev_in_ptr--;
+void FFTLib::Compute(size_t count, FFTFrame *frames) {
+	assert(count <= m_batch_size);
+	if (count == m_batch_size && m_batch_plan) {
+		fftw_execute(m_batch_plan);
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			fftw_execute_r2r(m_plan, m_input + i * m_stride, m_output + i * m_stride);
+		}
+	}
+	const size_t n = m_frame_size / 2;
+	const size_t begin = std::max(m_bin_begin, size_t(1));
+	const size_t end = std::min(m_bin_end, n);
+	for (size_t j = 0; j < count; j++) {
+		auto output = frames[j].data();
+		auto in_ptr = m_output + j * m_stride;
+		if (m_bin_begin == 0) {
+			output[0] = in_ptr[0] * in_ptr[0];
+		}
+		if (m_bin_end > n) {
+			output[n] = in_ptr[n] * in_ptr[n];
+		}
+		auto rev_in_ptr = in_ptr + m_frame_size - begin;
+		in_ptr += begin;
+		output += begin;
+		for (size_t i = begin; i < end; i++) {
+			*output++ = in_ptr[0] * in_ptr[0] + rev_in_ptr[0] * rev_in_ptr[0];
+			in_ptr++;
+			rev_in_ptr--;
+		}
 	}
 }
 
+void FFTLib::SetBinRange(size_t begin, size_t end) {
+	assert(begin <= end && end <= m_frame_size / 2 + 1);
+	m_bin_begin = begin;
+	m_bin_end = end;
+}
+
 }; // namespace chromaprint
@@ -8,12 +8,15 @@
 
 #include "fft_frame.h"
 #include "utils.h"
+#include "simd/simd.h"
 
 #ifdef USE_FFTW3F
 #define FFTW_SCALAR float
 #define fftw_plan fftwf_plan
 #define fftw_plan_r2r_1d fftwf_plan_r2r_1d
+#define fftw_plan_many_r2r fftwf_plan_many_r2r
 #define fftw_execute fftwf_execute
+#define fftw_execute_r2r fftwf_execute_r2r
 #define fftw_destroy_plan fftwf_destroy_plan
 #define fftw_malloc fftwf_malloc
 #define fftw_free fftwf_free
@@ -25,20 +28,32 @@ namespace chromaprint {
 
 class FFTLib {
 public:
-	FFTLib(size_t frame_size);
+	FFTLib(size_t frame_size, size_t batch_size = 1);
 	~FFTLib();
 
-	void Load(const int16_t *begin1, const int16_t *end1, const int16_t *begin2, const int16_t *end2);
-	void Compute(FFTFrame &frame);
+	//! Apply the window to a frame and store it in the given slot of the batch.
+	void Load(size_t index, const int16_t *begin1, const int16_t *end1, const int16_t *begin2, const int16_t *end2);
+	//! Calculate the power spectrum of the first count frames of the batch.
+	void Compute(size_t count, FFTFrame *frames);
+	//! Only compute the power spectrum bins in [begin, end).
+	void SetBinRange(size_t begin, size_t end);
 
 private:
 	CHROMAPRINT_DISABLE_COPY(FFTLib);
 
 	size_t m_frame_size;
+	size_t m_batch_size;
+	size_t m_bin_begin;
+	size_t m_bin_end;
+	size_t m_stride;
 	FFTW_SCALAR *m_window;
 	FFTW_SCALAR *m_input;
 	FFTW_SCALAR *m_output;
 	fftw_plan m_plan;
+	fftw_plan m_batch_plan;
+#ifdef USE_FFTW3F
+	const SimdKernels *m_kernels;
+#endif
 };
 
 }; // namespace chromaprint
@@ -1,13 +1,17 @@
 // Copyright (C) 2010-2016  Lukas Lalinsky
 // Distributed under the MIT license, see the LICENSE file for details.
 
+#include <cassert>
+#include <type_traits>
 #include "fft_lib_kissfft.h"
 
 namespace chromaprint {
 
-FFTLib::FFTLib(size_t frame_size) : m_frame_size(frame_size) {
+static_assert(std::is_same<kiss_fft_scalar, float>::value, "KissFFT must be built with float samples");
+
+FFTLib::FFTLib(size_t frame_size, size_t batch_size) : m_frame_size(frame_size), m_batch_size(batch_size), m_bin_begin(0), m_bin_end(frame_size / 2 + 1), m_kernels(&GetSimdKernels()) {
 	m_window = (kiss_fft_scalar *) KISS_FFT_MALLOC(sizeof(kiss_fft_scalar) * frame_size);
-	m_input = (kiss_fft_scalar *) KISS_FFT_MALLOC(sizeof(kiss_fft_scalar) * frame_size);
+	m_input = (kiss_fft_scalar *) KISS_FFT_MALLOC(sizeof(kiss_fft_scalar) * frame_size * batch_size);
 	m_output = (kiss_fft_cpx *) KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * frame_size);
 	PrepareHammingWindow(m_window, m_window + frame_size, 1.0 / INT16_MAX);
 	m_cfg = kiss_fftr_alloc(frame_size, 0, NULL, NULL);
@@ -20,20 +24,28 @@ FFTLib::~FFTLib() {
 	KISS_FFT_FREE(m_window);
 }
 
-void FFTLib::Load(const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
-	auto window = m_window;
-	auto output = m_input;
-	ApplyWindow(b1, e1, window, output);
-	ApplyWindow(b2, e2, window, output);
+void FFTLib::Load(size_t index, const int16_t *b1, const int16_t *e1, const int16_t *b2, const int16_t *e2) {
+	assert(index < m_batch_size);
+	const auto input = m_input + index * m_frame_size;
+	const size_t size1 = e1 - b1;
+	m_kernels->apply_window(b1, m_window, input, size1);
+	m_kernels->apply_window(b2, m_window + size1, input + size1, e2 - b2);
 }
 
-void FFTLib::Compute(FFTFrame &frame) {
-	kiss_fftr(m_cfg, m_input, m_output);
-	auto input = m_output;
-	auto output = frame.data();
-	for (size_t i = 0; i <= m_frame_size / 2; ++i, ++input, ++output) {
-		*output = input->r * input->r + input->i * input->i;
+// KissFFT has no batch interface, but the frames are stored next to each
+// other and transformed in a tight loop, so the twiddle factors stay in cache.
+void FFTLib::Compute(size_t count, FFTFrame *frames) {
+	assert(count <= m_batch_size);
+	for (size_t i = 0; i < count; i++) {
+		kiss_fftr(m_cfg, m_input + i * m_frame_size, m_output);
+		m_kernels->power_spectrum_interleaved(&m_output[m_bin_begin].r, frames[i].data() + m_bin_begin, m_bin_end - m_bin_begin);
 	}
 }
 
+void FFTLib::SetBinRange(size_t begin, size_t end) {
+	assert(begin <= end && end <= m_frame_size / 2 + 1);
+	m_bin_begin = begin;
+	m_bin_end = end;
+}
+
 }; // namespace chromaprint
@@ -8,25 +8,34 @@
 
 #include "fft_frame.h"
 #include "utils.h"
+#include "simd/simd.h"
 
 namespace chromaprint {
 
 class FFTLib {
 public:
-	FFTLib(size_t frame_size);
+	FFTLib(size_t frame_size, size_t batch_size = 1);
 	~FFTLib();
 
-	void Load(const int16_t *begin1, const int16_t *end1, const int16_t *begin2, const int16_t *end2);
-	void Compute(FFTFrame &frame);
+	//! Apply the window to a frame and store it in the given slot of the batch.
+	void Load(size_t index, const int16_t *begin1, const int16_t *end1, const int16_t *begin2, const int16_t *end2);
+	//! Calculate the power spectrum of the first count frames of the batch.
+	void Compute(size_t count, FFTFrame *frames);
+	//! Only compute the power spectrum bins in [begin, end).
+	void SetBinRange(size_t begin, size_t end);
 
 private:
 	CHROMAPRINT_DISABLE_COPY(FFTLib);
 
 	size_t m_frame_size;
+	size_t m_batch_size;
+	size_t m_bin_begin;
+	size_t m_bin_end;
 	kiss_fft_scalar *m_window;
 	kiss_fft_scalar *m_input;
 	kiss_fft_cpx *m_output;
 	kiss_fftr_cfg m_cfg;
+	const SimdKernels *m_kernels;
 };
 
 }; // namespace chromaprint
@@ -18,6 +18,16 @@ struct Collector : public FFTFrameConsumer {
 	std::vector<FFTFrame> frames;
 };
 
+struct RangeCollector : public Collector {
+	RangeCollector(size_t begin, size_t end) : begin(begin), end(end) {}
+	virtual bool GetBinRange(size_t *begin, size_t *end) const override {
+		*begin = this->begin;
+		*end = this->end;
+		return true;
+	}
+	size_t begin, end;
+};
+
 };
 
 TEST(FFTTest, Sine) {
@@ -134,4 +144,67 @@ TEST(FFTTest, DC) {
 	}
 }
 
+TEST(FFTTest, Batch) {
+	const size_t frame_size = 64;
+	const size_t overlap = 48;
+
+	std::vector<int16_t> input(frame_size * 40 + 7);
+	for (size_t i = 0; i < input.size(); i++) {
+		input[i] = (i * 7919) % 65536 - 32768;
+	}
+
+	Collector expected;
+	FFT fft1(frame_size, overlap, &expected, 1);
+	fft1.Consume(input.data(), input.size());
+	ASSERT_EQ((input.size() - overlap) / (frame_size - overlap), expected.frames.size());
+
+	for (size_t batch_size : { 2, 3, 8, 100 }) {
+		for (size_t chunk_size : { 1, 15, 64, 100, 10000 }) {
+			Collector collector;
+			FFT fft(frame_size, overlap, &collector, batch_size);
+			ASSERT_EQ(batch_size, fft.batch_size());
+			for (size_t i = 0; i < input.size(); i += chunk_size) {
+				const auto size = std::min(input.size() - i, chunk_size);
+				fft.Consume(input.data() + i, size);
+				// all complete frames are processed by the end of the call
+				const auto num_samples = i + size;
+				const auto num_frames = num_samples < frame_size ? 0 : (num_samples - overlap) / (frame_size - overlap);
+				EXPECT_EQ(num_frames, collector.frames.size()) << "batch size " << batch_size << ", chunk size " << chunk_size;
+			}
+			ASSERT_EQ(expected.frames.size(), collector.frames.size());
+			for (size_t i = 0; i < expected.frames.size(); i++) {
+				ASSERT_EQ(expected.frames[i], collector.frames[i]) << "batch size " << batch_size << ", chunk size " << chunk_size << ", frame " << i;
+			}
+		}
+	}
+}
+
+TEST(FFTTest, BinRange) {
+	const size_t frame_size = 64;
+	const size_t overlap = 48;
+
+	std::vector<int16_t> input(frame_size * 10);
+	for (size_t i = 0; i < input.size(); i++) {
+		input[i] = (i * 7919) % 65536 - 32768;
+	}
+
+	Collector expected;
+	FFT fft1(frame_size, overlap, &expected);
+	fft1.Consume(input.data(), input.size());
+
+	const std::pair<size_t, size_t> ranges[] = { { 0, 33 }, { 0, 5 }, { 1, 32 }, { 3, 17 }, { 30, 33 }, { 10, 10 } };
+	for (const auto &range : ranges) {
+		RangeCollector collector(range.first, range.second);
+		FFT fft(frame_size, overlap, &collector);
+		fft.Consume(input.data(), input.size());
+		ASSERT_EQ(expected.frames.size(), collector.frames.size());
+		for (size_t i = 0; i < expected.frames.size(); i++) {
+			ASSERT_EQ(expected.frames[i].size(), collector.frames[i].size());
+			for (size_t j = range.first; j < range.second; j++) {
+				ASSERT_EQ(expected.frames[i][j], collector.frames[i][j]) << "range " << range.first << "-" << range.second << ", frame " << i << ", bin " << j;
+			}
+		}
+	}
+}
+
 }; // namespace chromaprint
@@ -3,24 +3,37 @@
 
 #include "fingerprint_calculator.h"
 #include "classifier.h"
+#include "stats.h"
 #include "debug.h"
 #include "utils.h"
+#include "utils/state_buffer.h"
 
 namespace chromaprint {
 
-FingerprintCalculator::FingerprintCalculator(const Classifier *classifiers, size_t num_classifiers)
-	: m_classifiers(classifiers), m_num_classifiers(num_classifiers), m_image(256)
+static size_t GetMaxFilterWidth(const Classifier *classifiers, size_t num_classifiers)
 {
-	m_max_filter_width = 0;
+	size_t max_filter_width = 0;
 	for (size_t i = 0; i < num_classifiers; i++) {
-		m_max_filter_width = std::max(m_max_filter_width, (size_t) classifiers[i].filter().width());
+		max_filter_width = std::max(max_filter_width, (size_t) classifiers[i].filter().width());
 	}
-	assert(m_max_filter_width > 0);
-	assert(m_max_filter_width < 256);
+	assert(max_filter_width > 0);
+	assert(max_filter_width < 256);
+	return max_filter_width;
+}
+
+FingerprintCalculator::FingerprintCalculator(const Classifier *classifiers, size_t num_classifiers)
+	: m_classifiers(classifiers), m_num_classifiers(num_classifiers),
+	  m_max_filter_width(GetMaxFilterWidth(classifiers, num_classifiers)),
+	  m_kernel(GetSubfingerprintKernel(classifiers, num_classifiers)),
+	  m_image(m_max_filter_width)
+{
 }
 
 uint32_t FingerprintCalculator::CalculateSubfingerprint(size_t offset)
 {
+	if (m_kernel) {
+		return m_kernel(m_image, offset);
+	}
 	uint32_t bits = 0;
 	for (size_t i = 0; i < m_num_classifiers; i++) {
 		bits = (bits << 2) | GrayCode(m_classifiers[i].Classify(m_image, offset));
@@ -33,7 +46,8 @@ void FingerprintCalculator::Reset() {
 	m_fingerprint.clear();
 }
 
-void FingerprintCalculator::Consume(std::vector<double> &features) {
+void FingerprintCalculator::Consume(FeatureVector &features) {
+	CHROMAPRINT_STAGE_TIMER(FingerprintCalculator, 1);
 	m_image.AddRow(features);
 	if (m_image.num_rows() >= m_max_filter_width) {
 		m_fingerprint.push_back(CalculateSubfingerprint(m_image.num_rows() - m_max_filter_width));
@@ -48,4 +62,17 @@ void FingerprintCalculator::ClearFingerprint() {
 	m_fingerprint.clear();
 }
 
+void FingerprintCalculator::SaveState(StateWriter &writer) const {
+	m_image.SaveState(writer);
+	writer.WriteArray(m_fingerprint);
+}
+
+bool FingerprintCalculator::RestoreState(StateReader &reader) {
+	if (!m_image.RestoreState(reader) || !reader.ReadArray(&m_fingerprint, UINT32_MAX)) {
+		Reset();
+		return false;
+	}
+	return true;
+}
+
 }; // namespace chromaprint
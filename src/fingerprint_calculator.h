@@ -7,7 +7,7 @@
 #include <cstdint>
 #include <vector>
 #include "feature_vector_consumer.h"
-#include "utils/rolling_integral_image.h"
+#include "classifier_kernels.h"
 
 namespace chromaprint {
 
@@ -19,7 +19,7 @@ class FingerprintCalculator : public FeatureVectorConsumer {
 public:
 	FingerprintCalculator(const Classifier *classifiers, size_t num_classifiers);
 
-	virtual void Consume(std::vector<double> &features) override;
+	virtual void Consume(FeatureVector &features) override final;
 
 	//! Get the fingerprint generate from data up to this point.
 	const std::vector<uint32_t> &GetFingerprint() const;
@@ -30,13 +30,18 @@ public:
 	//! Reset all internal state.
 	void Reset();
 
+	void SaveState(StateWriter &writer) const;
+	bool RestoreState(StateReader &reader);
+
 private:
 	uint32_t CalculateSubfingerprint(size_t offset);
 
 	const Classifier *m_classifiers;
 	size_t m_num_classifiers;
 	size_t m_max_filter_width;
-	RollingIntegralImage m_image;
+	SubfingerprintKernel m_kernel;
+	// only the last m_max_filter_width rows are ever used
+	ChromaIntegralImage m_image;
 	std::vector<uint32_t> m_fingerprint;
 };
 
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include "fingerprint_compressor.h"
+#include "stats.h"
 #include "utils.h"
 #include "utils/pack_int3_array.h"
 #include "utils/pack_int5_array.h"
@@ -38,6 +39,7 @@ void FingerprintCompressor::ProcessSubfingerprint(uint32_t x)
 
 void FingerprintCompressor::Compress(const std::vector<uint32_t> &data, int algorithm, std::string &output)
 {
+	CHROMAPRINT_STAGE_TIMER(Compressor, data.size());
 	const auto size = data.size();
 
 	m_normal_bits.clear();
@@ -16,7 +16,7 @@ public:
 	FingerprintDecompressor();
 	bool Decompress(const std::string &fingerprint);
 
-	std::vector<uint32_t> GetOutput() const { return m_output; }
+	const std::vector<uint32_t> &GetOutput() const { return m_output; }
 	int GetAlgorithm() const { return m_algorithm; }
 
 private:
@@ -0,0 +1,339 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include "fingerprint_index.h"
+#include "debug.h"
+
+namespace chromaprint {
+
+static const char kFileMagic[8] = { 'C', 'P', 'I', 'N', 'D', 'E', 'X', '\0' };
+static const uint32_t kFileByteOrderMark = 0x01020304;
+static const uint64_t kFileSectionAlignment = 64;
+
+static_assert(sizeof(FingerprintIndexPosting) == 2 * sizeof(uint32_t), "FingerprintIndexPosting must be packed");
+
+namespace {
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t hash_bits;
+	uint32_t reserved;
+	uint64_t num_docs;
+	uint64_t num_items;
+	uint64_t num_hashes;
+	uint64_t num_postings;
+};
+
+struct FileLayout
+{
+	uint64_t ids;
+	uint64_t fingerprint_offsets;
+	uint64_t fingerprint_data;
+	uint64_t hashes;
+	uint64_t hash_offsets;
+	uint64_t postings;
+	uint64_t end;
+};
+
+inline uint64_t AlignSection(uint64_t offset)
+{
+	return (offset + kFileSectionAlignment - 1) / kFileSectionAlignment * kFileSectionAlignment;
+}
+
+// Returns false if the sections would not fit into max_size bytes.
+bool GetFileLayout(const FileHeader &header, uint64_t max_size, FileLayout &layout)
+{
+	uint64_t offset = sizeof(FileHeader);
+	auto add_section = [&](uint64_t &section, uint64_t count, uint64_t item_size) {
+		section = AlignSection(offset);
+		if (section > max_size || count > (max_size - section) / item_size) {
+			return false;
+		}
+		offset = section + count * item_size;
+		return true;
+	};
+	if (!add_section(layout.ids, header.num_docs, sizeof(uint32_t)) ||
+		!add_section(layout.fingerprint_offsets, header.num_docs + 1, sizeof(uint64_t)) ||
+		!add_section(layout.fingerprint_data, header.num_items, sizeof(uint32_t)) ||
+		!add_section(layout.hashes, header.num_hashes, sizeof(uint32_t)) ||
+		!add_section(layout.hash_offsets, header.num_hashes + 1, sizeof(uint64_t)) ||
+		!add_section(layout.postings, header.num_postings, sizeof(FingerprintIndexPosting))) {
+		return false;
+	}
+	layout.end = offset;
+	return true;
+}
+
+};
+
+FingerprintIndex::FingerprintIndex(int hash_bits)
+	: m_hash_bits(hash_bits)
+{
+	assert(hash_bits > 0 && hash_bits <= 32);
+	m_fingerprint_offsets.push_back(0);
+	m_hash_offsets.push_back(0);
+	UpdatePointers();
+}
+
+void FingerprintIndex::UpdatePointers()
+{
+	m_num_docs = m_ids.size();
+	m_num_hashes = m_hashes.size();
+	m_num_postings = m_postings.size();
+	m_ids_ptr = m_ids.data();
+	m_fingerprint_offsets_ptr = m_fingerprint_offsets.data();
+	m_fingerprint_data_ptr = m_fingerprint_data.data();
+	m_hashes_ptr = m_hashes.data();
+	m_hash_offsets_ptr = m_hash_offsets.data();
+	m_postings_ptr = m_postings.data();
+}
+
+void FingerprintIndex::Unmap()
+{
+	if (!m_file.is_open()) {
+		return;
+	}
+	m_ids.assign(m_ids_ptr, m_ids_ptr + m_num_docs);
+	m_fingerprint_offsets.assign(m_fingerprint_offsets_ptr, m_fingerprint_offsets_ptr + m_num_docs + 1);
+	// Build() relies on sorted offsets, which are not checked for mapped files
+	for (size_t i = m_num_docs; i > 0; i--) {
+		m_fingerprint_offsets[i - 1] = std::min(m_fingerprint_offsets[i - 1], m_fingerprint_offsets[i]);
+	}
+	m_fingerprint_data.assign(m_fingerprint_data_ptr, m_fingerprint_data_ptr + m_fingerprint_offsets_ptr[m_num_docs]);
+	m_hashes.assign(m_hashes_ptr, m_hashes_ptr + m_num_hashes);
+	m_hash_offsets.assign(m_hash_offsets_ptr, m_hash_offsets_ptr + m_num_hashes + 1);
+	m_postings.assign(m_postings_ptr, m_postings_ptr + m_num_postings);
+	m_file.Close();
+	UpdatePointers();
+}
+
+void FingerprintIndex::AddFingerprint(uint32_t id, const uint32_t *fp, size_t size)
+{
+	Unmap();
+	assert(m_fingerprint_data.size() + size <= UINT32_MAX);
+	m_ids.push_back(id);
+	m_fingerprint_data.insert(m_fingerprint_data.end(), fp, fp + size);
+	m_fingerprint_offsets.push_back(m_fingerprint_data.size());
+	m_built = false;
+	UpdatePointers();
+}
+
+void FingerprintIndex::Build()
+{
+	if (m_built) {
+		return;
+	}
+
+	// Sort (hash, item) pairs, the item number increases with the document
+	// and the position, so the posting lists end up sorted by both of them.
+	std::vector<uint64_t> entries(m_fingerprint_data.size());
+	for (size_t i = 0; i < m_fingerprint_data.size(); i++) {
+		entries[i] = (uint64_t(GetHash(m_fingerprint_data[i])) << 32) | i;
+	}
+	std::sort(entries.begin(), entries.end());
+
+	m_hashes.clear();
+	m_hash_offsets.clear();
+	m_postings.resize(entries.size());
+	uint32_t doc = 0;
+	for (size_t i = 0; i < entries.size(); i++) {
+		const auto hash = uint32_t(entries[i] >> 32);
+		const auto item = uint32_t(entries[i]);
+		if (m_hashes.empty() || m_hashes.back() != hash) {
+			m_hashes.push_back(hash);
+			m_hash_offsets.push_back(i);
+			doc = 0;
+		}
+		if (m_fingerprint_offsets[doc + 1] <= item) {
+			const auto it = std::upper_bound(m_fingerprint_offsets.begin() + doc, m_fingerprint_offsets.end(), uint64_t(item));
+			doc = std::distance(m_fingerprint_offsets.begin(), it) - 1;
+		}
+		m_postings[i].doc = doc;
+		m_postings[i].position = item - m_fingerprint_offsets[doc];
+	}
+	m_hash_offsets.push_back(m_postings.size());
+
+	m_built = true;
+	UpdatePointers();
+}
+
+void FingerprintIndex::Clear()
+{
+	m_file.Close();
+	m_ids.clear();
+	m_fingerprint_data.clear();
+	m_fingerprint_offsets.assign(1, 0);
+	m_hashes.clear();
+	m_hash_offsets.assign(1, 0);
+	m_postings.clear();
+	m_built = true;
+	UpdatePointers();
+}
+
+size_t FingerprintIndex::Lookup(uint32_t hash, const FingerprintIndexPosting **postings) const
+{
+	if (!m_built) {
+		DEBUG("chromaprint::FingerprintIndex::Lookup() -- Index is not built.");
+	}
+	const auto hashes_end = m_hashes_ptr + m_num_hashes;
+	const auto it = std::lower_bound(m_hashes_ptr, hashes_end, hash);
+	if (it == hashes_end || *it != hash) {
+		*postings = nullptr;
+		return 0;
+	}
+	const auto i = std::distance(m_hashes_ptr, it);
+	const auto begin = m_hash_offsets_ptr[i];
+	const auto end = m_hash_offsets_ptr[i + 1];
+	if (begin > end || end > m_num_postings) {
+		*postings = nullptr;
+		return 0;
+	}
+	*postings = m_postings_ptr + begin;
+	return end - begin;
+}
+
+bool FingerprintIndex::Save(const std::string &file_name) const
+{
+	if (!m_built) {
+		DEBUG("chromaprint::FingerprintIndex::Save() -- Index is not built.");
+		return false;
+	}
+
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+	header.byte_order = kFileByteOrderMark;
+	header.version = kFileVersion;
+	header.hash_bits = m_hash_bits;
+	header.num_docs = m_num_docs;
+	header.num_items = m_fingerprint_offsets_ptr[m_num_docs];
+	header.num_hashes = m_num_hashes;
+	header.num_postings = m_num_postings;
+
+	FileLayout layout;
+	GetFileLayout(header, UINT64_MAX, layout);
+
+	std::ofstream file(file_name.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!file) {
+		DEBUG("chromaprint::FingerprintIndex::Save() -- Could not open " << file_name);
+		return false;
+	}
+
+	uint64_t offset = 0;
+	auto write_section = [&](uint64_t section, const void *data, uint64_t size) {
+		static const char padding[kFileSectionAlignment] = { 0 };
+		file.write(padding, section - offset);
+		file.write(static_cast<const char *>(data), size);
+		offset = section + size;
+	};
+	write_section(0, &header, sizeof(header));
+	write_section(layout.ids, m_ids_ptr, header.num_docs * sizeof(uint32_t));
+	write_section(layout.fingerprint_offsets, m_fingerprint_offsets_ptr, (header.num_docs + 1) * sizeof(uint64_t));
+	write_section(layout.fingerprint_data, m_fingerprint_data_ptr, header.num_items * sizeof(uint32_t));
+	write_section(layout.hashes, m_hashes_ptr, header.num_hashes * sizeof(uint32_t));
+	write_section(layout.hash_offsets, m_hash_offsets_ptr, (header.num_hashes + 1) * sizeof(uint64_t));
+	write_section(layout.postings, m_postings_ptr, header.num_postings * sizeof(FingerprintIndexPosting));
+	assert(offset == layout.end);
+
+	file.close();
+	if (!file) {
+		DEBUG("chromaprint::FingerprintIndex::Save() -- Could not write " << file_name);
+		return false;
+	}
+	return true;
+}
+
+bool FingerprintIndex::Open(const std::string &file_name)
+{
+	MappedFile file;
+	if (!file.Open(file_name)) {
+		return false;
+	}
+
+	if (file.size() < sizeof(FileHeader)) {
+		DEBUG("chromaprint::FingerprintIndex::Open() -- Invalid index file (too short)");
+		return false;
+	}
+
+	FileHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0) {
+		DEBUG("chromaprint::FingerprintIndex::Open() -- Invalid index file (bad magic)");
+		return false;
+	}
+	if (header.byte_order != kFileByteOrderMark) {
+		DEBUG("chromaprint::FingerprintIndex::Open() -- Invalid index file (different byte order)");
+		return false;
+	}
+	if (header.version != kFileVersion) {
+		DEBUG("chromaprint::FingerprintIndex::Open() -- Unsupported index file version " << header.version);
+		return false;
+	}
+	if (header.hash_bits < 1 || header.hash_bits > 32) {
+		DEBUG("chromaprint::FingerprintIndex::Open() -- Invalid index file (bad hash bits)");
+		return false;
+	}
+
+	FileLayout layout;
+	if (!GetFileLayout(header, file.size(), layout)) {
+		DEBUG("chromaprint::FingerprintIndex::Open() -- Invalid index file (truncated)");
+		return false;
+	}
+
+	// Only the sizes are checked here, so that opening doesn't need to read
+	// the whole file. The offsets and postings are checked where they are
+	// used, see Verify() for a full check.
+	const auto data = file.data();
+	const auto fingerprint_offsets = reinterpret_cast<const uint64_t *>(data + layout.fingerprint_offsets);
+	const auto hash_offsets = reinterpret_cast<const uint64_t *>(data + layout.hash_offsets);
+	if (fingerprint_offsets[header.num_docs] != header.num_items || hash_offsets[header.num_hashes] != header.num_postings) {
+		DEBUG("chromaprint::FingerprintIndex::Open() -- Invalid index file (inconsistent sizes)");
+		return false;
+	}
+
+	Clear();
+	m_hash_bits = header.hash_bits;
+	m_num_docs = header.num_docs;
+	m_num_hashes = header.num_hashes;
+	m_num_postings = header.num_postings;
+	m_ids_ptr = reinterpret_cast<const uint32_t *>(data + layout.ids);
+	m_fingerprint_offsets_ptr = fingerprint_offsets;
+	m_fingerprint_data_ptr = reinterpret_cast<const uint32_t *>(data + layout.fingerprint_data);
+	m_hashes_ptr = reinterpret_cast<const uint32_t *>(data + layout.hashes);
+	m_hash_offsets_ptr = hash_offsets;
+	m_postings_ptr = reinterpret_cast<const FingerprintIndexPosting *>(data + layout.postings);
+	m_file.Swap(file);
+	return true;
+}
+
+bool FingerprintIndex::Verify() const
+{
+	for (size_t i = 0; i < m_num_docs; i++) {
+		if (m_fingerprint_offsets_ptr[i] > m_fingerprint_offsets_ptr[i + 1]) {
+			DEBUG("chromaprint::FingerprintIndex::Verify() -- Invalid fingerprint offsets");
+			return false;
+		}
+	}
+	for (size_t i = 0; i < m_num_hashes; i++) {
+		if (m_hash_offsets_ptr[i] > m_hash_offsets_ptr[i + 1] || (i > 0 && m_hashes_ptr[i - 1] >= m_hashes_ptr[i])) {
+			DEBUG("chromaprint::FingerprintIndex::Verify() -- Invalid hashes");
+			return false;
+		}
+	}
+	for (size_t i = 0; i < m_num_postings; i++) {
+		const auto &posting = m_postings_ptr[i];
+		if (posting.doc >= m_num_docs || posting.position >= m_fingerprint_offsets_ptr[posting.doc + 1] - m_fingerprint_offsets_ptr[posting.doc]) {
+			DEBUG("chromaprint::FingerprintIndex::Verify() -- Invalid postings");
+			return false;
+		}
+	}
+	return true;
+}
+
+}; // namespace chromaprint
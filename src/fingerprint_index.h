@@ -0,0 +1,158 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FINGERPRINT_INDEX_H_
+#define CHROMAPRINT_FINGERPRINT_INDEX_H_
+
+#include <cstddef>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "utils.h"
+#include "utils/mapped_file.h"
+
+namespace chromaprint {
+
+struct FingerprintIndexPosting
+{
+	uint32_t doc;
+	uint32_t position;
+};
+
+// Inverted index over the most significant bits of the fingerprint items.
+//
+// Fingerprints are added with AddFingerprint() and the index is made
+// searchable by calling Build(). The posting lists are stored in one
+// contiguous array, ordered by the hash, the document and the position,
+// with a sorted array of unique hashes pointing into it. The original
+// fingerprints are kept as well, so that candidates can be verified
+// using FingerprintMatcher.
+//
+// A built index can be written to a file with Save(). Open() maps such
+// file into memory and uses it directly, without decoding or copying
+// anything, so the pages are shared between all processes that have the
+// file open. Open() only checks the header and the section sizes, so it
+// takes the same time regardless of the index size. The offsets read from
+// the file are checked when they are used, so a corrupted file gives wrong
+// results instead of reads outside of the mapping. Verify() checks the
+// whole index, at the cost of reading all of it.
+//
+// File format (version 1), all integers in native byte order:
+//
+//   header:
+//     char[8]   magic "CPINDEX\0"
+//     uint32    byte order mark 0x01020304
+//     uint32    version
+//     uint32    hash bits
+//     uint32    reserved (0)
+//     uint64    number of documents (D)
+//     uint64    number of fingerprint items (N)
+//     uint64    number of unique hashes (H)
+//     uint64    number of postings (P)
+//   sections, each starting at a multiple of 64 bytes:
+//     uint32[D]        document IDs
+//     uint64[D + 1]    offsets of fingerprints in the item array
+//     uint32[N]        fingerprint items
+//     uint32[H]        sorted unique hashes
+//     uint64[H + 1]    offsets of posting lists in the posting array
+//     uint32[2 * P]    postings, (document, position) pairs
+class FingerprintIndex
+{
+public:
+	// Same as ACOUSTID_QUERY_BITS, use 12 for ALIGN_BITS compatible hashes.
+	static const int kDefaultHashBits = 28;
+
+	static const uint32_t kFileVersion = 1;
+
+	explicit FingerprintIndex(int hash_bits = kDefaultHashBits);
+
+	int hash_bits() const { return m_hash_bits; }
+
+	uint32_t GetHash(uint32_t x) const {
+		return x >> (32 - m_hash_bits);
+	}
+
+	//! Add a fingerprint to the index, it's not searchable until Build() is called.
+	void AddFingerprint(uint32_t id, const uint32_t *fp, size_t size);
+
+	void AddFingerprint(uint32_t id, const std::vector<uint32_t> &fp) {
+		AddFingerprint(id, fp.data(), fp.size());
+	}
+
+	//! Build the posting lists from all fingerprints added so far.
+	void Build();
+
+	//! Remove all fingerprints from the index.
+	void Clear();
+
+	//! Write the built index to a file.
+	bool Save(const std::string &file_name) const;
+
+	//! Replace the contents of the index with a memory mapped index file.
+	bool Open(const std::string &file_name);
+
+	//! Check that all offsets and postings are consistent, reads the whole index.
+	bool Verify() const;
+
+	bool is_mapped() const { return m_file.is_open(); }
+
+	size_t num_docs() const { return m_num_docs; }
+	size_t num_hashes() const { return m_num_hashes; }
+	size_t num_postings() const { return m_num_postings; }
+
+	uint32_t GetDocId(size_t doc) const {
+		assert(doc < m_num_docs);
+		return m_ids_ptr[doc];
+	}
+
+	const uint32_t *GetFingerprint(size_t doc, size_t *size) const {
+		assert(doc < m_num_docs);
+		const auto begin = m_fingerprint_offsets_ptr[doc];
+		const auto end = m_fingerprint_offsets_ptr[doc + 1];
+		if (begin > end || end > m_fingerprint_offsets_ptr[m_num_docs]) {
+			*size = 0;
+			return m_fingerprint_data_ptr;
+		}
+		*size = end - begin;
+		return m_fingerprint_data_ptr + begin;
+	}
+
+	//! Find the posting list for a hash, returns the number of postings.
+	size_t Lookup(uint32_t hash, const FingerprintIndexPosting **postings) const;
+
+private:
+	CHROMAPRINT_DISABLE_COPY(FingerprintIndex);
+
+	void UpdatePointers();
+	void Unmap();
+
+	int m_hash_bits;
+	bool m_built = true;
+
+	// owned data, used when the index is built in memory
+	std::vector<uint32_t> m_ids;
+	std::vector<uint64_t> m_fingerprint_offsets;
+	std::vector<uint32_t> m_fingerprint_data;
+	std::vector<uint32_t> m_hashes;
+	std::vector<uint64_t> m_hash_offsets;
+	std::vector<FingerprintIndexPosting> m_postings;
+
+	// mapped index file
+	MappedFile m_file;
+
+	// views of either the owned or the mapped data
+	size_t m_num_docs = 0;
+	size_t m_num_hashes = 0;
+	size_t m_num_postings = 0;
+	const uint32_t *m_ids_ptr = nullptr;
+	const uint64_t *m_fingerprint_offsets_ptr = nullptr;
+	const uint32_t *m_fingerprint_data_ptr = nullptr;
+	const uint32_t *m_hashes_ptr = nullptr;
+	const uint64_t *m_hash_offsets_ptr = nullptr;
+	const FingerprintIndexPosting *m_postings_ptr = nullptr;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -9,6 +9,7 @@
 #include "utils.h"
 #include "utils/gaussian_filter.h"
 #include "utils/gradient.h"
+#include "simd/simd.h"
 #include "debug.h"
 
 namespace chromaprint {
@@ -30,8 +31,18 @@ namespace chromaprint {
 #define UNIQ_MASK ((1 << MATCH_BITS) - 1)
 #define UNIQ_STRIP(x) ((uint32_t)(x) >> (32 - MATCH_BITS))
 
+// Small deterministic noise added to the bit counts, so that equal neighbouring
+// values do not produce flat gradients. This used to be rand(), which made the
+// results irreproducible and is not thread-safe.
+static inline float GetTieBreaker(size_t i)
+{
+	uint32_t x = uint32_t(i) * 2654435761u;
+	x ^= x >> 16;
+	return (x >> 8) * (0.001f / (1 << 24));
+}
+
 FingerprintMatcher::FingerprintMatcher(FingerprinterConfiguration *config)
-	: m_config(config)
+	: m_config(config), m_kernels(&GetSimdKernels())
 {
 }
 
@@ -55,6 +66,8 @@ bool FingerprintMatcher::Match(const uint32_t fp1_data[], size_t fp1_size, const
 	const uint32_t offset_mask = (1u << (32 - ALIGN_BITS - 1)) - 1;
 	const uint32_t source_mask = 1u << (32 - ALIGN_BITS - 1);
 
+	m_segments.clear();
+
 	if (fp1_size + 1 >= offset_mask) {
 		DEBUG("chromaprint::FingerprintMatcher::Match() -- Fingerprint 1 too long.");
 		return false;
@@ -113,49 +126,47 @@ bool FingerprintMatcher::Match(const uint32_t fp1_data[], size_t fp1_size, const
 	}
 	std::sort(m_best_alignments.rbegin(), m_best_alignments.rend());
 
-	m_segments.clear();
-
 	for (const auto &item : m_best_alignments) {
 		const int offset_diff = item.second - fp2_size;
 
 		const size_t offset1 = offset_diff > 0 ? offset_diff : 0;
 		const size_t offset2 = offset_diff < 0 ? -offset_diff : 0;
 
-		auto it1 = fp1_data + offset1;
-		auto it2 = fp2_data + offset2;
-
 		const auto size = std::min(fp1_size - offset1, fp2_size - offset2);
-		std::vector<float> bit_counts(size);
+		m_bit_errors.resize(size);
+		m_kernels->hamming_distance(fp1_data + offset1, fp2_data + offset2, size, m_bit_errors.data());
+
+		m_bit_counts.resize(size);
 		for (size_t i = 0; i < size; i++) {
-			bit_counts[i] = HammingDistance(*it1++, *it2++) + rand() * (0.001f / RAND_MAX);
+			m_bit_counts[i] = m_bit_errors[i] + GetTieBreaker(i);
 		}
 
-		std::vector<float> orig_bit_counts = bit_counts;
-		std::vector<float> smoothed_bit_counts;
-		GaussianFilter(bit_counts, smoothed_bit_counts, 8.0, 3);
+		// GaussianFilter uses its input as a scratch buffer, keep the original counts
+		m_orig_bit_counts.assign(m_bit_counts.begin(), m_bit_counts.end());
+		GaussianFilter(m_bit_counts, m_smoothed_bit_counts, 8.0, 3);
 
-		std::vector<float> gradient(size);
-		Gradient(smoothed_bit_counts.begin(), smoothed_bit_counts.end(), gradient.begin());
+		m_gradient.resize(size);
+		Gradient(m_smoothed_bit_counts.begin(), m_smoothed_bit_counts.end(), m_gradient.begin());
 
 		for (size_t i = 0; i < size; i++) {
-			gradient[i] = std::abs(gradient[i]);
+			m_gradient[i] = std::abs(m_gradient[i]);
 		}
 
-		std::vector<size_t> gradient_peaks;
+		m_gradient_peaks.clear();
 		for (size_t i = 0; i < size; i++) {
-			const auto gi = gradient[i];
-			if (i > 0 && i < size - 1 && gi > 0.15 && gi >= gradient[i - 1] && gi >= gradient[i + 1]) {
-				if (gradient_peaks.empty() || gradient_peaks.back() + 1 < i) {
-					gradient_peaks.push_back(i);
+			const auto gi = m_gradient[i];
+			if (i > 0 && i < size - 1 && gi > 0.15 && gi >= m_gradient[i - 1] && gi >= m_gradient[i + 1]) {
+				if (m_gradient_peaks.empty() || m_gradient_peaks.back() + 1 < i) {
+					m_gradient_peaks.push_back(i);
 				}
 			}
 		}
-		gradient_peaks.push_back(size);
+		m_gradient_peaks.push_back(size);
 
 		size_t begin = 0;
-		for (size_t end : gradient_peaks) {
+		for (size_t end : m_gradient_peaks) {
 			const auto duration = end - begin;
-			const auto score = std::accumulate(orig_bit_counts.begin() + begin, orig_bit_counts.begin() + end, 0.0) / duration;
+			const auto score = std::accumulate(m_orig_bit_counts.begin() + begin, m_orig_bit_counts.begin() + end, 0.0) / duration;
 			if (score < m_match_threshold) {
 				bool added = false;
 				if (!m_segments.empty()) {
@@ -12,6 +12,7 @@
 namespace chromaprint {
 
 class FingerprinterConfiguration;
+struct SimdKernels;
 
 struct Segment
 {
@@ -64,10 +65,18 @@ public:
 
 private:
 	std::unique_ptr<FingerprinterConfiguration> m_config;
+	const SimdKernels *m_kernels;
 	std::vector<uint32_t> m_offsets;
 	std::vector<uint32_t> m_histogram;
 	std::vector<std::pair<uint32_t, uint32_t>> m_best_alignments;
 	std::vector<Segment> m_segments;
+	// scratch buffers for segment scoring, kept to avoid allocations between calls
+	std::vector<uint32_t> m_bit_errors;
+	std::vector<float> m_bit_counts;
+	std::vector<float> m_orig_bit_counts;
+	std::vector<float> m_smoothed_bit_counts;
+	std::vector<float> m_gradient;
+	std::vector<size_t> m_gradient_peaks;
 	double m_match_threshold = kDefaultMatchThreshold;
 };
 
@@ -0,0 +1,89 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <algorithm>
+#include "fingerprint_searcher.h"
+#include "fingerprint_index.h"
+#include "debug.h"
+
+namespace chromaprint {
+
+// Offsets are stored in the lower half of the candidate, biased to keep them sorted.
+static const uint32_t kOffsetBias = 0x80000000u;
+
+FingerprintSearcher::FingerprintSearcher(const FingerprintIndex *index)
+	: m_index(index)
+{
+}
+
+size_t FingerprintSearcher::Search(const uint32_t *query, size_t size, size_t max_results, std::vector<FingerprintSearchResult> &results)
+{
+	const auto num_docs = m_index->num_docs();
+	m_candidates.clear();
+	for (size_t i = 0; i < size; i++) {
+		const FingerprintIndexPosting *postings;
+		const auto num_postings = m_index->Lookup(m_index->GetHash(query[i]), &postings);
+		if (m_max_posting_list_size > 0 && num_postings > m_max_posting_list_size) {
+			continue;
+		}
+		for (size_t j = 0; j < num_postings; j++) {
+			// postings in mapped files are not checked when the index is opened
+			if (postings[j].doc >= num_docs) {
+				continue;
+			}
+			const uint32_t offset = postings[j].position - uint32_t(i) + kOffsetBias;
+			m_candidates.push_back((uint64_t(postings[j].doc) << 32) | offset);
+		}
+	}
+	std::sort(m_candidates.begin(), m_candidates.end());
+
+	m_hits.clear();
+	m_offsets.clear();
+	auto it = m_candidates.cbegin();
+	const auto end = m_candidates.cend();
+	while (it != end) {
+		Hit hit { uint32_t(*it >> 32), 0, 0, m_offsets.size(), 0 };
+		while (it != end && uint32_t(*it >> 32) == hit.doc) {
+			const auto offset = uint32_t(*it);
+			uint32_t count = 0;
+			while (it != end && *it == ((uint64_t(hit.doc) << 32) | offset)) {
+				++count;
+				++it;
+			}
+			const auto signed_offset = int32_t(offset - kOffsetBias);
+			m_offsets.emplace_back(signed_offset, count);
+			if (count > hit.score) {
+				hit.score = count;
+				hit.offset = signed_offset;
+			}
+		}
+		hit.offsets_end = m_offsets.size();
+		if (hit.score >= m_min_score) {
+			m_hits.push_back(hit);
+		} else {
+			m_offsets.resize(hit.offsets_begin);
+		}
+	}
+
+	const auto num_results = std::min(max_results, m_hits.size());
+	std::partial_sort(m_hits.begin(), m_hits.begin() + num_results, m_hits.end(), [](const Hit &a, const Hit &b) {
+		if (a.score != b.score) {
+			return a.score > b.score;
+		}
+		return a.doc < b.doc;
+	});
+
+	results.resize(num_results);
+	for (size_t i = 0; i < num_results; i++) {
+		const auto &hit = m_hits[i];
+		auto &result = results[i];
+		result.doc = hit.doc;
+		result.id = m_index->GetDocId(hit.doc);
+		result.score = hit.score;
+		result.offset = hit.offset;
+		result.offsets.assign(m_offsets.begin() + hit.offsets_begin, m_offsets.begin() + hit.offsets_end);
+	}
+	return num_results;
+}
+
+}; // namespace chromaprint
@@ -0,0 +1,80 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_FINGERPRINT_SEARCHER_H_
+#define CHROMAPRINT_FINGERPRINT_SEARCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "utils.h"
+
+namespace chromaprint {
+
+class FingerprintIndex;
+
+struct FingerprintSearchResult
+{
+	// Internal document number, use with FingerprintIndex::GetFingerprint().
+	size_t doc;
+	// Fingerprint ID, as passed to FingerprintIndex::AddFingerprint().
+	uint32_t id;
+	// Number of matching hashes at the best offset.
+	uint32_t score;
+	// Best offset, position in the indexed fingerprint minus position in the query.
+	int32_t offset;
+	// All offsets with at least one matching hash and their counts, ordered by offset.
+	std::vector<std::pair<int32_t, uint32_t>> offsets;
+};
+
+// Finds candidate fingerprints in the index that share hashes with the query.
+//
+// Candidates are ranked by the number of hashes matching at the same offset.
+// The results are intended to be verified using FingerprintMatcher, which
+// chromaprint_searcher_search() does for the public API. The searcher keeps
+// its buffers between calls, so it is not thread-safe. Use one searcher per
+// thread, they can all share the same index.
+class FingerprintSearcher
+{
+public:
+	FingerprintSearcher(const FingerprintIndex *index);
+
+	// Hashes with more postings than this are ignored, 0 means no limit.
+	void set_max_posting_list_size(size_t size) { m_max_posting_list_size = size; }
+	size_t max_posting_list_size() const { return m_max_posting_list_size; }
+
+	// Candidates with fewer matching hashes at the best offset are ignored.
+	void set_min_score(uint32_t score) { m_min_score = score; }
+	uint32_t min_score() const { return m_min_score; }
+
+	//! Search for the query fingerprint and return up to max_results best candidates.
+	size_t Search(const uint32_t *query, size_t size, size_t max_results, std::vector<FingerprintSearchResult> &results);
+
+	size_t Search(const std::vector<uint32_t> &query, size_t max_results, std::vector<FingerprintSearchResult> &results) {
+		return Search(query.data(), query.size(), max_results, results);
+	}
+
+private:
+	CHROMAPRINT_DISABLE_COPY(FingerprintSearcher);
+
+	struct Hit
+	{
+		uint32_t doc;
+		uint32_t score;
+		int32_t offset;
+		size_t offsets_begin;
+		size_t offsets_end;
+	};
+
+	const FingerprintIndex *m_index;
+	size_t m_max_posting_list_size = 0;
+	uint32_t m_min_score = 1;
+	std::vector<uint64_t> m_candidates;
+	std::vector<std::pair<int32_t, uint32_t>> m_offsets;
+	std::vector<Hit> m_hits;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -2,6 +2,8 @@
 // Distributed under the MIT license, see the LICENSE file for details.
 
 #include <string.h>
+#include <algorithm>
+#include <thread>
 #include "fingerprinter.h"
 #include "chroma.h"
 #include "chroma_normalizer.h"
@@ -13,7 +15,9 @@
 #include "fingerprint_calculator.h"
 #include "fingerprinter_configuration.h"
 #include "classifier.h"
+#include "stats.h"
 #include "utils.h"
+#include "utils/state_buffer.h"
 #include "debug.h"
 
 namespace chromaprint {
@@ -21,16 +25,146 @@ namespace chromaprint {
 static const int MIN_FREQ = 28;
 static const int MAX_FREQ = 3520;
 
+// Minimum number of chroma rows worth processing on a separate thread.
+static const size_t kMinRowsPerSegment = 64;
+
+// Version of the saved state format, increase it when any stage changes
+// what it saves.
+static const uint32_t kStateVersion = 1;
+
+// The stages from the FFT frames to normalized chroma features, composed at
+// compile time and stored in one object. Each stage knows the exact type of
+// the next one, so the calls between them are not virtual and the compiler
+// can inline them.
+template <typename Consumer>
+class ChromaPipeline
+{
+public:
+	typedef BasicChromaNormalizer<Consumer> Normalizer;
+	typedef BasicChromaFilter<Normalizer> Filter;
+	typedef BasicChroma<Filter> Chroma;
+
+	ChromaPipeline(const FingerprinterConfiguration *config, Consumer *consumer)
+		: m_normalizer(consumer),
+		  m_filter(config->filter_coefficients(), config->num_filter_coefficients(), &m_normalizer),
+		  m_chroma(MIN_FREQ, MAX_FREQ, config->frame_size(), config->sample_rate(), &m_filter)
+	{
+		//m_chroma.set_interpolate(true);
+	}
+
+	Chroma *chroma() { return &m_chroma; }
+
+	void Reset() {
+		m_chroma.Reset();
+		m_filter.Reset();
+		m_normalizer.Reset();
+	}
+
+	// chroma and the normalizer only depend on the current frame
+	void SaveState(StateWriter &writer) const {
+		m_filter.SaveState(writer);
+	}
+
+	bool RestoreState(StateReader &reader) {
+		return m_filter.RestoreState(reader);
+	}
+
+private:
+	CHROMAPRINT_DISABLE_COPY(ChromaPipeline);
+
+	Normalizer m_normalizer;
+	Filter m_filter;
+	Chroma m_chroma;
+};
+
+class FeaturePipeline
+{
+public:
+	FeaturePipeline(const FingerprinterConfiguration *config)
+		: m_calculator(config->classifiers(), config->num_classifiers()),
+		  m_chroma(config, &m_calculator) {}
+
+	FFTFrameConsumer *chroma() { return m_chroma.chroma(); }
+	FingerprintCalculator *calculator() { return &m_calculator; }
+
+	void Reset() {
+		m_chroma.Reset();
+		m_calculator.Reset();
+	}
+
+	void SaveState(StateWriter &writer) const {
+		m_chroma.SaveState(writer);
+		m_calculator.SaveState(writer);
+	}
+
+	bool RestoreState(StateReader &reader) {
+		return m_chroma.RestoreState(reader) && m_calculator.RestoreState(reader);
+	}
+
+private:
+	CHROMAPRINT_DISABLE_COPY(FeaturePipeline);
+
+	FingerprintCalculator m_calculator;
+	ChromaPipeline<FingerprintCalculator> m_chroma;
+};
+
+namespace {
+
+class AudioCollector : public AudioConsumer
+{
+public:
+	AudioCollector(std::vector<int16_t> *data) : m_data(data) {}
+
+	void Consume(const int16_t *input, int length) override {
+		m_data->insert(m_data->end(), input, input + length);
+	}
+
+private:
+	std::vector<int16_t> *m_data;
+};
+
+// Stores consecutive feature vectors as rows of a flat array.
+class FeatureCollector : public FeatureVectorConsumer
+{
+public:
+	FeatureCollector(FeatureScalar *output, size_t max_rows) : m_output(output), m_max_rows(max_rows) {}
+
+	void Consume(FeatureVector &features) override final {
+		assert(m_num_rows < m_max_rows);
+		assert(features.size() == 12);
+		std::copy(features.begin(), features.end(), m_output + m_num_rows * 12);
+		m_num_rows++;
+	}
+
+	size_t num_rows() const { return m_num_rows; }
+
+private:
+	FeatureScalar *m_output;
+	size_t m_max_rows;
+	size_t m_num_rows = 0;
+};
+
+// Call func(0) .. func(count - 1), each on its own thread.
+template <typename Func>
+void RunParallel(size_t count, Func func) {
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < count; i++) {
+		threads.emplace_back(func, i);
+	}
+	func(0);
+	for (auto &thread : threads) {
+		thread.join();
+	}
+}
+
+};
+
 Fingerprinter::Fingerprinter(FingerprinterConfiguration *config) {
 	if (!config) {
 		config = new FingerprinterConfigurationTest1();
 	}
-	m_fingerprint_calculator = new FingerprintCalculator(config->classifiers(), config->num_classifiers());
-	m_chroma_normalizer = new ChromaNormalizer(m_fingerprint_calculator);
-	m_chroma_filter = new ChromaFilter(config->filter_coefficients(), config->num_filter_coefficients(), m_chroma_normalizer);
-	m_chroma = new Chroma(MIN_FREQ, MAX_FREQ, config->frame_size(), config->sample_rate(), m_chroma_filter);
-	//m_chroma->set_interpolate(true);
-	m_fft = new FFT(config->frame_size(), config->frame_overlap(), m_chroma);
+	m_pipeline = new FeaturePipeline(config);
+	m_fft = new FFT(config->frame_size(), config->frame_overlap(), m_pipeline->chroma());
 	if (config->remove_silence()) {
 		m_silence_remover = new SilenceRemover(m_fft);
 		m_silence_remover->set_threshold(config->silence_threshold());
@@ -50,10 +184,7 @@ Fingerprinter::~Fingerprinter()
 		delete m_silence_remover;
 	}
 	delete m_fft;
-	delete m_chroma;
-	delete m_chroma_filter;
-	delete m_chroma_normalizer;
-	delete m_fingerprint_calculator;
+	delete m_pipeline;
 	delete m_config;
 }
 
@@ -75,10 +206,7 @@ bool Fingerprinter::Start(int sample_rate, int num_channels)
 		return false;
 	}
 	m_fft->Reset();
-	m_chroma->Reset();
-	m_chroma_filter->Reset();
-	m_chroma_normalizer->Reset();
-	m_fingerprint_calculator->Reset();
+	m_pipeline->Reset();
 	return true;
 }
 
@@ -88,17 +216,164 @@ void Fingerprinter::Consume(const int16_t *samples, int length)
 	m_audio_processor->Consume(samples, length);
 }
 
+void Fingerprinter::ConsumePlanar(const int16_t *const *samples, int length)
+{
+	assert(length >= 0);
+	m_audio_processor->ConsumePlanar(samples, length);
+}
+
+void Fingerprinter::ConsumeFloat(const float *samples, int length)
+{
+	assert(length >= 0);
+	m_audio_processor->ConsumeFloat(samples, length);
+}
+
+void Fingerprinter::ConsumePlanarFloat(const float *const *samples, int length)
+{
+	assert(length >= 0);
+	m_audio_processor->ConsumePlanarFloat(samples, length);
+}
+
 void Fingerprinter::Finish()
 {
 	m_audio_processor->Flush();
 }
 
+// Resampling and silence removal can't be split without changing the result,
+// so they are done on the whole input first. The chroma features of each
+// frame only depend on the samples of a few frames, so the resampled audio
+// is split into segments, which overlap by the frames needed to fill the
+// chroma filter, and the features are calculated in parallel. The integral
+// image of the fingerprint calculator depends on all rows before, so the
+// last step is sequential, but it's cheap compared to the rest.
+bool Fingerprinter::ProcessParallel(int sample_rate, int num_channels, const int16_t *input, int length, int num_threads)
+{
+	assert(length >= 0);
+	if (!Start(sample_rate, num_channels)) {
+		return false;
+	}
+
+	std::vector<int16_t> samples;
+	AudioCollector collector(&samples);
+	if (m_silence_remover) {
+		m_silence_remover->set_consumer(&collector);
+	} else {
+		m_audio_processor->set_consumer(&collector);
+	}
+	m_audio_processor->Consume(input, length);
+	m_audio_processor->Flush();
+	if (m_silence_remover) {
+		m_silence_remover->set_consumer(m_fft);
+	} else {
+		m_audio_processor->set_consumer(m_fft);
+	}
+
+	const size_t frame_size = m_config->frame_size();
+	const size_t frame_overlap = m_config->frame_overlap();
+	const size_t increment = frame_size - frame_overlap;
+	const size_t filter_delay = m_config->num_filter_coefficients() - 1;
+	const size_t num_frames = samples.size() < frame_size ? 0 : (samples.size() - frame_size) / increment + 1;
+	const size_t num_rows = num_frames > filter_delay ? num_frames - filter_delay : 0;
+	if (!num_rows) {
+		return true;
+	}
+
+	if (num_threads <= 0) {
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	const size_t num_segments = std::max(size_t(1), std::min(size_t(num_threads), num_rows / kMinRowsPerSegment));
+
+#ifdef USE_STATS
+	auto parent_stats = g_stats_thread_state.stats;
+#endif
+	std::vector<Stats> segment_stats(num_segments);
+
+	// the FFT objects are created and destroyed on this thread, because the
+	// FFTW planner is not thread-safe, the workers only run the transforms
+	std::vector<FeatureScalar> features(num_rows * 12);
+	std::vector<std::unique_ptr<FeatureCollector>> segment_rows(num_segments);
+	std::vector<std::unique_ptr<ChromaPipeline<FeatureCollector>>> segment_pipelines(num_segments);
+	std::vector<std::unique_ptr<FFT>> segment_ffts(num_segments);
+	for (size_t segment = 0; segment < num_segments; segment++) {
+		const size_t begin = num_rows * segment / num_segments;
+		const size_t end = num_rows * (segment + 1) / num_segments;
+		segment_rows[segment].reset(new FeatureCollector(features.data() + begin * 12, end - begin));
+		segment_pipelines[segment].reset(new ChromaPipeline<FeatureCollector>(m_config, segment_rows[segment].get()));
+		segment_ffts[segment].reset(new FFT(frame_size, frame_overlap, segment_pipelines[segment]->chroma()));
+	}
+
+	RunParallel(num_segments, [&](size_t segment) {
+		CHROMAPRINT_STATS_SCOPE(&segment_stats[segment]);
+		const size_t begin = num_rows * segment / num_segments;
+		const size_t end = num_rows * (segment + 1) / num_segments;
+		const size_t first_sample = begin * increment;
+		const size_t last_sample = (end - 1 + filter_delay) * increment + frame_size;
+		segment_ffts[segment]->Consume(samples.data() + first_sample, last_sample - first_sample);
+		assert(segment_rows[segment]->num_rows() == end - begin);
+	});
+
+#ifdef USE_STATS
+	if (parent_stats) {
+		for (const auto &stats : segment_stats) {
+			parent_stats->Add(stats);
+		}
+	}
+#endif
+
+	FeatureVector row(12);
+	for (size_t i = 0; i < num_rows; i++) {
+		std::copy(features.begin() + i * 12, features.begin() + (i + 1) * 12, row.begin());
+		m_pipeline->calculator()->Consume(row);
+	}
+	return true;
+}
+
+bool Fingerprinter::SaveState(StateWriter &writer) const
+{
+	writer.Write(kStateVersion);
+	writer.Write(uint8_t(sizeof(FeatureScalar)));
+	if (!m_audio_processor->SaveState(writer)) {
+		return false;
+	}
+	if (m_silence_remover) {
+		m_silence_remover->SaveState(writer);
+	}
+	m_fft->SaveState(writer);
+	m_pipeline->SaveState(writer);
+	return true;
+}
+
+bool Fingerprinter::RestoreState(StateReader &reader)
+{
+	uint32_t version;
+	uint8_t feature_size;
+	if (!reader.Read(&version) || !reader.Read(&feature_size)) {
+		return false;
+	}
+	if (version != kStateVersion || feature_size != sizeof(FeatureScalar)) {
+		DEBUG("chromaprint::Fingerprinter::RestoreState() -- State was saved by an incompatible build.");
+		return false;
+	}
+	m_fft->Reset();
+	m_pipeline->Reset();
+	if (!m_audio_processor->RestoreState(reader) ||
+		(m_silence_remover && !m_silence_remover->RestoreState(reader)) ||
+		!m_fft->RestoreState(reader) ||
+		!m_pipeline->RestoreState(reader)) {
+		// don't leave a partially restored fingerprint behind
+		m_fft->Reset();
+		m_pipeline->Reset();
+		return false;
+	}
+	return true;
+}
+
 const std::vector<uint32_t> &Fingerprinter::GetFingerprint() const {
-	return m_fingerprint_calculator->GetFingerprint();
+	return m_pipeline->calculator()->GetFingerprint();
 }
 
 void Fingerprinter::ClearFingerprint() {
-	m_fingerprint_calculator->ClearFingerprint();
+	m_pipeline->calculator()->ClearFingerprint();
 }
 
 }; // namespace chromaprint
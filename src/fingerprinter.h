@@ -11,13 +11,12 @@
 namespace chromaprint {
 
 class FFT;
-class Chroma;
-class ChromaNormalizer;
-class ChromaFilter;
+class FeaturePipeline;
 class AudioProcessor;
-class FingerprintCalculator;
 class FingerprinterConfiguration;
 class SilenceRemover;
+class StateWriter;
+class StateReader;
 
 class Fingerprinter : public AudioConsumer
 {
@@ -36,11 +35,48 @@ public:
 	 */
 	void Consume(const int16_t *input, int length);
 
+	/**
+	 * Process a block of planar samples, one array per channel.
+	 * The length is the number of samples in each channel.
+	 */
+	void ConsumePlanar(const int16_t *const *input, int length);
+
+	/**
+	 * Process a block of interleaved float samples in the [-1, 1] range.
+	 */
+	void ConsumeFloat(const float *input, int length);
+
+	/**
+	 * Process a block of planar float samples, one array per channel.
+	 * The length is the number of samples in each channel.
+	 */
+	void ConsumePlanarFloat(const float *const *input, int length);
+
 	/**
 	 * Calculate the fingerprint based on the provided audio data.
 	 */
 	void Finish();
 
+	/**
+	 * Calculate the fingerprint of a complete audio stream, using up to
+	 * num_threads threads (or one per CPU core if it's 0). The result is
+	 * the same as from calling Start(), Consume() and Finish().
+	 */
+	bool ProcessParallel(int sample_rate, int num_channels, const int16_t *input, int length, int num_threads);
+
+	/**
+	 * Save the state of the stream that is being processed, including the
+	 * fingerprint calculated so far. Fails if no stream was started.
+	 */
+	bool SaveState(StateWriter &writer) const;
+
+	/**
+	 * Continue processing a stream from a state saved by SaveState(), which
+	 * replaces Start(). If it fails, the fingerprint is cleared and Start()
+	 * must be called again.
+	 */
+	bool RestoreState(StateReader &reader);
+
 	//! Get the fingerprint generate from data up to this point.
 	const std::vector<uint32_t> &GetFingerprint() const;
 
@@ -52,12 +88,9 @@ public:
 	const FingerprinterConfiguration *config() { return m_config; }
 
 private:
-	Chroma *m_chroma;
-	ChromaNormalizer *m_chroma_normalizer;
-	ChromaFilter *m_chroma_filter;
+	FeaturePipeline *m_pipeline;
 	FFT *m_fft;
 	AudioProcessor *m_audio_processor;
-	FingerprintCalculator *m_fingerprint_calculator;
 	FingerprinterConfiguration *m_config;
 	SilenceRemover *m_silence_remover;
 };
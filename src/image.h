@@ -62,7 +62,8 @@ public:
 	int NumColumns() const { return m_columns; }
 	int NumRows() const { return m_data.size() / m_columns; }
 
-	void AddRow(const std::vector<double> &row)
+	template <typename T>
+	void AddRow(const std::vector<T> &row)
 	{
 		m_data.resize(m_data.size() + m_columns);
 		std::copy(row.begin(), row.end(), m_data.end() - m_columns);
@@ -17,7 +17,7 @@ ImageBuilder::~ImageBuilder()
 {
 }
 
-void ImageBuilder::Consume(std::vector<double> &features)
+void ImageBuilder::Consume(FeatureVector &features)
 {
 	assert(features.size() == (size_t)m_image->NumColumns());
 	m_image->AddRow(features);
@@ -20,7 +20,7 @@ public:
 		set_image(image);
 	}
 
-	void Consume(std::vector<double> &features);
+	void Consume(FeatureVector &features);
 
 	Image *image() const {
 		return m_image;
@@ -5,6 +5,7 @@
 #define CHROMAPRINT_MOVING_AVERAGE_H_
 
 #include <vector>
+#include "utils/state_buffer.h"
 
 namespace chromaprint {
 
@@ -34,6 +35,36 @@ public:
 		return m_sum / m_count;
 	}
 
+	void SaveState(StateWriter &writer) const
+	{
+		writer.WriteArray(m_buffer);
+		writer.Write(int32_t(m_offset));
+		writer.Write(int32_t(m_count));
+	}
+
+	bool RestoreState(StateReader &reader)
+	{
+		std::vector<T> buffer;
+		int32_t offset, count;
+		if (!reader.ReadArray(&buffer, m_size) || buffer.size() != size_t(m_size)) {
+			return false;
+		}
+		if (!reader.Read(&offset) || !reader.Read(&count)) {
+			return false;
+		}
+		if (offset < 0 || offset >= m_size || count < 0 || count > m_size) {
+			return false;
+		}
+		m_buffer = buffer;
+		m_offset = offset;
+		m_count = count;
+		m_sum = 0;
+		for (const auto &x : m_buffer) {
+			m_sum += x;
+		}
+		return true;
+	}
+
 private:
 	std::vector<T> m_buffer;
 	int m_size;
@@ -0,0 +1,158 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <assert.h>
+#include <algorithm>
+extern "C" {
+#include "avresample/avcodec.h"
+}
+#include "polyphase_resampler.h"
+
+namespace chromaprint {
+
+// Longer periods are possible, but they are not common and the pattern
+// would not be much cheaper than stepping through the filter bank.
+static const int kMaxPeriod = 1024;
+
+// Short patterns are repeated, so that the kernels get enough work per call.
+static const int kMinPatternLength = 64;
+
+static int GreatestCommonDivisor(int a, int b)
+{
+	while (b) {
+		const int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+bool PolyphaseResampler::IsSupported(int out_rate, int in_rate)
+{
+	return out_rate > 0 && in_rate > 0 && out_rate / GreatestCommonDivisor(out_rate, in_rate) <= kMaxPeriod;
+}
+
+PolyphaseResampler::PolyphaseResampler(AVResampleContext *ctx, int out_rate, int in_rate)
+	: m_ctx(ctx), m_kernels(&GetSimdKernels())
+{
+	assert(IsSupported(out_rate, in_rate));
+	int filter_length;
+	const short *filter_bank = av_resample_get_filter_bank(ctx, &filter_length, &m_phase_shift);
+
+	// same as in av_resample_init()
+	m_src_incr = out_rate;
+	m_dst_incr = in_rate << m_phase_shift;
+
+	const int gcd = GreatestCommonDivisor(out_rate, in_rate);
+	const int repeat = (kMinPatternLength + out_rate / gcd - 1) / (out_rate / gcd);
+	m_period = repeat * (out_rate / gcd);
+	m_period_advance = repeat * (in_rate / gcd);
+
+	// the filters are padded with zeros, so that the kernels don't need to handle the remainder
+	m_filter_length = (filter_length + kResampleFilterAlign - 1) / kResampleFilterAlign * kResampleFilterAlign;
+	const size_t num_phases = size_t(1) << m_phase_shift;
+	m_filter_bank.resize(num_phases * m_filter_length);
+	for (size_t i = 0; i < num_phases; i++) {
+		std::copy(filter_bank + i * filter_length, filter_bank + (i + 1) * filter_length, m_filter_bank.begin() + i * m_filter_length);
+	}
+
+	m_offsets.resize(m_period + 1);
+	m_filters.resize(m_period);
+	m_phases.resize(m_period + 1);
+	m_fracs.resize(m_period + 1);
+}
+
+// Same as the position update in av_resample().
+void PolyphaseResampler::Advance(int *index, int *frac) const
+{
+	*frac += m_dst_incr % m_src_incr;
+	*index += m_dst_incr / m_src_incr;
+	if (*frac >= m_src_incr) {
+		*frac -= m_src_incr;
+		(*index)++;
+	}
+}
+
+void PolyphaseResampler::BuildPattern(int phase, int frac)
+{
+	const int phase_mask = (1 << m_phase_shift) - 1;
+	int index = phase;
+	for (size_t i = 0; i <= m_period; i++) {
+		m_offsets[i] = index >> m_phase_shift;
+		m_phases[i] = index & phase_mask;
+		m_fracs[i] = frac;
+		if (i < m_period) {
+			m_filters[i] = m_filter_bank.data() + m_phases[i] * m_filter_length;
+		}
+		Advance(&index, &frac);
+	}
+	assert(m_offsets[m_period] == m_period_advance);
+	assert(m_phases[m_period] == phase);
+	assert(m_fracs[m_period] == m_fracs[0]);
+}
+
+int PolyphaseResampler::Resample(int16_t *dst, const int16_t *src, int *consumed, int src_size, int dst_size)
+{
+	int state[AV_RESAMPLE_STATE_SIZE];
+	av_resample_get_state(m_ctx, state);
+	assert(state[2] == m_dst_incr && state[3] == 0);
+
+	int length = 0;
+	int offset = 0;
+
+	if (state[0] < 0) {
+		// at the start of the stream the filter reaches before the first
+		// sample, av_resample() handles that by mirroring the input
+		int index = state[0], frac = state[1], count = 0;
+		while (index < 0) {
+			Advance(&index, &frac);
+			count++;
+		}
+		length = av_resample(m_ctx, dst, src, &offset, src_size, std::min(count, dst_size), 1);
+		av_resample_get_state(m_ctx, state);
+		if (state[0] < 0) {
+			*consumed = offset;
+			return length;
+		}
+	}
+
+	BuildPattern(state[0], state[1]);
+
+	const int16_t *input = src + offset;
+	const size_t input_size = src_size - offset;
+	const size_t max_outputs = dst_size - length;
+	size_t num_outputs = 0;
+	size_t base = 0;
+	while (num_outputs < max_outputs) {
+		size_t count = std::min(m_period, max_outputs - num_outputs);
+		while (count > 0 && base + m_offsets[count - 1] + m_filter_length > input_size) {
+			count--;
+		}
+		if (!count) {
+			break;
+		}
+		m_kernels->resample(input + base, m_offsets.data(), m_filters.data(), m_filter_length, dst + length + num_outputs, count);
+		num_outputs += count;
+		if (count < m_period) {
+			break;
+		}
+		base += m_period_advance;
+	}
+	length += num_outputs;
+
+	// move to the next output sample and let av_resample() finish the input
+	const size_t i = num_outputs % m_period;
+	offset += (num_outputs / m_period) * m_period_advance + m_offsets[i];
+	state[0] = m_phases[i];
+	state[1] = m_fracs[i];
+	const int ret = av_resample_set_state(m_ctx, state);
+	assert(ret == 0);
+	(void) ret;
+
+	int rest_consumed = 0;
+	length += av_resample(m_ctx, dst + length, src + offset, &rest_consumed, src_size - offset, dst_size - length, 1);
+	*consumed = offset + rest_consumed;
+	return length;
+}
+
+}; // namespace chromaprint
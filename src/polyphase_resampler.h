@@ -0,0 +1,62 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_POLYPHASE_RESAMPLER_H_
+#define CHROMAPRINT_POLYPHASE_RESAMPLER_H_
+
+#include <stdint.h>
+#include <vector>
+#include "utils.h"
+#include "simd/simd.h"
+
+struct AVResampleContext;
+
+namespace chromaprint {
+
+// Faster implementation of av_resample() for sample rates with a simple ratio.
+//
+// av_resample() steps through its polyphase filter bank with a fixed point
+// position for each output sample. If the ratio of the sample rates is
+// simple, the input offsets and filter phases repeat after a short period,
+// e.g. after every output sample for 44100 -> 11025 Hz, or after every 147
+// output samples for 48000 -> 11025 Hz. The pattern is calculated once per
+// call and the filters are applied by the SIMD kernels, with the results
+// being exactly the same as from av_resample(). The start of the stream,
+// where the filter is mirrored, and the end of the input, where the
+// zero-padded filters don't fit, are left to av_resample(). The position is
+// stored in the resample context, so the two can be mixed freely.
+class PolyphaseResampler
+{
+public:
+	PolyphaseResampler(AVResampleContext *ctx, int out_rate, int in_rate);
+
+	//! Check if the ratio of the sample rates is simple enough.
+	static bool IsSupported(int out_rate, int in_rate);
+
+	//! Same as av_resample() with update_ctx set.
+	int Resample(int16_t *dst, const int16_t *src, int *consumed, int src_size, int dst_size);
+
+private:
+	CHROMAPRINT_DISABLE_COPY(PolyphaseResampler);
+
+	void Advance(int *index, int *frac) const;
+	void BuildPattern(int phase, int frac);
+
+	AVResampleContext *m_ctx;
+	const SimdKernels *m_kernels;
+	int m_phase_shift;
+	int m_src_incr;
+	int m_dst_incr;
+	size_t m_period;
+	size_t m_period_advance;
+	size_t m_filter_length;
+	std::vector<int16_t> m_filter_bank;
+	std::vector<uint32_t> m_offsets;
+	std::vector<const int16_t *> m_filters;
+	std::vector<int> m_phases;
+	std::vector<int> m_fracs;
+};
+
+}; // namespace chromaprint
+
+#endif
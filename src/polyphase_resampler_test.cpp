@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+extern "C" {
+#include "avresample/avcodec.h"
+}
+#include "polyphase_resampler.h"
+#include "utils/scope_exit.h"
+
+using namespace chromaprint;
+
+// Resample the input in chunks, keeping the unconsumed input like AudioProcessor does.
+static std::vector<int16_t> Resample(const std::vector<int16_t> &input, int out_rate, int in_rate, bool polyphase, size_t chunk_size, size_t dst_size)
+{
+	AVResampleContext *ctx = av_resample_init(out_rate, in_rate, 16, 8, 0, 0.8);
+	SCOPE_EXIT(av_resample_close(ctx));
+	std::unique_ptr<PolyphaseResampler> resampler;
+	if (polyphase) {
+		resampler.reset(new PolyphaseResampler(ctx, out_rate, in_rate));
+	}
+
+	std::vector<int16_t> buffer, output(dst_size), result;
+	for (size_t pos = 0; pos < input.size(); pos += chunk_size) {
+		buffer.insert(buffer.end(), input.begin() + pos, input.begin() + std::min(pos + chunk_size, input.size()));
+		int consumed = 0;
+		int length;
+		if (resampler) {
+			length = resampler->Resample(output.data(), buffer.data(), &consumed, buffer.size(), dst_size);
+		} else {
+			length = av_resample(ctx, output.data(), buffer.data(), &consumed, buffer.size(), dst_size, 1);
+		}
+		result.insert(result.end(), output.begin(), output.begin() + length);
+		buffer.erase(buffer.begin(), buffer.begin() + consumed);
+	}
+	return result;
+}
+
+TEST(PolyphaseResampler, IsSupported)
+{
+	EXPECT_TRUE(PolyphaseResampler::IsSupported(11025, 44100));
+	EXPECT_TRUE(PolyphaseResampler::IsSupported(11025, 48000));
+	EXPECT_TRUE(PolyphaseResampler::IsSupported(11025, 8000));
+	EXPECT_FALSE(PolyphaseResampler::IsSupported(11025, 44101));
+}
+
+TEST(PolyphaseResampler, SameAsAvResample)
+{
+	std::mt19937 rng(1234);
+	std::vector<int16_t> input(96000 * 2);
+	for (size_t i = 0; i < input.size(); i++) {
+		// a tone with noise and a clipped part, which saturates the output
+		const double tone = 20000.0 * std::sin(i * 0.05);
+		input[i] = int16_t(tone + int(rng() % 8192) - 4096);
+		if (i > input.size() / 2 && i < input.size() / 2 + 2000) {
+			input[i] = (i / 7) % 2 ? INT16_MAX : INT16_MIN;
+		}
+	}
+
+	const int rates[] = { 8000, 16000, 22050, 32000, 44100, 48000, 96000 };
+	const size_t chunk_sizes[][2] = { { 32768, 32768 }, { 777, 32768 }, { 4096, 333 } };
+	for (int in_rate : rates) {
+		ASSERT_TRUE(PolyphaseResampler::IsSupported(11025, in_rate));
+		for (const auto &sizes : chunk_sizes) {
+			const auto expected = Resample(input, 11025, in_rate, false, sizes[0], sizes[1]);
+			const auto output = Resample(input, 11025, in_rate, true, sizes[0], sizes[1]);
+			ASSERT_FALSE(expected.empty());
+			ASSERT_EQ(expected, output) << in_rate << " " << sizes[0] << " " << sizes[1];
+		}
+	}
+}
@@ -50,4 +50,23 @@ void SilenceRemover::Flush()
 {
 }
 
+void SilenceRemover::SaveState(StateWriter &writer) const
+{
+	writer.Write(uint8_t(m_start));
+	writer.Write(int32_t(m_threshold));
+	m_average.SaveState(writer);
+}
+
+bool SilenceRemover::RestoreState(StateReader &reader)
+{
+	uint8_t start;
+	int32_t threshold;
+	if (!reader.Read(&start) || !reader.Read(&threshold)) {
+		return false;
+	}
+	m_start = start != 0;
+	m_threshold = threshold;
+	return m_average.RestoreState(reader);
+}
+
 }; // namespace chromaprint
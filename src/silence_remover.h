@@ -29,6 +29,9 @@ public:
 	void Consume(const int16_t *input, int length) override;
 	void Flush();
 
+	void SaveState(StateWriter &writer) const;
+	bool RestoreState(StateReader &reader);
+
 	int threshold()
 	{
 		return m_threshold;
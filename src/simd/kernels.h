@@ -0,0 +1,169 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_SIMD_KERNELS_H_
+#define CHROMAPRINT_SIMD_KERNELS_H_
+
+#include "simd/simd.h"
+
+// Internal header for the kernel implementations. Every kernel file is
+// compiled with different instruction set flags, so the helpers here must
+// have internal linkage. An inline function with external linkage could be
+// merged by the linker with a copy compiled for a newer instruction set,
+// that's also the reason why the kernel files do not use utils.h or STL.
+
+namespace chromaprint {
+
+extern const SimdKernels kGenericKernels;
+#ifdef USE_SSE2
+extern const SimdKernels kSSE2Kernels;
+#endif
+#ifdef USE_AVX2
+extern const SimdKernels kAVX2Kernels;
+#endif
+#ifdef USE_AVX512
+extern const SimdKernels kAVX512Kernels;
+extern const SimdKernels kAVX512VPOPCNTDQKernels;
+#endif
+#ifdef USE_NEON
+extern const SimdKernels kNEONKernels;
+#endif
+
+namespace {
+
+inline void ApplyWindowScalar(const int16_t *input, const float *window, float *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		output[i] = input[i] * window[i];
+	}
+}
+
+inline void PowerSpectrumInterleavedScalar(const float *input, FeatureScalar *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		const float re = input[2 * i];
+		const float im = input[2 * i + 1];
+		output[i] = re * re + im * im;
+	}
+}
+
+inline void PowerSpectrumSplitScalar(const float *real, const float *imag, FeatureScalar *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		output[i] = real[i] * real[i] + imag[i] * imag[i];
+	}
+}
+
+inline FeatureScalar ReduceSumLanes(const FeatureScalar *acc)
+{
+	static_assert(kSumLanes == 8, "the kernels assume 8 partial sums");
+	return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+// Adds the remaining less than kSumLanes elements to the partial sums and reduces them.
+inline FeatureScalar SumTailScalar(FeatureScalar *acc, const FeatureScalar *input, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		acc[i] += input[i];
+	}
+	return ReduceSumLanes(acc);
+}
+
+inline uint32_t PopCountScalar(uint32_t v)
+{
+	v = v - ((v >> 1) & 0x55555555);
+	v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+	v = (v + (v >> 4)) & 0x0F0F0F0F;
+	return (v * 0x01010101) >> 24;
+}
+
+inline void HammingDistanceScalar(const uint32_t *a, const uint32_t *b, size_t size, uint32_t *output)
+{
+	for (size_t i = 0; i < size; i++) {
+		output[i] = PopCountScalar(a[i] ^ b[i]);
+	}
+}
+
+inline void DownmixStereoScalar(const int16_t *input, int16_t *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		output[i] = int16_t((int32_t(input[2 * i]) + input[2 * i + 1]) / 2);
+	}
+}
+
+inline void DownmixStereoPlanarScalar(const int16_t *left, const int16_t *right, int16_t *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		output[i] = int16_t((int32_t(left[i]) + right[i]) / 2);
+	}
+}
+
+// The result always fits into int16_t, because the sum of the weights is at most one.
+inline int16_t RoundDownmixSum(int32_t sum)
+{
+	return int16_t((sum + (1 << (kDownmixWeightBits - 1))) >> kDownmixWeightBits);
+}
+
+inline void DownmixWeightedScalar(const int16_t *input, const int16_t *weights, size_t num_channels, int16_t *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		int32_t sum = 0;
+		for (size_t c = 0; c < num_channels; c++) {
+			sum += int32_t(input[c]) * weights[c];
+		}
+		output[i] = RoundDownmixSum(sum);
+		input += num_channels;
+	}
+}
+
+inline void DownmixWeightedPlanarScalar(const int16_t *const *input, size_t offset, const int16_t *weights, size_t num_channels, int16_t *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		int32_t sum = 0;
+		for (size_t c = 0; c < num_channels; c++) {
+			sum += int32_t(input[c][offset + i]) * weights[c];
+		}
+		output[i] = RoundDownmixSum(sum);
+	}
+}
+
+inline int16_t RoundResampleSum(int32_t sum)
+{
+	sum = (sum + (1 << (kResampleFilterBits - 1))) >> kResampleFilterBits;
+	return int16_t(sum < INT16_MIN ? INT16_MIN : (sum > INT16_MAX ? INT16_MAX : sum));
+}
+
+inline int32_t ResampleDotScalar(const int16_t *input, const int16_t *filter, size_t filter_length)
+{
+	int32_t sum = 0;
+	for (size_t k = 0; k < filter_length; k++) {
+		sum += int32_t(input[k]) * filter[k];
+	}
+	return sum;
+}
+
+inline void ResampleScalar(const int16_t *input, const uint32_t *offsets, const int16_t *const *filters, size_t filter_length, int16_t *output, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		output[i] = RoundResampleSum(ResampleDotScalar(input + offsets[i], filters[i], filter_length));
+	}
+}
+
+inline void FFTButterflyScalar(float *real1, float *imag1, float *real2, float *imag2, const float *twiddle_real, const float *twiddle_imag, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		const float re1 = real1[i], im1 = imag1[i];
+		const float re2 = real2[i], im2 = imag2[i];
+		const float dr = re1 - re2, di = im1 - im2;
+		real1[i] = re1 + re2;
+		imag1[i] = im1 + im2;
+		real2[i] = dr * twiddle_real[i] - di * twiddle_imag[i];
+		imag2[i] = dr * twiddle_imag[i] + di * twiddle_real[i];
+	}
+}
+
+}; // namespace
+
+}; // namespace chromaprint
+
+#endif
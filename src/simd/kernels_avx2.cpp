@@ -0,0 +1,143 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <immintrin.h>
+#include "simd/kernels.h"
+#include "simd/kernels_x86.h"
+
+namespace chromaprint {
+
+static void ApplyWindowAVX2(const int16_t *input, const float *window, float *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+		const __m256 y = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x));
+		_mm256_storeu_ps(output + i, _mm256_mul_ps(y, _mm256_loadu_ps(window + i)));
+	}
+	ApplyWindowScalar(input + i, window + i, output + i, size - i);
+}
+
+static inline void StoreFeatures(FeatureScalar *output, __m256 x)
+{
+#ifdef USE_FLOAT_FEATURES
+	_mm256_storeu_ps(output, x);
+#else
+	_mm256_storeu_pd(output, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+	_mm256_storeu_pd(output + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+#endif
+}
+
+static void PowerSpectrumInterleavedAVX2(const float *input, FeatureScalar *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256 a = _mm256_loadu_ps(input + 2 * i);
+		const __m256 b = _mm256_loadu_ps(input + 2 * i + 8);
+		const __m256 a2 = _mm256_mul_ps(a, a);
+		const __m256 b2 = _mm256_mul_ps(b, b);
+		// the shuffles work within 128-bit lanes, the permute restores the order
+		const __m256 re2 = _mm256_shuffle_ps(a2, b2, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m256 im2 = _mm256_shuffle_ps(a2, b2, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m256 x = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_add_ps(re2, im2)), _MM_SHUFFLE(3, 1, 2, 0)));
+		StoreFeatures(output + i, x);
+	}
+	PowerSpectrumInterleavedScalar(input + 2 * i, output + i, size - i);
+}
+
+static void PowerSpectrumSplitAVX2(const float *real, const float *imag, FeatureScalar *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256 re = _mm256_loadu_ps(real + i);
+		const __m256 im = _mm256_loadu_ps(imag + i);
+		StoreFeatures(output + i, _mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im)));
+	}
+	PowerSpectrumSplitScalar(real + i, imag + i, output + i, size - i);
+}
+
+static FeatureScalar SumAVX2(const FeatureScalar *input, size_t size)
+{
+	alignas(32) FeatureScalar acc[kSumLanes];
+	size_t i = 0;
+#ifdef USE_FLOAT_FEATURES
+	__m256 acc0 = _mm256_setzero_ps();
+	for (; i + 8 <= size; i += 8) {
+		acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(input + i));
+	}
+	_mm256_store_ps(acc, acc0);
+#else
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	for (; i + 8 <= size; i += 8) {
+		acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(input + i));
+		acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(input + i + 4));
+	}
+	_mm256_store_pd(acc, acc0);
+	_mm256_store_pd(acc + 4, acc1);
+#endif
+	return SumTailScalar(acc, input + i, size - i);
+}
+
+// Counts the bits in each 32-bit lane, using a lookup table for each 4-bit nibble.
+static inline __m256i PopCount32x8(__m256i x)
+{
+	const __m256i lookup = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0F);
+	const __m256i lo = _mm256_and_si256(x, low_mask);
+	const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+	const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+	const __m256i counts16 = _mm256_maddubs_epi16(counts, _mm256_set1_epi8(1));
+	return _mm256_madd_epi16(counts16, _mm256_set1_epi16(1));
+}
+
+static void HammingDistanceAVX2(const uint32_t *a, const uint32_t *b, size_t size, uint32_t *output)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256i x = _mm256_xor_si256(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), PopCount32x8(x));
+	}
+	for (; i < size; i++) {
+		output[i] = _mm_popcnt_u32(a[i] ^ b[i]);
+	}
+}
+
+static void FFTButterflyAVX2(float *real, float *imag, const float *twiddle_real, const float *twiddle_imag, size_t size)
+{
+	float *real2 = real + size;
+	float *imag2 = imag + size;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256 re1 = _mm256_loadu_ps(real + i), im1 = _mm256_loadu_ps(imag + i);
+		const __m256 re2 = _mm256_loadu_ps(real2 + i), im2 = _mm256_loadu_ps(imag2 + i);
+		const __m256 wr = _mm256_loadu_ps(twiddle_real + i), wi = _mm256_loadu_ps(twiddle_imag + i);
+		const __m256 dr = _mm256_sub_ps(re1, re2), di = _mm256_sub_ps(im1, im2);
+		_mm256_storeu_ps(real + i, _mm256_add_ps(re1, re2));
+		_mm256_storeu_ps(imag + i, _mm256_add_ps(im1, im2));
+		_mm256_storeu_ps(real2 + i, _mm256_sub_ps(_mm256_mul_ps(dr, wr), _mm256_mul_ps(di, wi)));
+		_mm256_storeu_ps(imag2 + i, _mm256_add_ps(_mm256_mul_ps(dr, wi), _mm256_mul_ps(di, wr)));
+	}
+	FFTButterflyScalar(real + i, imag + i, real2 + i, imag2 + i, twiddle_real + i, twiddle_imag + i, size - i);
+}
+
+extern const SimdKernels kAVX2Kernels = {
+	SimdLevel::AVX2,
+	ApplyWindowAVX2,
+	PowerSpectrumInterleavedAVX2,
+	PowerSpectrumSplitAVX2,
+	SumAVX2,
+	HammingDistanceAVX2,
+	FFTButterflyAVX2,
+	DownmixStereoX86,
+	DownmixStereoPlanarX86,
+	DownmixWeightedX86,
+	DownmixWeightedPlanarX86,
+	ResampleAVX2,
+};
+
+}; // namespace chromaprint
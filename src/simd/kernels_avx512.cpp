@@ -0,0 +1,176 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#if defined(__GNUC__) && !defined(__clang__)
+// false positives in the AVX-512 intrinsics, see GCC bug 105593
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+#include "simd/kernels.h"
+#include "simd/kernels_x86.h"
+
+namespace chromaprint {
+
+static void ApplyWindowAVX512(const int16_t *input, const float *window, float *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+		const __m512 y = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(x));
+		_mm512_storeu_ps(output + i, _mm512_mul_ps(y, _mm512_loadu_ps(window + i)));
+	}
+	ApplyWindowScalar(input + i, window + i, output + i, size - i);
+}
+
+static inline void StoreFeatures(FeatureScalar *output, __m512 x)
+{
+#ifdef USE_FLOAT_FEATURES
+	_mm512_storeu_ps(output, x);
+#else
+	const __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1));
+	_mm512_storeu_pd(output, _mm512_cvtps_pd(_mm512_castps512_ps256(x)));
+	_mm512_storeu_pd(output + 8, _mm512_cvtps_pd(hi));
+#endif
+}
+
+static void PowerSpectrumInterleavedAVX512(const float *input, FeatureScalar *output, size_t size)
+{
+	const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+	const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const __m512 a = _mm512_loadu_ps(input + 2 * i);
+		const __m512 b = _mm512_loadu_ps(input + 2 * i + 16);
+		const __m512 a2 = _mm512_mul_ps(a, a);
+		const __m512 b2 = _mm512_mul_ps(b, b);
+		const __m512 re2 = _mm512_permutex2var_ps(a2, even, b2);
+		const __m512 im2 = _mm512_permutex2var_ps(a2, odd, b2);
+		StoreFeatures(output + i, _mm512_add_ps(re2, im2));
+	}
+	PowerSpectrumInterleavedScalar(input + 2 * i, output + i, size - i);
+}
+
+static void PowerSpectrumSplitAVX512(const float *real, const float *imag, FeatureScalar *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const __m512 re = _mm512_loadu_ps(real + i);
+		const __m512 im = _mm512_loadu_ps(imag + i);
+		StoreFeatures(output + i, _mm512_add_ps(_mm512_mul_ps(re, re), _mm512_mul_ps(im, im)));
+	}
+	PowerSpectrumSplitScalar(real + i, imag + i, output + i, size - i);
+}
+
+static FeatureScalar SumAVX512(const FeatureScalar *input, size_t size)
+{
+	alignas(64) FeatureScalar acc[kSumLanes];
+	size_t i = 0;
+#ifdef USE_FLOAT_FEATURES
+	__m256 acc0 = _mm256_setzero_ps();
+	for (; i + 8 <= size; i += 8) {
+		acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(input + i));
+	}
+	_mm256_store_ps(acc, acc0);
+#else
+	__m512d acc0 = _mm512_setzero_pd();
+	for (; i + 8 <= size; i += 8) {
+		acc0 = _mm512_add_pd(acc0, _mm512_loadu_pd(input + i));
+	}
+	_mm512_store_pd(acc, acc0);
+#endif
+	return SumTailScalar(acc, input + i, size - i);
+}
+
+// Counts the bits in each 32-bit lane, using a lookup table for each 4-bit nibble.
+static inline __m256i PopCount32x8(__m256i x)
+{
+	const __m256i lookup = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0F);
+	const __m256i lo = _mm256_and_si256(x, low_mask);
+	const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+	const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+	const __m256i counts16 = _mm256_maddubs_epi16(counts, _mm256_set1_epi8(1));
+	return _mm256_madd_epi16(counts16, _mm256_set1_epi16(1));
+}
+
+static void HammingDistanceAVX512(const uint32_t *a, const uint32_t *b, size_t size, uint32_t *output)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256i x = _mm256_xor_si256(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), PopCount32x8(x));
+	}
+	for (; i < size; i++) {
+		output[i] = _mm_popcnt_u32(a[i] ^ b[i]);
+	}
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx512f,avx512vpopcntdq")))
+#endif
+static void HammingDistanceAVX512VPOPCNTDQ(const uint32_t *a, const uint32_t *b, size_t size, uint32_t *output)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const __m512i x = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+		_mm512_storeu_si512(output + i, _mm512_popcnt_epi32(x));
+	}
+	for (; i < size; i++) {
+		output[i] = _mm_popcnt_u32(a[i] ^ b[i]);
+	}
+}
+
+static void FFTButterflyAVX512(float *real, float *imag, const float *twiddle_real, const float *twiddle_imag, size_t size)
+{
+	float *real2 = real + size;
+	float *imag2 = imag + size;
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const __m512 re1 = _mm512_loadu_ps(real + i), im1 = _mm512_loadu_ps(imag + i);
+		const __m512 re2 = _mm512_loadu_ps(real2 + i), im2 = _mm512_loadu_ps(imag2 + i);
+		const __m512 wr = _mm512_loadu_ps(twiddle_real + i), wi = _mm512_loadu_ps(twiddle_imag + i);
+		const __m512 dr = _mm512_sub_ps(re1, re2), di = _mm512_sub_ps(im1, im2);
+		_mm512_storeu_ps(real + i, _mm512_add_ps(re1, re2));
+		_mm512_storeu_ps(imag + i, _mm512_add_ps(im1, im2));
+		_mm512_storeu_ps(real2 + i, _mm512_sub_ps(_mm512_mul_ps(dr, wr), _mm512_mul_ps(di, wi)));
+		_mm512_storeu_ps(imag2 + i, _mm512_add_ps(_mm512_mul_ps(dr, wi), _mm512_mul_ps(di, wr)));
+	}
+	FFTButterflyScalar(real + i, imag + i, real2 + i, imag2 + i, twiddle_real + i, twiddle_imag + i, size - i);
+}
+
+extern const SimdKernels kAVX512Kernels = {
+	SimdLevel::AVX512,
+	ApplyWindowAVX512,
+	PowerSpectrumInterleavedAVX512,
+	PowerSpectrumSplitAVX512,
+	SumAVX512,
+	HammingDistanceAVX512,
+	FFTButterflyAVX512,
+	DownmixStereoX86,
+	DownmixStereoPlanarX86,
+	DownmixWeightedX86,
+	DownmixWeightedPlanarX86,
+	ResampleAVX2,
+};
+
+extern const SimdKernels kAVX512VPOPCNTDQKernels = {
+	SimdLevel::AVX512,
+	ApplyWindowAVX512,
+	PowerSpectrumInterleavedAVX512,
+	PowerSpectrumSplitAVX512,
+	SumAVX512,
+	HammingDistanceAVX512VPOPCNTDQ,
+	FFTButterflyAVX512,
+	DownmixStereoX86,
+	DownmixStereoPlanarX86,
+	DownmixWeightedX86,
+	DownmixWeightedPlanarX86,
+	ResampleAVX2,
+};
+
+}; // namespace chromaprint
@@ -0,0 +1,40 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include "simd/kernels.h"
+
+namespace chromaprint {
+
+static FeatureScalar SumGeneric(const FeatureScalar *input, size_t size)
+{
+	FeatureScalar acc[kSumLanes] = { 0 };
+	size_t i = 0;
+	for (; i + kSumLanes <= size; i += kSumLanes) {
+		for (size_t j = 0; j < kSumLanes; j++) {
+			acc[j] += input[i + j];
+		}
+	}
+	return SumTailScalar(acc, input + i, size - i);
+}
+
+static void FFTButterflyGeneric(float *real, float *imag, const float *twiddle_real, const float *twiddle_imag, size_t size)
+{
+	FFTButterflyScalar(real, imag, real + size, imag + size, twiddle_real, twiddle_imag, size);
+}
+
+extern const SimdKernels kGenericKernels = {
+	SimdLevel::Generic,
+	ApplyWindowScalar,
+	PowerSpectrumInterleavedScalar,
+	PowerSpectrumSplitScalar,
+	SumGeneric,
+	HammingDistanceScalar,
+	FFTButterflyGeneric,
+	DownmixStereoScalar,
+	DownmixStereoPlanarScalar,
+	DownmixWeightedScalar,
+	DownmixWeightedPlanarScalar,
+	ResampleScalar,
+};
+
+}; // namespace chromaprint
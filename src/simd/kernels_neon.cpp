@@ -0,0 +1,261 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <arm_neon.h>
+#include "simd/kernels.h"
+
+namespace chromaprint {
+
+static void ApplyWindowNEON(const int16_t *input, const float *window, float *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const int16x8_t x = vld1q_s16(input + i);
+		const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+		const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+		vst1q_f32(output + i, vmulq_f32(lo, vld1q_f32(window + i)));
+		vst1q_f32(output + i + 4, vmulq_f32(hi, vld1q_f32(window + i + 4)));
+	}
+	ApplyWindowScalar(input + i, window + i, output + i, size - i);
+}
+
+static inline void StoreFeatures(FeatureScalar *output, float32x4_t x)
+{
+#ifdef USE_FLOAT_FEATURES
+	vst1q_f32(output, x);
+#else
+	vst1q_f64(output, vcvt_f64_f32(vget_low_f32(x)));
+	vst1q_f64(output + 2, vcvt_f64_f32(vget_high_f32(x)));
+#endif
+}
+
+static void PowerSpectrumInterleavedNEON(const float *input, FeatureScalar *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const float32x4x2_t x = vld2q_f32(input + 2 * i);
+		StoreFeatures(output + i, vaddq_f32(vmulq_f32(x.val[0], x.val[0]), vmulq_f32(x.val[1], x.val[1])));
+	}
+	PowerSpectrumInterleavedScalar(input + 2 * i, output + i, size - i);
+}
+
+static void PowerSpectrumSplitNEON(const float *real, const float *imag, FeatureScalar *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const float32x4_t re = vld1q_f32(real + i);
+		const float32x4_t im = vld1q_f32(imag + i);
+		StoreFeatures(output + i, vaddq_f32(vmulq_f32(re, re), vmulq_f32(im, im)));
+	}
+	PowerSpectrumSplitScalar(real + i, imag + i, output + i, size - i);
+}
+
+static FeatureScalar SumNEON(const FeatureScalar *input, size_t size)
+{
+	FeatureScalar acc[kSumLanes];
+	size_t i = 0;
+#ifdef USE_FLOAT_FEATURES
+	float32x4_t acc0 = vdupq_n_f32(0.0f);
+	float32x4_t acc1 = vdupq_n_f32(0.0f);
+	for (; i + 8 <= size; i += 8) {
+		acc0 = vaddq_f32(acc0, vld1q_f32(input + i));
+		acc1 = vaddq_f32(acc1, vld1q_f32(input + i + 4));
+	}
+	vst1q_f32(acc, acc0);
+	vst1q_f32(acc + 4, acc1);
+#else
+	float64x2_t acc0 = vdupq_n_f64(0.0);
+	float64x2_t acc1 = vdupq_n_f64(0.0);
+	float64x2_t acc2 = vdupq_n_f64(0.0);
+	float64x2_t acc3 = vdupq_n_f64(0.0);
+	for (; i + 8 <= size; i += 8) {
+		acc0 = vaddq_f64(acc0, vld1q_f64(input + i));
+		acc1 = vaddq_f64(acc1, vld1q_f64(input + i + 2));
+		acc2 = vaddq_f64(acc2, vld1q_f64(input + i + 4));
+		acc3 = vaddq_f64(acc3, vld1q_f64(input + i + 6));
+	}
+	vst1q_f64(acc, acc0);
+	vst1q_f64(acc + 2, acc1);
+	vst1q_f64(acc + 4, acc2);
+	vst1q_f64(acc + 6, acc3);
+#endif
+	return SumTailScalar(acc, input + i, size - i);
+}
+
+static void HammingDistanceNEON(const uint32_t *a, const uint32_t *b, size_t size, uint32_t *output)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const uint32x4_t x = veorq_u32(vld1q_u32(a + i), vld1q_u32(b + i));
+		const uint8x16_t counts = vcntq_u8(vreinterpretq_u8_u32(x));
+		vst1q_u32(output + i, vpaddlq_u16(vpaddlq_u8(counts)));
+	}
+	HammingDistanceScalar(a + i, b + i, size - i, output + i);
+}
+
+static void FFTButterflyNEON(float *real, float *imag, const float *twiddle_real, const float *twiddle_imag, size_t size)
+{
+	float *real2 = real + size;
+	float *imag2 = imag + size;
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const float32x4_t re1 = vld1q_f32(real + i), im1 = vld1q_f32(imag + i);
+		const float32x4_t re2 = vld1q_f32(real2 + i), im2 = vld1q_f32(imag2 + i);
+		const float32x4_t wr = vld1q_f32(twiddle_real + i), wi = vld1q_f32(twiddle_imag + i);
+		const float32x4_t dr = vsubq_f32(re1, re2), di = vsubq_f32(im1, im2);
+		vst1q_f32(real + i, vaddq_f32(re1, re2));
+		vst1q_f32(imag + i, vaddq_f32(im1, im2));
+		// separate multiplies, vmlaq_f32 may be fused and would change the results
+		vst1q_f32(real2 + i, vsubq_f32(vmulq_f32(dr, wr), vmulq_f32(di, wi)));
+		vst1q_f32(imag2 + i, vaddq_f32(vmulq_f32(dr, wi), vmulq_f32(di, wr)));
+	}
+	FFTButterflyScalar(real + i, imag + i, real2 + i, imag2 + i, twiddle_real + i, twiddle_imag + i, size - i);
+}
+
+// (x + (x < 0)) >> 1 is x / 2 rounded towards zero
+static inline int32x4_t HalveNEON(int32x4_t x)
+{
+	return vshrq_n_s32(vaddq_s32(x, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(x), 31))), 1);
+}
+
+static inline int16x8_t AverageNEON(int16x8_t a, int16x8_t b)
+{
+	const int32x4_t lo = vaddl_s16(vget_low_s16(a), vget_low_s16(b));
+	const int32x4_t hi = vaddl_s16(vget_high_s16(a), vget_high_s16(b));
+	return vcombine_s16(vmovn_s32(HalveNEON(lo)), vmovn_s32(HalveNEON(hi)));
+}
+
+static void DownmixStereoNEON(const int16_t *input, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const int16x8x2_t x = vld2q_s16(input + 2 * i);
+		vst1q_s16(output + i, AverageNEON(x.val[0], x.val[1]));
+	}
+	DownmixStereoScalar(input + 2 * i, output + i, size - i);
+}
+
+static void DownmixStereoPlanarNEON(const int16_t *left, const int16_t *right, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		vst1q_s16(output + i, AverageNEON(vld1q_s16(left + i), vld1q_s16(right + i)));
+	}
+	DownmixStereoPlanarScalar(left + i, right + i, output + i, size - i);
+}
+
+// vrshrq_n_s32 adds half before shifting, which is the same as RoundDownmixSum()
+static inline int16x4_t RoundDownmixSumNEON(int32x4_t x)
+{
+	return vmovn_s32(vrshrq_n_s32(x, kDownmixWeightBits));
+}
+
+// Lane j of x[k] is channel k + n * (j % 2) of frame j / 2.
+static inline int16x4_t DownmixFourFramesNEON(const int16x8_t *x, const int16x8_t *weights, int n)
+{
+	int32x4_t lo = vdupq_n_s32(0);
+	int32x4_t hi = vdupq_n_s32(0);
+	for (int k = 0; k < n; k++) {
+		lo = vmlal_s16(lo, vget_low_s16(x[k]), vget_low_s16(weights[k]));
+		hi = vmlal_s16(hi, vget_high_s16(x[k]), vget_high_s16(weights[k]));
+	}
+	return RoundDownmixSumNEON(vpaddq_s32(lo, hi));
+}
+
+static void DownmixWeightedNEON(const int16_t *input, const int16_t *weights, size_t num_channels, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	if (num_channels == 6 || num_channels == 8) {
+		// vld3q/vld4q split four frames into three/four vectors with two
+		// channels of each frame
+		const int n = int(num_channels / 2);
+		int16x8_t w[4];
+		for (int k = 0; k < n; k++) {
+			int16_t lanes[8];
+			for (int j = 0; j < 8; j++) {
+				lanes[j] = weights[k + n * (j % 2)];
+			}
+			w[k] = vld1q_s16(lanes);
+		}
+		for (; i + 4 <= size; i += 4) {
+			int16x8_t x[4];
+			if (n == 4) {
+				const int16x8x4_t v = vld4q_s16(input + 8 * i);
+				x[0] = v.val[0];
+				x[1] = v.val[1];
+				x[2] = v.val[2];
+				x[3] = v.val[3];
+			} else {
+				const int16x8x3_t v = vld3q_s16(input + 6 * i);
+				x[0] = v.val[0];
+				x[1] = v.val[1];
+				x[2] = v.val[2];
+			}
+			vst1_s16(output + i, DownmixFourFramesNEON(x, w, n));
+		}
+	}
+	DownmixWeightedScalar(input + num_channels * i, weights, num_channels, output + i, size - i);
+}
+
+static void DownmixWeightedPlanarNEON(const int16_t *const *input, size_t offset, const int16_t *weights, size_t num_channels, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		int32x4_t lo = vdupq_n_s32(0);
+		int32x4_t hi = vdupq_n_s32(0);
+		for (size_t c = 0; c < num_channels; c++) {
+			const int16x8_t x = vld1q_s16(input[c] + offset + i);
+			lo = vmlal_n_s16(lo, vget_low_s16(x), weights[c]);
+			hi = vmlal_n_s16(hi, vget_high_s16(x), weights[c]);
+		}
+		vst1q_s16(output + i, vcombine_s16(RoundDownmixSumNEON(lo), RoundDownmixSumNEON(hi)));
+	}
+	DownmixWeightedPlanarScalar(input, offset + i, weights, num_channels, output + i, size - i);
+}
+
+// Accumulates eight taps of one output sample.
+static inline int32x4_t ResampleMultiplyNEON(int32x4_t acc, const int16_t *input, const int16_t *filter)
+{
+	const int16x8_t x = vld1q_s16(input);
+	const int16x8_t f = vld1q_s16(filter);
+	acc = vmlal_s16(acc, vget_low_s16(x), vget_low_s16(f));
+	return vmlal_s16(acc, vget_high_s16(x), vget_high_s16(f));
+}
+
+static void ResampleNEON(const int16_t *input, const uint32_t *offsets, const int16_t *const *filters, size_t filter_length, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const int16_t *x0 = input + offsets[i], *x1 = input + offsets[i + 1];
+		const int16_t *x2 = input + offsets[i + 2], *x3 = input + offsets[i + 3];
+		const int16_t *f0 = filters[i], *f1 = filters[i + 1], *f2 = filters[i + 2], *f3 = filters[i + 3];
+		int32x4_t acc0 = vdupq_n_s32(0), acc1 = vdupq_n_s32(0);
+		int32x4_t acc2 = vdupq_n_s32(0), acc3 = vdupq_n_s32(0);
+		for (size_t k = 0; k < filter_length; k += 8) {
+			acc0 = ResampleMultiplyNEON(acc0, x0 + k, f0 + k);
+			acc1 = ResampleMultiplyNEON(acc1, x1 + k, f1 + k);
+			acc2 = ResampleMultiplyNEON(acc2, x2 + k, f2 + k);
+			acc3 = ResampleMultiplyNEON(acc3, x3 + k, f3 + k);
+		}
+		const int32x4_t sum = vpaddq_s32(vpaddq_s32(acc0, acc1), vpaddq_s32(acc2, acc3));
+		vst1_s16(output + i, vqrshrn_n_s32(sum, kResampleFilterBits));
+	}
+	ResampleScalar(input, offsets + i, filters + i, filter_length, output + i, size - i);
+}
+
+extern const SimdKernels kNEONKernels = {
+	SimdLevel::NEON,
+	ApplyWindowNEON,
+	PowerSpectrumInterleavedNEON,
+	PowerSpectrumSplitNEON,
+	SumNEON,
+	HammingDistanceNEON,
+	FFTButterflyNEON,
+	DownmixStereoNEON,
+	DownmixStereoPlanarNEON,
+	DownmixWeightedNEON,
+	DownmixWeightedPlanarNEON,
+	ResampleNEON,
+};
+
+}; // namespace chromaprint
@@ -0,0 +1,146 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <emmintrin.h>
+#include "simd/kernels.h"
+#include "simd/kernels_x86.h"
+
+namespace chromaprint {
+
+static void ApplyWindowSSE2(const int16_t *input, const float *window, float *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+		const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+		const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+		_mm_storeu_ps(output + i, _mm_mul_ps(lo, _mm_loadu_ps(window + i)));
+		_mm_storeu_ps(output + i + 4, _mm_mul_ps(hi, _mm_loadu_ps(window + i + 4)));
+	}
+	ApplyWindowScalar(input + i, window + i, output + i, size - i);
+}
+
+static inline void StoreFeatures(FeatureScalar *output, __m128 x)
+{
+#ifdef USE_FLOAT_FEATURES
+	_mm_storeu_ps(output, x);
+#else
+	_mm_storeu_pd(output, _mm_cvtps_pd(x));
+	_mm_storeu_pd(output + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+#endif
+}
+
+static void PowerSpectrumInterleavedSSE2(const float *input, FeatureScalar *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const __m128 a = _mm_loadu_ps(input + 2 * i);
+		const __m128 b = _mm_loadu_ps(input + 2 * i + 4);
+		const __m128 a2 = _mm_mul_ps(a, a);
+		const __m128 b2 = _mm_mul_ps(b, b);
+		const __m128 re2 = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 im2 = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(3, 1, 3, 1));
+		StoreFeatures(output + i, _mm_add_ps(re2, im2));
+	}
+	PowerSpectrumInterleavedScalar(input + 2 * i, output + i, size - i);
+}
+
+static void PowerSpectrumSplitSSE2(const float *real, const float *imag, FeatureScalar *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const __m128 re = _mm_loadu_ps(real + i);
+		const __m128 im = _mm_loadu_ps(imag + i);
+		StoreFeatures(output + i, _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+	}
+	PowerSpectrumSplitScalar(real + i, imag + i, output + i, size - i);
+}
+
+static FeatureScalar SumSSE2(const FeatureScalar *input, size_t size)
+{
+	alignas(16) FeatureScalar acc[kSumLanes];
+	size_t i = 0;
+#ifdef USE_FLOAT_FEATURES
+	__m128 acc0 = _mm_setzero_ps();
+	__m128 acc1 = _mm_setzero_ps();
+	for (; i + 8 <= size; i += 8) {
+		acc0 = _mm_add_ps(acc0, _mm_loadu_ps(input + i));
+		acc1 = _mm_add_ps(acc1, _mm_loadu_ps(input + i + 4));
+	}
+	_mm_store_ps(acc, acc0);
+	_mm_store_ps(acc + 4, acc1);
+#else
+	__m128d acc0 = _mm_setzero_pd();
+	__m128d acc1 = _mm_setzero_pd();
+	__m128d acc2 = _mm_setzero_pd();
+	__m128d acc3 = _mm_setzero_pd();
+	for (; i + 8 <= size; i += 8) {
+		acc0 = _mm_add_pd(acc0, _mm_loadu_pd(input + i));
+		acc1 = _mm_add_pd(acc1, _mm_loadu_pd(input + i + 2));
+		acc2 = _mm_add_pd(acc2, _mm_loadu_pd(input + i + 4));
+		acc3 = _mm_add_pd(acc3, _mm_loadu_pd(input + i + 6));
+	}
+	_mm_store_pd(acc, acc0);
+	_mm_store_pd(acc + 2, acc1);
+	_mm_store_pd(acc + 4, acc2);
+	_mm_store_pd(acc + 6, acc3);
+#endif
+	return SumTailScalar(acc, input + i, size - i);
+}
+
+static void HammingDistanceSSE2(const uint32_t *a, const uint32_t *b, size_t size, uint32_t *output)
+{
+	// SSE2 has no popcount instruction, count the bits in parallel with shifts and masks
+	const __m128i m1 = _mm_set1_epi8(0x55);
+	const __m128i m2 = _mm_set1_epi8(0x33);
+	const __m128i m4 = _mm_set1_epi8(0x0F);
+	const __m128i m6 = _mm_set1_epi32(0x3F);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const __m128i x = _mm_xor_si128(
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+		__m128i v = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+		v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+		v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+		v = _mm_add_epi32(v, _mm_srli_epi32(v, 8));
+		v = _mm_add_epi32(v, _mm_srli_epi32(v, 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_and_si128(v, m6));
+	}
+	HammingDistanceScalar(a + i, b + i, size - i, output + i);
+}
+
+static void FFTButterflySSE2(float *real, float *imag, const float *twiddle_real, const float *twiddle_imag, size_t size)
+{
+	float *real2 = real + size;
+	float *imag2 = imag + size;
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const __m128 re1 = _mm_loadu_ps(real + i), im1 = _mm_loadu_ps(imag + i);
+		const __m128 re2 = _mm_loadu_ps(real2 + i), im2 = _mm_loadu_ps(imag2 + i);
+		const __m128 wr = _mm_loadu_ps(twiddle_real + i), wi = _mm_loadu_ps(twiddle_imag + i);
+		const __m128 dr = _mm_sub_ps(re1, re2), di = _mm_sub_ps(im1, im2);
+		_mm_storeu_ps(real + i, _mm_add_ps(re1, re2));
+		_mm_storeu_ps(imag + i, _mm_add_ps(im1, im2));
+		_mm_storeu_ps(real2 + i, _mm_sub_ps(_mm_mul_ps(dr, wr), _mm_mul_ps(di, wi)));
+		_mm_storeu_ps(imag2 + i, _mm_add_ps(_mm_mul_ps(dr, wi), _mm_mul_ps(di, wr)));
+	}
+	FFTButterflyScalar(real + i, imag + i, real2 + i, imag2 + i, twiddle_real + i, twiddle_imag + i, size - i);
+}
+
+extern const SimdKernels kSSE2Kernels = {
+	SimdLevel::SSE2,
+	ApplyWindowSSE2,
+	PowerSpectrumInterleavedSSE2,
+	PowerSpectrumSplitSSE2,
+	SumSSE2,
+	HammingDistanceSSE2,
+	FFTButterflySSE2,
+	DownmixStereoX86,
+	DownmixStereoPlanarX86,
+	DownmixWeightedX86,
+	DownmixWeightedPlanarX86,
+	ResampleSSE2,
+};
+
+}; // namespace chromaprint
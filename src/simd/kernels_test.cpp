@@ -0,0 +1,312 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <cmath>
+#include "simd/simd.h"
+#include "utils/scope_exit.h"
+#include "chromaprint.h"
+#include "utils.h"
+#include "test_utils.h"
+
+using namespace chromaprint;
+
+static std::vector<SimdLevel> GetSupportedSimdLevels()
+{
+	std::vector<SimdLevel> levels;
+	for (auto level : { SimdLevel::Generic, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON }) {
+		if (IsSimdLevelSupported(level)) {
+			levels.push_back(level);
+		}
+	}
+	return levels;
+}
+
+TEST(SimdKernels, Levels)
+{
+	EXPECT_TRUE(IsSimdLevelSupported(SimdLevel::Generic));
+	EXPECT_TRUE(IsSimdLevelSupported(GetBestSimdLevel()));
+	EXPECT_EQ(SimdLevel::Generic, GetSimdKernels(SimdLevel::Generic).level);
+
+	SimdLevel level;
+	EXPECT_TRUE(ParseSimdLevel("avx2", &level));
+	EXPECT_EQ(SimdLevel::AVX2, level);
+	EXPECT_FALSE(ParseSimdLevel("mmx", &level));
+
+	const auto old_level = GetSimdLevel();
+	SCOPE_EXIT(SetSimdLevel(old_level));
+	ASSERT_TRUE(SetSimdLevel(SimdLevel::Generic));
+	EXPECT_EQ(SimdLevel::Generic, GetSimdLevel());
+	EXPECT_EQ(SimdLevel::Generic, GetSimdKernels().level);
+}
+
+TEST(SimdKernels, ApplyWindow)
+{
+	std::mt19937 rng(1234);
+	std::vector<int16_t> input(1000);
+	std::vector<float> window(1000);
+	for (size_t i = 0; i < input.size(); i++) {
+		input[i] = int16_t(rng());
+		window[i] = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+	}
+	std::vector<float> expected(input.size()), output(input.size());
+	for (auto level : GetSupportedSimdLevels()) {
+		const auto &kernels = GetSimdKernels(level);
+		for (size_t size = 0; size < input.size(); size += 37) {
+			GetSimdKernels(SimdLevel::Generic).apply_window(input.data() + 1, window.data(), expected.data(), size);
+			kernels.apply_window(input.data() + 1, window.data(), output.data(), size);
+			ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, output.begin()))
+				<< GetSimdLevelName(level) << " " << size;
+		}
+	}
+}
+
+TEST(SimdKernels, PowerSpectrum)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+	std::vector<float> input(2000);
+	for (auto &x : input) {
+		x = dist(rng);
+	}
+	std::vector<FeatureScalar> expected(input.size()), output(input.size());
+	for (auto level : GetSupportedSimdLevels()) {
+		const auto &kernels = GetSimdKernels(level);
+		for (size_t size = 0; size < input.size() / 2; size += 37) {
+			GetSimdKernels(SimdLevel::Generic).power_spectrum_interleaved(input.data() + 2, expected.data(), size);
+			kernels.power_spectrum_interleaved(input.data() + 2, output.data(), size);
+			ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, output.begin()))
+				<< GetSimdLevelName(level) << " " << size;
+
+			GetSimdKernels(SimdLevel::Generic).power_spectrum_split(input.data() + 1, input.data() + 1000, expected.data(), size);
+			kernels.power_spectrum_split(input.data() + 1, input.data() + 1000, output.data(), size);
+			ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, output.begin()))
+				<< GetSimdLevelName(level) << " " << size;
+		}
+	}
+}
+
+TEST(SimdKernels, Sum)
+{
+	const FeatureScalar small[] = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0 };
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<FeatureScalar> dist(0.0, 1000.0);
+	std::vector<FeatureScalar> input(1000);
+	for (auto &x : input) {
+		x = dist(rng);
+	}
+
+	for (auto level : GetSupportedSimdLevels()) {
+		const auto &kernels = GetSimdKernels(level);
+		EXPECT_EQ(0.0, kernels.sum(nullptr, 0));
+		for (size_t size = 1; size <= 11; size++) {
+			EXPECT_EQ(size * (size + 1) / 2, kernels.sum(small, size)) << GetSimdLevelName(level) << " " << size;
+		}
+		for (size_t offset = 0; offset < 3; offset++) {
+			for (size_t size = 0; size < input.size() - offset; size += 7) {
+				ASSERT_EQ(GetSimdKernels(SimdLevel::Generic).sum(input.data() + offset, size), kernels.sum(input.data() + offset, size))
+					<< GetSimdLevelName(level) << " " << offset << " " << size;
+			}
+		}
+	}
+}
+
+TEST(SimdKernels, HammingDistance)
+{
+	std::mt19937 rng(1234);
+	std::vector<uint32_t> a(1000), b(1000);
+	for (size_t i = 0; i < a.size(); i++) {
+		a[i] = rng();
+		b[i] = rng();
+	}
+	a[0] = 0;
+	b[0] = 0xFFFFFFFF;
+	b[1] = a[1];
+
+	std::vector<uint32_t> output(a.size());
+	for (auto level : GetSupportedSimdLevels()) {
+		const auto &kernels = GetSimdKernels(level);
+		for (size_t size = 0; size < a.size(); size += 37) {
+			std::fill(output.begin(), output.end(), 0xFFFFFFFF);
+			kernels.hamming_distance(a.data(), b.data(), size, output.data());
+			for (size_t i = 0; i < size; i++) {
+				ASSERT_EQ(HammingDistance(a[i], b[i]), output[i]) << GetSimdLevelName(level) << " " << size << " " << i;
+			}
+			if (size > 1) {
+				EXPECT_EQ(32, output[0]);
+				EXPECT_EQ(0, output[1]);
+			}
+		}
+	}
+}
+
+TEST(SimdKernels, FFTButterfly)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+	std::vector<float> real(1000), imag(1000), twiddle_real(500), twiddle_imag(500);
+	for (size_t i = 0; i < real.size(); i++) {
+		real[i] = dist(rng);
+		imag[i] = dist(rng);
+	}
+	for (size_t i = 0; i < twiddle_real.size(); i++) {
+		twiddle_real[i] = std::cos(i * 0.01f);
+		twiddle_imag[i] = -std::sin(i * 0.01f);
+	}
+	for (auto level : GetSupportedSimdLevels()) {
+		const auto &kernels = GetSimdKernels(level);
+		for (size_t size = 0; size <= real.size() / 2; size += 37) {
+			auto expected_real = real, expected_imag = imag;
+			auto output_real = real, output_imag = imag;
+			GetSimdKernels(SimdLevel::Generic).fft_butterfly(expected_real.data(), expected_imag.data(), twiddle_real.data(), twiddle_imag.data(), size);
+			kernels.fft_butterfly(output_real.data(), output_imag.data(), twiddle_real.data(), twiddle_imag.data(), size);
+			ASSERT_EQ(expected_real, output_real) << GetSimdLevelName(level) << " " << size;
+			ASSERT_EQ(expected_imag, output_imag) << GetSimdLevelName(level) << " " << size;
+			if (size > 1) {
+				EXPECT_EQ(real[1] + real[1 + size], output_real[1]);
+				EXPECT_EQ(imag[1] + imag[1 + size], output_imag[1]);
+			}
+		}
+	}
+}
+
+TEST(SimdKernels, Downmix)
+{
+	std::mt19937 rng(1234);
+	std::vector<int16_t> input(8 * 1000);
+	for (auto &x : input) {
+		x = int16_t(rng());
+	}
+	// extreme values, where the sums overflow int16_t
+	for (size_t i = 0; i < 64; i++) {
+		input[i] = (i / 8) % 2 ? INT16_MIN : INT16_MAX;
+	}
+	std::vector<int16_t> expected(1000), output(1000), planar_output(1000);
+	const auto &generic = GetSimdKernels(SimdLevel::Generic);
+
+	for (auto level : GetSupportedSimdLevels()) {
+		const auto &kernels = GetSimdKernels(level);
+		std::vector<int16_t> left(input.begin(), input.begin() + 1000), right(input.begin() + 1000, input.begin() + 2000);
+		for (size_t size = 0; size <= 1000; size += 37) {
+			generic.downmix_stereo(input.data(), expected.data(), size);
+			kernels.downmix_stereo(input.data(), output.data(), size);
+			ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, output.begin()))
+				<< GetSimdLevelName(level) << " " << size;
+			if (size > 0) {
+				EXPECT_EQ(int16_t((input[0] + input[1]) / 2), output[0]);
+			}
+
+			generic.downmix_stereo_planar(left.data(), right.data(), expected.data(), size);
+			kernels.downmix_stereo_planar(left.data(), right.data(), output.data(), size);
+			ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, output.begin()))
+				<< GetSimdLevelName(level) << " " << size;
+		}
+
+		for (size_t num_channels = 1; num_channels <= 8; num_channels++) {
+			std::vector<int16_t> weights(num_channels);
+			int remaining = 1 << kDownmixWeightBits;
+			for (size_t c = 0; c < num_channels; c++) {
+				weights[c] = c + 1 < num_channels ? int16_t(rng() % (remaining / 2 + 1)) : int16_t(std::min(remaining, 32767));
+				remaining -= weights[c];
+			}
+			const size_t num_frames = input.size() / num_channels;
+			std::vector<std::vector<int16_t>> planes(num_channels, std::vector<int16_t>(num_frames));
+			std::vector<const int16_t *> planar_input;
+			for (size_t c = 0; c < num_channels; c++) {
+				for (size_t i = 0; i < num_frames; i++) {
+					planes[c][i] = input[i * num_channels + c];
+				}
+				planar_input.push_back(planes[c].data());
+			}
+			for (size_t size = 0; size <= 900 && size < num_frames; size += 37) {
+				generic.downmix_weighted(input.data(), weights.data(), num_channels, expected.data(), size);
+				kernels.downmix_weighted(input.data(), weights.data(), num_channels, output.data(), size);
+				kernels.downmix_weighted_planar(planar_input.data(), 0, weights.data(), num_channels, planar_output.data(), size);
+				ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, output.begin()))
+					<< GetSimdLevelName(level) << " " << num_channels << " " << size;
+				ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, planar_output.begin()))
+					<< GetSimdLevelName(level) << " " << num_channels << " " << size;
+
+				// planar input starting at an offset
+				kernels.downmix_weighted_planar(planar_input.data(), 3, weights.data(), num_channels, planar_output.data(), size);
+				generic.downmix_weighted(input.data() + 3 * num_channels, weights.data(), num_channels, expected.data(), size);
+				ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, planar_output.begin()))
+					<< GetSimdLevelName(level) << " " << num_channels << " " << size;
+			}
+		}
+	}
+}
+
+TEST(SimdKernels, Resample)
+{
+	std::mt19937 rng(1234);
+	const size_t filter_length = 3 * kResampleFilterAlign;
+	std::vector<int16_t> input(1000 + filter_length);
+	for (auto &x : input) {
+		x = int16_t(rng());
+	}
+	// a filter that makes the sums overflow int16_t
+	std::vector<int16_t> filter_bank(4 * filter_length);
+	for (auto &x : filter_bank) {
+		x = int16_t(int(rng() % 4096) - 2048);
+	}
+	for (size_t k = 0; k < filter_length; k++) {
+		filter_bank[k] = 1000;
+	}
+	std::vector<uint32_t> offsets(1000);
+	std::vector<const int16_t *> filters(1000);
+	for (size_t i = 0; i < offsets.size(); i++) {
+		offsets[i] = uint32_t(i * 2 + rng() % 3) / 2;
+		filters[i] = filter_bank.data() + (rng() % 4) * filter_length;
+	}
+	std::vector<int16_t> expected(1000), output(1000);
+	const auto &generic = GetSimdKernels(SimdLevel::Generic);
+
+	for (auto level : GetSupportedSimdLevels()) {
+		const auto &kernels = GetSimdKernels(level);
+		for (size_t size = 0; size <= 1000; size += 37) {
+			for (size_t length = kResampleFilterAlign; length <= filter_length; length += kResampleFilterAlign) {
+				generic.resample(input.data(), offsets.data(), filters.data(), length, expected.data(), size);
+				kernels.resample(input.data(), offsets.data(), filters.data(), length, output.data(), size);
+				ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + size, output.begin()))
+					<< GetSimdLevelName(level) << " " << length << " " << size;
+			}
+		}
+	}
+}
+
+TEST(SimdKernels, SameFingerprint)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	const auto old_level = GetSimdLevel();
+	SCOPE_EXIT(SetSimdLevel(old_level));
+
+	std::vector<uint32_t> expected;
+	for (auto level : GetSupportedSimdLevels()) {
+		ASSERT_TRUE(SetSimdLevel(level));
+
+		ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+		ASSERT_NE(nullptr, ctx);
+		SCOPE_EXIT(chromaprint_free(ctx));
+
+		ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+		for (int i = 0; i < 3; i++) {
+			ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+		}
+		ASSERT_EQ(1, chromaprint_finish(ctx));
+
+		uint32_t *fp;
+		int size;
+		ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		ASSERT_GT(size, 0);
+
+		std::vector<uint32_t> fingerprint(fp, fp + size);
+		if (level == SimdLevel::Generic) {
+			expected = fingerprint;
+		} else {
+			EXPECT_EQ(expected, fingerprint) << GetSimdLevelName(level);
+		}
+	}
+}
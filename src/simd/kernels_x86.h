@@ -0,0 +1,229 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_SIMD_KERNELS_X86_H_
+#define CHROMAPRINT_SIMD_KERNELS_X86_H_
+
+#include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "simd/kernels.h"
+
+// SSE2 kernels shared by all x86 levels. The downmix kernels are limited by
+// the memory bandwidth, wider vectors do not make them faster, and AVX-512F
+// has no 16-bit integer instructions anyway. This header is included by each
+// x86 kernel file, so the functions are compiled with the flags of that file.
+// The AVX2 resampling kernel is shared by the AVX2 and AVX-512 levels.
+
+namespace chromaprint {
+
+namespace {
+
+inline __m128i LoadInt16x8(const int16_t *input)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+}
+
+// (x + (x < 0)) >> 1 is x / 2 rounded towards zero
+inline __m128i HalveInt32x4(__m128i x)
+{
+	return _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 31)), 1);
+}
+
+inline __m128i RoundDownmixSumInt32x4(__m128i x)
+{
+	const __m128i half = _mm_set1_epi32(1 << (kDownmixWeightBits - 1));
+	return _mm_srai_epi32(_mm_add_epi32(x, half), kDownmixWeightBits);
+}
+
+// Two int16 weights, for multiplying pairs of samples with _mm_madd_epi16.
+inline __m128i SetWeightPair(int16_t w0, int16_t w1)
+{
+	return _mm_set1_epi32(int32_t(uint16_t(w0)) | (int32_t(uint16_t(w1)) << 16));
+}
+
+inline void DownmixStereoX86(const int16_t *input, int16_t *output, size_t size)
+{
+	const __m128i ones = _mm_set1_epi16(1);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		// the adjacent pairs are the left and right samples of one frame
+		const __m128i lo = _mm_madd_epi16(LoadInt16x8(input + 2 * i), ones);
+		const __m128i hi = _mm_madd_epi16(LoadInt16x8(input + 2 * i + 8), ones);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(HalveInt32x4(lo), HalveInt32x4(hi)));
+	}
+	DownmixStereoScalar(input + 2 * i, output + i, size - i);
+}
+
+inline void DownmixStereoPlanarX86(const int16_t *left, const int16_t *right, int16_t *output, size_t size)
+{
+	const __m128i ones = _mm_set1_epi16(1);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m128i l = LoadInt16x8(left + i);
+		const __m128i r = LoadInt16x8(right + i);
+		const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(l, r), ones);
+		const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(l, r), ones);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(HalveInt32x4(lo), HalveInt32x4(hi)));
+	}
+	DownmixStereoPlanarScalar(left + i, right + i, output + i, size - i);
+}
+
+// Sums of the four 32-bit lanes of each of the four vectors.
+inline __m128i HorizontalSumInt32x4x4(__m128i m0, __m128i m1, __m128i m2, __m128i m3)
+{
+	const __m128i s01 = _mm_add_epi32(_mm_unpacklo_epi32(m0, m1), _mm_unpackhi_epi32(m0, m1));
+	const __m128i s23 = _mm_add_epi32(_mm_unpacklo_epi32(m2, m3), _mm_unpackhi_epi32(m2, m3));
+	return _mm_add_epi32(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+}
+
+// 8 channels, one frame is one vector.
+inline __m128i DownmixFourFrames8(const int16_t *input, __m128i weights)
+{
+	return HorizontalSumInt32x4x4(
+		_mm_madd_epi16(LoadInt16x8(input), weights),
+		_mm_madd_epi16(LoadInt16x8(input + 8), weights),
+		_mm_madd_epi16(LoadInt16x8(input + 16), weights),
+		_mm_madd_epi16(LoadInt16x8(input + 24), weights));
+}
+
+// 6 channels, four frames are three vectors, so each frame is the sum of
+// three pairs, which are shuffled into place. The shuffles are only
+// available for floats, but they move the bits without changing them.
+inline __m128i DownmixFourFrames6(const int16_t *input, const __m128i *weights)
+{
+	const __m128 m0 = _mm_castsi128_ps(_mm_madd_epi16(LoadInt16x8(input), weights[0]));
+	const __m128 m1 = _mm_castsi128_ps(_mm_madd_epi16(LoadInt16x8(input + 8), weights[1]));
+	const __m128 m2 = _mm_castsi128_ps(_mm_madd_epi16(LoadInt16x8(input + 16), weights[2]));
+	// frame 0 = m0[0] + m0[1] + m0[2], frame 1 = m0[3] + m1[0] + m1[1],
+	// frame 2 = m1[2] + m1[3] + m2[0], frame 3 = m2[1] + m2[2] + m2[3]
+	const __m128 t1 = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 1, 3, 2));
+	const __m128 t2 = _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(0, 0, 1, 1));
+	const __m128 t3 = _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(1, 1, 2, 2));
+	const __m128 t4 = _mm_shuffle_ps(m2, m2, _MM_SHUFFLE(3, 3, 0, 0));
+	const __m128i a = _mm_castps_si128(_mm_shuffle_ps(m0, t1, _MM_SHUFFLE(2, 0, 3, 0)));
+	const __m128i b = _mm_castps_si128(_mm_shuffle_ps(t2, t1, _MM_SHUFFLE(3, 1, 2, 0)));
+	const __m128i c = _mm_castps_si128(_mm_shuffle_ps(t3, t4, _MM_SHUFFLE(2, 0, 2, 0)));
+	return _mm_add_epi32(_mm_add_epi32(a, b), c);
+}
+
+inline void DownmixWeightedX86(const int16_t *input, const int16_t *weights, size_t num_channels, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	if (num_channels == 8) {
+		const __m128i w = _mm_setr_epi16(weights[0], weights[1], weights[2], weights[3], weights[4], weights[5], weights[6], weights[7]);
+		for (; i + 8 <= size; i += 8) {
+			const __m128i lo = RoundDownmixSumInt32x4(DownmixFourFrames8(input + 8 * i, w));
+			const __m128i hi = RoundDownmixSumInt32x4(DownmixFourFrames8(input + 8 * i + 32, w));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(lo, hi));
+		}
+	} else if (num_channels == 6) {
+		const __m128i w[3] = {
+			_mm_setr_epi16(weights[0], weights[1], weights[2], weights[3], weights[4], weights[5], weights[0], weights[1]),
+			_mm_setr_epi16(weights[2], weights[3], weights[4], weights[5], weights[0], weights[1], weights[2], weights[3]),
+			_mm_setr_epi16(weights[4], weights[5], weights[0], weights[1], weights[2], weights[3], weights[4], weights[5]),
+		};
+		for (; i + 8 <= size; i += 8) {
+			const __m128i lo = RoundDownmixSumInt32x4(DownmixFourFrames6(input + 6 * i, w));
+			const __m128i hi = RoundDownmixSumInt32x4(DownmixFourFrames6(input + 6 * i + 24, w));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(lo, hi));
+		}
+	}
+	DownmixWeightedScalar(input + num_channels * i, weights, num_channels, output + i, size - i);
+}
+
+inline void DownmixWeightedPlanarX86(const int16_t *const *input, size_t offset, const int16_t *weights, size_t num_channels, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		__m128i lo = _mm_setzero_si128();
+		__m128i hi = _mm_setzero_si128();
+		size_t c = 0;
+		for (; c + 2 <= num_channels; c += 2) {
+			const __m128i x0 = LoadInt16x8(input[c] + offset + i);
+			const __m128i x1 = LoadInt16x8(input[c + 1] + offset + i);
+			const __m128i w = SetWeightPair(weights[c], weights[c + 1]);
+			lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x0, x1), w));
+			hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x0, x1), w));
+		}
+		if (c < num_channels) {
+			const __m128i x0 = LoadInt16x8(input[c] + offset + i);
+			const __m128i w = SetWeightPair(weights[c], 0);
+			lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x0, x0), w));
+			hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x0, x0), w));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(RoundDownmixSumInt32x4(lo), RoundDownmixSumInt32x4(hi)));
+	}
+	DownmixWeightedPlanarScalar(input, offset + i, weights, num_channels, output + i, size - i);
+}
+
+inline __m128i RoundResampleSumInt32x4(__m128i x)
+{
+	const __m128i half = _mm_set1_epi32(1 << (kResampleFilterBits - 1));
+	return _mm_srai_epi32(_mm_add_epi32(x, half), kResampleFilterBits);
+}
+
+// Four output samples at a time, the rounded sums are saturated by the packing.
+inline void ResampleSSE2(const int16_t *input, const uint32_t *offsets, const int16_t *const *filters, size_t filter_length, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const int16_t *x0 = input + offsets[i], *x1 = input + offsets[i + 1];
+		const int16_t *x2 = input + offsets[i + 2], *x3 = input + offsets[i + 3];
+		const int16_t *f0 = filters[i], *f1 = filters[i + 1], *f2 = filters[i + 2], *f3 = filters[i + 3];
+		__m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+		__m128i acc2 = _mm_setzero_si128(), acc3 = _mm_setzero_si128();
+		for (size_t k = 0; k < filter_length; k += 8) {
+			acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(LoadInt16x8(x0 + k), LoadInt16x8(f0 + k)));
+			acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(LoadInt16x8(x1 + k), LoadInt16x8(f1 + k)));
+			acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(LoadInt16x8(x2 + k), LoadInt16x8(f2 + k)));
+			acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(LoadInt16x8(x3 + k), LoadInt16x8(f3 + k)));
+		}
+		const __m128i sum = RoundResampleSumInt32x4(HorizontalSumInt32x4x4(acc0, acc1, acc2, acc3));
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(sum, sum));
+	}
+	ResampleScalar(input, offsets + i, filters + i, filter_length, output + i, size - i);
+}
+
+#ifdef __AVX2__
+
+inline __m256i LoadInt16x16(const int16_t *input)
+{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input));
+}
+
+inline __m128i AddHalvesInt32x8(__m256i x)
+{
+	return _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+}
+
+inline void ResampleAVX2(const int16_t *input, const uint32_t *offsets, const int16_t *const *filters, size_t filter_length, int16_t *output, size_t size)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const int16_t *x0 = input + offsets[i], *x1 = input + offsets[i + 1];
+		const int16_t *x2 = input + offsets[i + 2], *x3 = input + offsets[i + 3];
+		const int16_t *f0 = filters[i], *f1 = filters[i + 1], *f2 = filters[i + 2], *f3 = filters[i + 3];
+		__m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+		__m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+		for (size_t k = 0; k < filter_length; k += 16) {
+			acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(LoadInt16x16(x0 + k), LoadInt16x16(f0 + k)));
+			acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(LoadInt16x16(x1 + k), LoadInt16x16(f1 + k)));
+			acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(LoadInt16x16(x2 + k), LoadInt16x16(f2 + k)));
+			acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(LoadInt16x16(x3 + k), LoadInt16x16(f3 + k)));
+		}
+		const __m128i sum = RoundResampleSumInt32x4(HorizontalSumInt32x4x4(
+			AddHalvesInt32x8(acc0), AddHalvesInt32x8(acc1), AddHalvesInt32x8(acc2), AddHalvesInt32x8(acc3)));
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(sum, sum));
+	}
+	ResampleScalar(input, offsets + i, filters + i, filter_length, output + i, size - i);
+}
+
+#endif
+
+}; // namespace
+
+}; // namespace chromaprint
+
+#endif
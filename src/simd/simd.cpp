@@ -0,0 +1,228 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include "simd/simd.h"
+#include "simd/kernels.h"
+#include "debug.h"
+
+#if defined(USE_SSE2) || defined(USE_AVX2) || defined(USE_AVX512)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#define CHROMAPRINT_SIMD_X86
+#endif
+
+namespace chromaprint {
+
+#ifdef CHROMAPRINT_SIMD_X86
+
+struct X86Features {
+	bool sse2 = false;
+	bool popcnt = false;
+	bool avx2 = false;
+	bool avx512f = false;
+	bool avx512vpopcntdq = false;
+};
+
+static void CpuId(int leaf, int subleaf, unsigned int *regs)
+{
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuidex(r, leaf, subleaf);
+	for (int i = 0; i < 4; i++) {
+		regs[i] = r[i];
+	}
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t GetXCR0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (uint64_t(edx) << 32) | eax;
+#endif
+}
+
+static X86Features DetectX86Features()
+{
+	X86Features features;
+	unsigned int regs[4];
+
+	CpuId(0, 0, regs);
+	const unsigned int max_leaf = regs[0];
+	if (max_leaf < 1) {
+		return features;
+	}
+
+	CpuId(1, 0, regs);
+	features.sse2 = (regs[3] >> 26) & 1;
+	features.popcnt = (regs[2] >> 23) & 1;
+	const bool osxsave = (regs[2] >> 27) & 1;
+	const bool avx = (regs[2] >> 28) & 1;
+	if (!osxsave || !avx || max_leaf < 7) {
+		return features;
+	}
+
+	// the OS has to save the YMM and ZMM registers on context switches
+	const uint64_t xcr0 = GetXCR0();
+	const bool os_avx = (xcr0 & 0x06) == 0x06;
+	const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+
+	CpuId(7, 0, regs);
+	features.avx2 = os_avx && ((regs[1] >> 5) & 1);
+	features.avx512f = os_avx512 && ((regs[1] >> 16) & 1);
+	features.avx512vpopcntdq = features.avx512f && ((regs[2] >> 14) & 1);
+	return features;
+}
+
+static const X86Features &GetX86Features()
+{
+	static const X86Features features = DetectX86Features();
+	return features;
+}
+
+#endif
+
+static const SimdKernels *FindSimdKernels(SimdLevel level)
+{
+	switch (level) {
+		case SimdLevel::Generic:
+			return &kGenericKernels;
+#ifdef USE_SSE2
+		case SimdLevel::SSE2:
+			return GetX86Features().sse2 ? &kSSE2Kernels : nullptr;
+#endif
+#ifdef USE_AVX2
+		case SimdLevel::AVX2:
+			return GetX86Features().avx2 && GetX86Features().popcnt ? &kAVX2Kernels : nullptr;
+#endif
+#ifdef USE_AVX512
+		case SimdLevel::AVX512:
+			if (!GetX86Features().avx512f || !GetX86Features().popcnt) {
+				return nullptr;
+			}
+			return GetX86Features().avx512vpopcntdq ? &kAVX512VPOPCNTDQKernels : &kAVX512Kernels;
+#endif
+#ifdef USE_NEON
+		case SimdLevel::NEON:
+			return &kNEONKernels;
+#endif
+		default:
+			return nullptr;
+	}
+}
+
+static const SimdLevel kAllSimdLevels[] = {
+	SimdLevel::Generic,
+	SimdLevel::SSE2,
+	SimdLevel::AVX2,
+	SimdLevel::AVX512,
+	SimdLevel::NEON,
+};
+
+const char *GetSimdLevelName(SimdLevel level)
+{
+	switch (level) {
+		case SimdLevel::Generic:
+			return "generic";
+		case SimdLevel::SSE2:
+			return "sse2";
+		case SimdLevel::AVX2:
+			return "avx2";
+		case SimdLevel::AVX512:
+			return "avx512";
+		case SimdLevel::NEON:
+			return "neon";
+	}
+	return "unknown";
+}
+
+bool ParseSimdLevel(const char *name, SimdLevel *level)
+{
+	for (auto l : kAllSimdLevels) {
+		if (!strcmp(name, GetSimdLevelName(l))) {
+			*level = l;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool IsSimdLevelSupported(SimdLevel level)
+{
+	return FindSimdKernels(level) != nullptr;
+}
+
+static SimdLevel DetectBestSimdLevel()
+{
+	auto best = SimdLevel::Generic;
+	for (auto level : kAllSimdLevels) {
+		if (IsSimdLevelSupported(level)) {
+			best = level;
+		}
+	}
+	return best;
+}
+
+SimdLevel GetBestSimdLevel()
+{
+	static const SimdLevel level = DetectBestSimdLevel();
+	return level;
+}
+
+static SimdLevel GetDefaultSimdLevel()
+{
+	const char *name = getenv("CHROMAPRINT_SIMD_LEVEL");
+	if (name && *name) {
+		SimdLevel level;
+		if (!ParseSimdLevel(name, &level)) {
+			DEBUG("chromaprint::GetDefaultSimdLevel() -- unknown SIMD level " << name);
+		} else if (!IsSimdLevelSupported(level)) {
+			DEBUG("chromaprint::GetDefaultSimdLevel() -- SIMD level " << name << " is not supported");
+		} else {
+			return level;
+		}
+	}
+	return GetBestSimdLevel();
+}
+
+static std::atomic<int> g_forced_simd_level(-1);
+
+SimdLevel GetSimdLevel()
+{
+	const int forced_level = g_forced_simd_level.load(std::memory_order_relaxed);
+	if (forced_level >= 0) {
+		return static_cast<SimdLevel>(forced_level);
+	}
+	static const SimdLevel level = GetDefaultSimdLevel();
+	return level;
+}
+
+bool SetSimdLevel(SimdLevel level)
+{
+	if (!IsSimdLevelSupported(level)) {
+		return false;
+	}
+	g_forced_simd_level.store(static_cast<int>(level), std::memory_order_relaxed);
+	return true;
+}
+
+const SimdKernels &GetSimdKernels(SimdLevel level)
+{
+	auto kernels = FindSimdKernels(level);
+	assert(kernels);
+	return kernels ? *kernels : kGenericKernels;
+}
+
+}; // namespace chromaprint
@@ -0,0 +1,107 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_SIMD_SIMD_H_
+#define CHROMAPRINT_SIMD_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "feature_vector.h"
+
+namespace chromaprint {
+
+enum class SimdLevel {
+	Generic = 0,
+	SSE2,
+	AVX2,
+	AVX512,
+	NEON,
+};
+
+// Number of partial sums used by SimdKernels::sum.
+static const size_t kSumLanes = 8;
+
+// Downmix weights are fixed point numbers with this many fractional bits.
+// They must not be negative and their sum must not be more than one.
+static const int kDownmixWeightBits = 15;
+
+// Resampling filters are fixed point numbers with this many fractional bits,
+// like in av_resample(), and their length must be a multiple of this.
+static const int kResampleFilterBits = 15;
+static const size_t kResampleFilterAlign = 16;
+
+// Implementations of the hot loops for one instruction set.
+//
+// All implementations must return exactly the same results as the generic
+// ones, so that the fingerprints do not depend on the CPU. That's why the
+// sum uses a fixed number of partial sums, which are added in a fixed order,
+// and why the kernels are compiled without FMA contraction.
+struct SimdKernels
+{
+	SimdLevel level;
+
+	//! output[i] = input[i] * window[i]
+	void (*apply_window)(const int16_t *input, const float *window, float *output, size_t size);
+
+	//! output[i] = input[2 * i]^2 + input[2 * i + 1]^2
+	void (*power_spectrum_interleaved)(const float *input, FeatureScalar *output, size_t size);
+
+	//! output[i] = real[i]^2 + imag[i]^2
+	void (*power_spectrum_split)(const float *real, const float *imag, FeatureScalar *output, size_t size);
+
+	//! Sum of input[0..size), element i is added to the partial sum i % kSumLanes.
+	FeatureScalar (*sum)(const FeatureScalar *input, size_t size);
+
+	//! output[i] = HammingDistance(a[i], b[i])
+	void (*hamming_distance)(const uint32_t *a, const uint32_t *b, size_t size, uint32_t *output);
+	//! Radix-2 decimation-in-frequency butterflies of a complex FFT, for i < size:
+	//! x[i], x[i + size] = x[i] + x[i + size], (x[i] - x[i + size]) * twiddle[i]
+	void (*fft_butterfly)(float *real, float *imag, const float *twiddle_real, const float *twiddle_imag, size_t size);
+
+	//! output[i] = (input[2 * i] + input[2 * i + 1]) / 2, rounded towards zero
+	void (*downmix_stereo)(const int16_t *input, int16_t *output, size_t size);
+
+	//! output[i] = (left[i] + right[i]) / 2, rounded towards zero
+	void (*downmix_stereo_planar)(const int16_t *left, const int16_t *right, int16_t *output, size_t size);
+
+	//! output[i] = sum(input[i * num_channels + c] * weights[c]), rounded to the nearest integer
+	void (*downmix_weighted)(const int16_t *input, const int16_t *weights, size_t num_channels, int16_t *output, size_t size);
+
+	//! output[i] = sum(input[c][offset + i] * weights[c]), rounded to the nearest integer
+	void (*downmix_weighted_planar)(const int16_t *const *input, size_t offset, const int16_t *weights, size_t num_channels, int16_t *output, size_t size);
+
+	//! output[i] = sum(input[offsets[i] + k] * filters[i][k]) for k < filter_length, rounded to
+	//! the nearest integer and saturated, the sums must fit into int32_t
+	void (*resample)(const int16_t *input, const uint32_t *offsets, const int16_t *const *filters, size_t filter_length, int16_t *output, size_t size);
+};
+
+const char *GetSimdLevelName(SimdLevel level);
+
+bool ParseSimdLevel(const char *name, SimdLevel *level);
+
+//! Check if the level was compiled in and is supported by the CPU.
+bool IsSimdLevelSupported(SimdLevel level);
+
+//! Get the best level supported by the CPU.
+SimdLevel GetBestSimdLevel();
+
+//! Get the level used for new objects.
+//
+// This is the best supported level, unless it was overridden by SetSimdLevel()
+// or by the CHROMAPRINT_SIMD_LEVEL environment variable.
+SimdLevel GetSimdLevel();
+
+//! Force the level used for new objects, mostly useful for testing.
+bool SetSimdLevel(SimdLevel level);
+
+//! Get the kernels for a supported level.
+const SimdKernels &GetSimdKernels(SimdLevel level);
+
+//! Get the kernels for the current level.
+inline const SimdKernels &GetSimdKernels() {
+	return GetSimdKernels(GetSimdLevel());
+}
+
+}; // namespace chromaprint
+
+#endif
@@ -32,7 +32,7 @@ private:
 	void PrepareBands(int num_bands, int min_freq, int max_freq, int frame_size, int sample_rate);
 
 	std::vector<int> m_bands;
-	std::vector<double> m_features;
+	FeatureVector m_features;
 	FeatureVectorConsumer *m_consumer;
 };
 
@@ -0,0 +1,33 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#include "stats.h"
+
+namespace chromaprint {
+
+#ifdef USE_STATS
+thread_local StatsThreadState g_stats_thread_state = { nullptr, -1, std::chrono::steady_clock::time_point() };
+#endif
+
+const char *GetStageName(Stage stage)
+{
+	switch (stage) {
+	case Stage::AudioProcessor:
+		return "audio_processor";
+	case Stage::FFT:
+		return "fft";
+	case Stage::Chroma:
+		return "chroma";
+	case Stage::ChromaFilter:
+		return "chroma_filter";
+	case Stage::ChromaNormalizer:
+		return "chroma_normalizer";
+	case Stage::FingerprintCalculator:
+		return "fingerprint_calculator";
+	case Stage::Compressor:
+		return "compressor";
+	}
+	return "unknown";
+}
+
+}; // namespace chromaprint
@@ -0,0 +1,164 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_STATS_H_
+#define CHROMAPRINT_STATS_H_
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#ifdef USE_STATS
+#include <chrono>
+#endif
+
+namespace chromaprint {
+
+// Keep in sync with ChromaprintStage in chromaprint.h.
+enum class Stage {
+	AudioProcessor = 0,
+	FFT,
+	Chroma,
+	ChromaFilter,
+	ChromaNormalizer,
+	FingerprintCalculator,
+	Compressor,
+};
+
+static const int kNumStages = 7;
+
+const char *GetStageName(Stage stage);
+
+struct StageStats
+{
+	//! Time spent in the stage, not including the following stages it called.
+	uint64_t time_ns = 0;
+	//! Number of items the stage processed (samples, frames or fingerprint items).
+	uint64_t count = 0;
+};
+
+class Stats
+{
+public:
+	const StageStats &stage(Stage stage) const {
+		return m_stages[int(stage)];
+	}
+
+	StageStats &stage(Stage stage) {
+		return m_stages[int(stage)];
+	}
+
+	void Reset() {
+		for (auto &s : m_stages) {
+			s = StageStats();
+		}
+	}
+
+	void Add(const Stats &other) {
+		for (int i = 0; i < kNumStages; i++) {
+			m_stages[i].time_ns += other.m_stages[i].time_ns;
+			m_stages[i].count += other.m_stages[i].count;
+		}
+	}
+
+private:
+	StageStats m_stages[kNumStages];
+};
+
+#ifdef USE_STATS
+
+// The pipeline stages push data to each other, so the stages are nested.
+// Each thread keeps track of the innermost stage that is running and when it
+// was last entered or resumed, so that time spent in a nested stage is not
+// counted in the outer stage.
+struct StatsThreadState
+{
+	Stats *stats;
+	int stage;
+	std::chrono::steady_clock::time_point start;
+};
+
+extern thread_local StatsThreadState g_stats_thread_state;
+
+//! Collect statistics of all stages running in this thread into stats, until the end of the scope.
+class StatsScope
+{
+public:
+	StatsScope(Stats *stats) : m_saved(g_stats_thread_state) {
+		g_stats_thread_state.stats = stats;
+		g_stats_thread_state.stage = -1;
+	}
+
+	~StatsScope() {
+		g_stats_thread_state = m_saved;
+	}
+
+private:
+	StatsScope(const StatsScope &) = delete;
+	StatsScope &operator=(const StatsScope &) = delete;
+
+	StatsThreadState m_saved;
+};
+
+//! Count the time until the end of the scope to the stage.
+class StageTimer
+{
+public:
+	StageTimer(Stage stage, size_t count) {
+		auto &state = g_stats_thread_state;
+		if (!state.stats) {
+			return;
+		}
+		const auto now = std::chrono::steady_clock::now();
+		if (state.stage >= 0) {
+			state.stats->stage(Stage(state.stage)).time_ns += GetElapsedTime(state.start, now);
+		}
+		m_parent = state.stage;
+		state.stage = int(stage);
+		state.start = now;
+		state.stats->stage(stage).count += count;
+	}
+
+	~StageTimer() {
+		auto &state = g_stats_thread_state;
+		if (!state.stats) {
+			return;
+		}
+		const auto now = std::chrono::steady_clock::now();
+		state.stats->stage(Stage(state.stage)).time_ns += GetElapsedTime(state.start, now);
+		state.stage = m_parent;
+		state.start = now;
+	}
+
+private:
+	StageTimer(const StageTimer &) = delete;
+	StageTimer &operator=(const StageTimer &) = delete;
+
+	static uint64_t GetElapsedTime(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	}
+
+	int m_parent = -1;
+};
+
+#define CHROMAPRINT_STATS_CONCAT_(a, b) a##b
+#define CHROMAPRINT_STATS_CONCAT(a, b) CHROMAPRINT_STATS_CONCAT_(a, b)
+
+#define CHROMAPRINT_STATS_SCOPE(stats) \
+	::chromaprint::StatsScope CHROMAPRINT_STATS_CONCAT(stats_scope_, __LINE__)(stats)
+
+#define CHROMAPRINT_STAGE_TIMER(stage, count) \
+	::chromaprint::StageTimer CHROMAPRINT_STATS_CONCAT(stage_timer_, __LINE__)(::chromaprint::Stage::stage, count)
+
+#else
+
+#define CHROMAPRINT_STATS_SCOPE(stats) do { } while (0)
+#define CHROMAPRINT_STAGE_TIMER(stage, count) do { } while (0)
+
+#endif
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,50 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_MAPPED_FILE_H_
+#define CHROMAPRINT_UTILS_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include "utils.h"
+
+namespace chromaprint {
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { Close(); }
+
+	bool Open(const std::string &file_name);
+	void Close();
+
+	void Swap(MappedFile &other) {
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+#ifdef _WIN32
+		std::swap(m_file, other.m_file);
+		std::swap(m_mapping, other.m_mapping);
+#endif
+	}
+
+	bool is_open() const { return m_data != nullptr; }
+	const char *data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	CHROMAPRINT_DISABLE_COPY(MappedFile);
+
+	const char *m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void *m_file = nullptr;
+	void *m_mapping = nullptr;
+#endif
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -7,8 +7,11 @@
 #include <cstddef>
 #include <cassert>
 #include <algorithm>
+#include <array>
 #include <numeric>
+#include <vector>
 #include "debug.h"
+#include "utils/state_buffer.h"
 
 namespace chromaprint {
 
@@ -82,8 +85,10 @@ public:
 
 		assert(m_num_columns == size);
 
+		// the input can be in lower precision, sum it in the precision of the image
 		auto current_row_begin = GetRow(m_num_rows);
-		std::partial_sum(begin, end, current_row_begin);
+		auto current_row_end = std::copy(begin, end, current_row_begin);
+		std::partial_sum(current_row_begin, current_row_end, current_row_begin);
 
 		if (m_num_rows > 0) {
 			auto last_row_begin = GetRow(m_num_rows - 1);
@@ -95,7 +100,8 @@ public:
 		m_num_rows++;
 	}
 
-	void AddRow(const std::vector<double> &row) {
+	template <typename T>
+	void AddRow(const std::vector<T> &row) {
 		AddRow(row.begin(), row.end());
 	}
 
@@ -117,6 +123,117 @@ private:
 	std::vector<double> m_data;
 };
 
+// Same as RollingIntegralImage, but with the number of columns known at
+// compile time and the ring of rows sized to the next power of two, so it
+// can be indexed with a mask. With a small number of rows the whole image
+// fits in L1 cache.
+//
+// Rows are stored as the sums of all rows before them, with a zero column
+// in front, so any area can be calculated from four values, without special
+// cases for the first row or column.
+//
+// The values are sums of all rows added since the last reset, so float
+// storage loses precision as the input gets longer. It's only suitable for
+// short inputs, use double for fingerprints.
+template <typename T, size_t NumColumns>
+class FixedRollingIntegralImage {
+public:
+	explicit FixedRollingIntegralImage(size_t max_rows) : m_max_rows(max_rows + 1) {
+		size_t size = 1;
+		while (size < m_max_rows) {
+			size *= 2;
+		}
+		m_mask = size - 1;
+		m_data.resize(size);
+		Reset();
+	}
+
+	size_t num_columns() const { return NumColumns; }
+	size_t num_rows() const { return m_num_rows; }
+
+	void Reset() {
+		m_num_rows = 0;
+		m_data[0].fill(0);
+	}
+
+	//! Get the sums of the first r rows, column c is at index c + 1 and index 0 is zero.
+	const T *GetRowSums(size_t r) const {
+		assert(r <= m_num_rows);
+		assert(r + m_max_rows > m_num_rows);
+		return m_data[r & m_mask].data();
+	}
+
+	double Area(size_t r1, size_t c1, size_t r2, size_t c2) const {
+		assert(c1 <= NumColumns);
+		assert(c2 <= NumColumns);
+
+		if (r1 == r2 || c1 == c2) {
+			return 0.0;
+		}
+
+		assert(r2 > r1);
+		assert(c2 > c1);
+
+		const auto row1 = GetRowSums(r1);
+		const auto row2 = GetRowSums(r2);
+		return double(row2[c2]) - double(row1[c2]) - double(row2[c1]) + double(row1[c1]);
+	}
+
+	template <typename InputIt>
+	void AddRow(InputIt begin, InputIt end) {
+		assert(size_t(std::distance(begin, end)) == NumColumns);
+
+		const auto &last_row = m_data[m_num_rows & m_mask];
+		auto &row = m_data[(m_num_rows + 1) & m_mask];
+
+		// the input can be in lower precision, sum it in the precision of the image
+		T sum = 0;
+		row[0] = 0;
+		for (size_t i = 1; i <= NumColumns; i++, ++begin) {
+			sum += T(*begin);
+			row[i] = last_row[i] + sum;
+		}
+
+		m_num_rows++;
+	}
+
+	template <typename U>
+	void AddRow(const std::vector<U> &row) {
+		AddRow(row.begin(), row.end());
+	}
+
+	//! Save the row sums that can still be used.
+	void SaveState(StateWriter &writer) const {
+		const size_t first_row = m_num_rows >= m_max_rows ? m_num_rows - m_max_rows + 1 : 0;
+		writer.Write(uint64_t(m_num_rows));
+		for (size_t r = first_row; r <= m_num_rows; r++) {
+			writer.WriteArray(GetRowSums(r), NumColumns + 1);
+		}
+	}
+
+	bool RestoreState(StateReader &reader) {
+		uint64_t num_rows;
+		if (!reader.Read(&num_rows)) {
+			return false;
+		}
+		m_num_rows = num_rows;
+		const size_t first_row = m_num_rows >= m_max_rows ? m_num_rows - m_max_rows + 1 : 0;
+		for (size_t r = first_row; r <= m_num_rows; r++) {
+			if (!reader.ReadArray(m_data[r & m_mask].data(), NumColumns + 1)) {
+				Reset();
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	size_t m_max_rows;
+	size_t m_mask;
+	size_t m_num_rows = 0;
+	std::vector<std::array<T, NumColumns + 1>> m_data;
+};
+
 }; // namespace chromaprint
 
 #endif
@@ -88,4 +88,41 @@ TEST(RollingIntegralImageTest, All) {
 	ASSERT_DOUBLE_EQ((7 + 8 + 9) + (10 + 11 + 12) + (13 + 14 + 15) + (16 + 17 + 18), image.Area(2, 0, 6, 3));
 }
 
+TEST(RollingIntegralImageTest, Fixed) {
+	const size_t max_rows = 5;
+	RollingIntegralImage expected(max_rows);
+	FixedRollingIntegralImage<double, 12> image(max_rows);
+	FixedRollingIntegralImage<float, 12> float_image(max_rows);
+
+	ASSERT_EQ(12, image.num_columns());
+
+	uint32_t seed = 1;
+	for (size_t n = 1; n <= 40; n++) {
+		std::vector<double> data(12);
+		for (auto &x : data) {
+			seed = seed * 1103515245 + 12345;
+			x = (seed >> 16) % 1000 / 1000.0;
+		}
+		expected.AddRow(data);
+		image.AddRow(data);
+		float_image.AddRow(data);
+		ASSERT_EQ(n, image.num_rows());
+
+		const size_t first_row = n > max_rows ? n - max_rows : 0;
+		for (size_t r1 = first_row; r1 <= n; r1++) {
+			for (size_t r2 = r1; r2 <= n; r2++) {
+				for (size_t c1 = 0; c1 <= 12; c1 += 3) {
+					for (size_t c2 = c1; c2 <= 12; c2 += 2) {
+						ASSERT_EQ(expected.Area(r1, c1, r2, c2), image.Area(r1, c1, r2, c2));
+						ASSERT_NEAR(expected.Area(r1, c1, r2, c2), float_image.Area(r1, c1, r2, c2), 0.001);
+					}
+				}
+			}
+		}
+	}
+
+	image.Reset();
+	ASSERT_EQ(0, image.num_rows());
+}
+
 }; // namespace chromaprint
@@ -0,0 +1,97 @@
+// Copyright (C) 2016  Lukas Lalinsky
+// Distributed under the MIT license, see the LICENSE file for details.
+
+#ifndef CHROMAPRINT_UTILS_STATE_BUFFER_H_
+#define CHROMAPRINT_UTILS_STATE_BUFFER_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace chromaprint {
+
+// Serialized state of the fingerprinting pipeline. Values are stored in the
+// native byte order and size, so a state can only be restored by the same
+// build of the library on the same kind of machine.
+class StateWriter
+{
+public:
+	StateWriter(std::string *output) : m_output(output) {}
+
+	template <typename T>
+	void Write(const T &value) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+		m_output->append(reinterpret_cast<const char *>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	void WriteArray(const T *data, size_t size) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+		Write(uint32_t(size));
+		m_output->append(reinterpret_cast<const char *>(data), size * sizeof(T));
+	}
+
+	template <typename T>
+	void WriteArray(const std::vector<T> &data) {
+		WriteArray(data.data(), data.size());
+	}
+
+private:
+	std::string *m_output;
+};
+
+class StateReader
+{
+public:
+	StateReader(const char *data, size_t size) : m_data(data), m_end(data + size) {}
+
+	bool AtEnd() const { return m_data == m_end; }
+
+	template <typename T>
+	bool Read(T *value) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read");
+		if (size_t(m_end - m_data) < sizeof(T)) {
+			return false;
+		}
+		memcpy(value, m_data, sizeof(T));
+		m_data += sizeof(T);
+		return true;
+	}
+
+	//! Read an array of up to max_size values.
+	template <typename T>
+	bool ReadArray(std::vector<T> *output, size_t max_size) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read");
+		uint32_t size;
+		if (!Read(&size) || size > max_size || size_t(m_end - m_data) / sizeof(T) < size) {
+			return false;
+		}
+		output->resize(size);
+		memcpy(output->data(), m_data, size * sizeof(T));
+		m_data += size * sizeof(T);
+		return true;
+	}
+
+	//! Read an array of exactly the given size.
+	template <typename T>
+	bool ReadArray(T *output, size_t size) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read");
+		uint32_t stored_size;
+		if (!Read(&stored_size) || stored_size != size || size_t(m_end - m_data) / sizeof(T) < size) {
+			return false;
+		}
+		memcpy(output, m_data, size * sizeof(T));
+		m_data += size * sizeof(T);
+		return true;
+	}
+
+private:
+	const char *m_data;
+	const char *m_end;
+};
+
+}; // namespace chromaprint
+
+#endif
@@ -0,0 +1,84 @@
+# Checks that fpcalc -jobs prints the results in the order of the input files,
+# even if the later files are shorter and finish first, and that it stops at
+# the first unreadable file the same way as without -jobs.
+#
+# cmake -DFPCALC=<path> -DTESTS_DIR=<path> -DWORK_DIR=<path> -P fpcalc_jobs_test.cmake
+
+set(input ${TESTS_DIR}/data/test_mono_44100.raw)
+set(input_options -format s16le -rate 44100 -channels 1)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+# the input is 2 seconds long, repeat it to get files of different lengths
+set(files)
+set(index 0)
+foreach(repeat 40 3 20 4 5 10 6 30)
+	set(parts)
+	foreach(i RANGE 1 ${repeat})
+		list(APPEND parts ${input})
+	endforeach()
+	set(file ${WORK_DIR}/input_${index}.raw)
+	execute_process(COMMAND ${CMAKE_COMMAND} -E cat ${parts} OUTPUT_FILE ${file} RESULT_VARIABLE ret)
+	if(ret)
+		message(FATAL_ERROR "Could not create ${file}")
+	endif()
+	list(APPEND files ${file})
+	math(EXPR index "${index} + 1")
+endforeach()
+
+# runs fpcalc sequentially and with -jobs 1/4/16 and checks that stdout,
+# stderr and the exit code are all the same
+function(check_jobs name expected_ret)
+	execute_process(COMMAND ${FPCALC} ${input_options} ${ARGN}
+		OUTPUT_VARIABLE expected_output ERROR_VARIABLE expected_error RESULT_VARIABLE expected_result)
+	if(NOT expected_result EQUAL expected_ret)
+		message(FATAL_ERROR "${name}: fpcalc returned ${expected_result}, expected ${expected_ret}:\n${expected_error}")
+	endif()
+	foreach(jobs 1 4 16)
+		execute_process(COMMAND ${FPCALC} ${input_options} -jobs ${jobs} ${ARGN}
+			OUTPUT_VARIABLE output ERROR_VARIABLE error RESULT_VARIABLE result)
+		if(NOT result EQUAL expected_result)
+			message(FATAL_ERROR "${name}: fpcalc -jobs ${jobs} returned ${result}, expected ${expected_result}:\n${error}")
+		endif()
+		if(NOT output STREQUAL expected_output)
+			message(FATAL_ERROR "${name}: different output with -jobs ${jobs}:\n${output}\nExpected:\n${expected_output}")
+		endif()
+		if(NOT error STREQUAL expected_error)
+			message(FATAL_ERROR "${name}: different errors with -jobs ${jobs}:\n${error}\nExpected:\n${expected_error}")
+		endif()
+	endforeach()
+	set(output "${expected_output}" PARENT_SCOPE)
+	set(error "${expected_error}" PARENT_SCOPE)
+endfunction()
+
+check_jobs("good files" 0 ${files})
+
+string(REGEX MATCHALL "FINGERPRINT=" fingerprints "${output}")
+list(LENGTH fingerprints num_fingerprints)
+list(LENGTH files num_files)
+if(NOT num_fingerprints EQUAL num_files)
+	message(FATAL_ERROR "Expected ${num_files} fingerprints, got:\n${output}")
+endif()
+
+# processing stops at the first file that can't be read, the results of the
+# previous files must still be printed and nothing after it
+set(missing_file ${WORK_DIR}/missing.raw)
+set(empty_file ${WORK_DIR}/empty.raw)
+file(WRITE ${empty_file} "")
+list(GET files 0 1 2 first_files)
+list(GET files 3 4 5 6 7 last_files)
+foreach(bad_file ${missing_file} ${empty_file})
+	check_jobs("unreadable file" 2 ${first_files} ${bad_file} ${last_files})
+	string(REGEX MATCHALL "FINGERPRINT=" fingerprints "${output}")
+	list(LENGTH fingerprints num_fingerprints)
+	if(NOT num_fingerprints EQUAL 3 OR NOT error MATCHES "^ERROR: ")
+		message(FATAL_ERROR "Expected 3 fingerprints and an error for ${bad_file}, got:\n${output}\n${error}")
+	endif()
+	check_jobs("unreadable first file" 2 ${bad_file} ${files})
+	if(NOT output STREQUAL "")
+		message(FATAL_ERROR "Expected no output for ${bad_file}, got:\n${output}")
+	endif()
+endforeach()
+
+file(REMOVE_RECURSE ${WORK_DIR})
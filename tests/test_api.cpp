@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <vector>
 #include <fstream>
+#include <cstdio>
 #include "chromaprint.h"
 #include "test_utils.h"
 #include "utils/scope_exit.h"
@@ -34,6 +35,87 @@ TEST(API, TestFp) {
 	ASSERT_EQ(3732003127, fp_hash);
 }
 
+TEST(API, TestFeedFloat)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+	std::vector<float> float_data(data.size());
+	for (size_t i = 0; i < data.size(); i++) {
+		float_data[i] = data[i] / 32768.0f;
+	}
+	const float *planes[1] = { float_data.data() };
+
+	std::vector<uint32_t> fingerprints[3];
+	for (int i = 0; i < 3; i++) {
+		ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+		ASSERT_NE(nullptr, ctx);
+		SCOPE_EXIT(chromaprint_free(ctx));
+
+		ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+		switch (i) {
+		case 0:
+			ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+			break;
+		case 1:
+			ASSERT_EQ(1, chromaprint_feed_float(ctx, float_data.data(), float_data.size()));
+			break;
+		case 2:
+			ASSERT_EQ(1, chromaprint_feed_planar_float(ctx, planes, float_data.size()));
+			break;
+		}
+		ASSERT_EQ(1, chromaprint_finish(ctx));
+
+		uint32_t *fp;
+		int size;
+		ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		fingerprints[i].assign(fp, fp + size);
+	}
+
+	ASSERT_FALSE(fingerprints[0].empty());
+	EXPECT_EQ(fingerprints[0], fingerprints[1]);
+	EXPECT_EQ(fingerprints[0], fingerprints[2]);
+}
+
+TEST(API, TestFeedPlanar)
+{
+	// the file is too short for a fingerprint, so it's repeated
+	const std::vector<short> file_data = LoadAudioFile("data/test_stereo_44100.raw");
+	std::vector<short> data;
+	for (int i = 0; i < 3; i++) {
+		data.insert(data.end(), file_data.begin(), file_data.end());
+	}
+	const size_t length = data.size() / 2;
+	std::vector<int16_t> planar_data[2] = { std::vector<int16_t>(length), std::vector<int16_t>(length) };
+	for (size_t i = 0; i < data.size(); i++) {
+		planar_data[i % 2][i / 2] = data[i];
+	}
+	const int16_t *planes[2] = { planar_data[0].data(), planar_data[1].data() };
+
+	std::vector<uint32_t> fingerprints[2];
+	for (int i = 0; i < 2; i++) {
+		ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+		ASSERT_NE(nullptr, ctx);
+		SCOPE_EXIT(chromaprint_free(ctx));
+
+		ASSERT_EQ(1, chromaprint_start(ctx, 44100, 2));
+		if (i == 0) {
+			ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+		} else {
+			ASSERT_EQ(1, chromaprint_feed_planar(ctx, planes, length));
+		}
+		ASSERT_EQ(1, chromaprint_finish(ctx));
+
+		uint32_t *fp;
+		int size;
+		ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		fingerprints[i].assign(fp, fp + size);
+	}
+
+	ASSERT_FALSE(fingerprints[0].empty());
+	EXPECT_EQ(fingerprints[0], fingerprints[1]);
+}
+
 TEST(API, Test2SilenceFp)
 {
 	short zeroes[1024];
@@ -196,4 +278,573 @@ TEST(API, TestDecodeFingerprintCoustidFingerprint)
 	ASSERT_EQ(0, algorithm);
 }
 
+TEST(API, TestMatcher)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	for (int i = 0; i < 3; i++) {
+		ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+	}
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	uint32_t *fp;
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	ASSERT_GT(size, 10);
+
+	char *encoded_fp;
+	int encoded_size;
+	ASSERT_EQ(1, chromaprint_encode_fingerprint(fp + 5, size - 5, CHROMAPRINT_ALGORITHM_TEST2, &encoded_fp, &encoded_size, 1));
+	SCOPE_EXIT(chromaprint_dealloc(encoded_fp));
+
+	ChromaprintMatcherContext *matcher = chromaprint_matcher_new();
+	ASSERT_NE(nullptr, matcher);
+	SCOPE_EXIT(chromaprint_matcher_free(matcher));
+
+	ASSERT_EQ(0, chromaprint_matcher_run(matcher));
+	ASSERT_EQ(0, chromaprint_matcher_set_fingerprint(matcher, 2, fp, size, CHROMAPRINT_ALGORITHM_TEST2));
+
+	// the same context is reused for multiple runs
+	for (int i = 0; i < 2; i++) {
+		ASSERT_EQ(1, chromaprint_matcher_set_fingerprint(matcher, 0, fp, size, CHROMAPRINT_ALGORITHM_TEST2));
+		ASSERT_EQ(1, chromaprint_matcher_set_encoded_fingerprint(matcher, 1, encoded_fp, encoded_size, 1));
+		ASSERT_EQ(1, chromaprint_matcher_run(matcher));
+
+		int num_segments;
+		ASSERT_EQ(1, chromaprint_matcher_get_num_segments(matcher, &num_segments));
+		ASSERT_EQ(1, num_segments);
+
+		int pos1, pos2, duration, score;
+		ASSERT_EQ(1, chromaprint_matcher_get_segment_position(matcher, 0, &pos1, &pos2, &duration));
+		EXPECT_EQ(5, pos1);
+		EXPECT_EQ(0, pos2);
+		EXPECT_EQ(size - 5, duration);
+		ASSERT_EQ(1, chromaprint_matcher_get_segment_score(matcher, 0, &score));
+		EXPECT_EQ(0, score);
+
+		ASSERT_EQ(1, chromaprint_matcher_get_segment_position_ms(matcher, 0, &pos1, &pos2, &duration));
+		EXPECT_EQ(5 * chromaprint_get_item_duration(ctx) * 1000 / chromaprint_get_sample_rate(ctx), pos1);
+		EXPECT_EQ(0, pos2);
+
+		ASSERT_EQ(0, chromaprint_matcher_get_segment_score(matcher, 1, &score));
+	}
+
+	// a failed run doesn't leave the previous segments behind
+	std::vector<uint32_t> too_long(1 << 20);
+	ASSERT_EQ(1, chromaprint_matcher_set_fingerprint(matcher, 1, too_long.data(), too_long.size(), CHROMAPRINT_ALGORITHM_TEST2));
+	ASSERT_EQ(0, chromaprint_matcher_run(matcher));
+	int num_segments;
+	ASSERT_EQ(1, chromaprint_matcher_get_num_segments(matcher, &num_segments));
+	EXPECT_EQ(0, num_segments);
+
+	ASSERT_EQ(1, chromaprint_matcher_set_fingerprint(matcher, 1, fp, size, CHROMAPRINT_ALGORITHM_TEST1));
+	ASSERT_EQ(0, chromaprint_matcher_run(matcher));
+}
+
+TEST(API, TestIndexSearch)
+{
+	std::vector<short> data = LoadAudioFile("data/test_mono_44100.raw");
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	for (int i = 0; i < 3; i++) {
+		ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+	}
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	const uint32_t *fp;
+	int size;
+	ASSERT_EQ(1, chromaprint_borrow_raw_fingerprint(ctx, &fp, &size));
+	ASSERT_GT(size, 20);
+
+	ASSERT_EQ(nullptr, chromaprint_index_new(-1));
+	ChromaprintIndexContext *index = chromaprint_index_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, index);
+	SCOPE_EXIT(chromaprint_index_free(index));
+
+	// unrelated fingerprints around the real one
+	std::vector<uint32_t> noise(size);
+	uint32_t x = 1;
+	for (uint32_t id = 1; id <= 5; id++) {
+		for (auto &item : noise) {
+			x = x * 1664525u + 1013904223u;
+			item = x;
+		}
+		ASSERT_EQ(1, chromaprint_index_add_fingerprint(index, id, noise.data(), noise.size()));
+		if (id == 3) {
+			ASSERT_EQ(1, chromaprint_index_add_fingerprint(index, 100, fp, size));
+		}
+	}
+	ASSERT_EQ(1, chromaprint_index_build(index));
+
+	int num;
+	ASSERT_EQ(1, chromaprint_index_get_num_fingerprints(index, &num));
+	EXPECT_EQ(6, num);
+
+	const char *file_name = "test_api_index.idx";
+	ASSERT_EQ(1, chromaprint_index_save(index, file_name));
+	ChromaprintIndexContext *mapped_index = chromaprint_index_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, mapped_index);
+	SCOPE_EXIT(chromaprint_index_free(mapped_index));
+	ASSERT_EQ(1, chromaprint_index_open(mapped_index, file_name));
+	remove(file_name);
+	ASSERT_EQ(0, chromaprint_index_open(mapped_index, "does_not_exist.idx"));
+
+	for (auto idx : { index, mapped_index }) {
+		ChromaprintSearcherContext *searcher = chromaprint_searcher_new(idx);
+		ASSERT_NE(nullptr, searcher);
+		SCOPE_EXIT(chromaprint_searcher_free(searcher));
+
+		int num_results;
+		ASSERT_EQ(1, chromaprint_searcher_search(searcher, fp + 5, size - 5, &num_results));
+		ASSERT_EQ(1, num_results);
+
+		uint32_t id;
+		int num_segments;
+		ASSERT_EQ(1, chromaprint_searcher_get_result(searcher, 0, &id, &num_segments));
+		EXPECT_EQ(100, id);
+		ASSERT_EQ(1, num_segments);
+
+		int pos1, pos2, duration, score;
+		ASSERT_EQ(1, chromaprint_searcher_get_segment_position(searcher, 0, 0, &pos1, &pos2, &duration));
+		EXPECT_EQ(0, pos1);
+		EXPECT_EQ(5, pos2);
+		EXPECT_EQ(size - 5, duration);
+		ASSERT_EQ(1, chromaprint_searcher_get_segment_score(searcher, 0, 0, &score));
+		EXPECT_EQ(0, score);
+		ASSERT_EQ(1, chromaprint_searcher_get_segment_position_ms(searcher, 0, 0, &pos1, &pos2, &duration));
+		EXPECT_EQ(5 * chromaprint_get_item_duration(ctx) * 1000 / chromaprint_get_sample_rate(ctx), pos2);
+
+		ASSERT_EQ(0, chromaprint_searcher_get_segment_score(searcher, 0, 1, &score));
+		ASSERT_EQ(0, chromaprint_searcher_get_result(searcher, 1, &id, &num_segments));
+
+		// no candidates to compare
+		ASSERT_EQ(1, chromaprint_searcher_set_max_candidates(searcher, 0));
+		ASSERT_EQ(1, chromaprint_searcher_search(searcher, fp, size, &num_results));
+		EXPECT_EQ(0, num_results);
+	}
+}
+
+TEST(API, TestNewRawFingerprint)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	std::vector<uint32_t> streamed;
+	const uint32_t *new_fp;
+	int new_size;
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	for (int i = 0; i < 3; i++) {
+		for (size_t offset = 0; offset < data.size(); offset += 4096) {
+			const auto length = std::min(data.size() - offset, size_t(4096));
+			ASSERT_EQ(1, chromaprint_feed(ctx, data.data() + offset, length));
+			ASSERT_EQ(1, chromaprint_get_new_raw_fingerprint(ctx, &new_fp, &new_size));
+			streamed.insert(streamed.end(), new_fp, new_fp + new_size);
+		}
+	}
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+	ASSERT_EQ(1, chromaprint_get_new_raw_fingerprint(ctx, &new_fp, &new_size));
+	streamed.insert(streamed.end(), new_fp, new_fp + new_size);
+
+	ASSERT_EQ(1, chromaprint_get_new_raw_fingerprint(ctx, &new_fp, &new_size));
+	EXPECT_EQ(0, new_size);
+
+	uint32_t *fp;
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	ASSERT_GT(size, 0);
+	EXPECT_EQ(std::vector<uint32_t>(fp, fp + size), streamed);
+
+	ASSERT_EQ(1, chromaprint_clear_fingerprint(ctx));
+	ASSERT_EQ(1, chromaprint_get_new_raw_fingerprint(ctx, &new_fp, &new_size));
+	EXPECT_EQ(0, new_size);
+}
+
+TEST(API, TestRawFingerprintWithoutAllocation)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	for (int i = 0; i < 3; i++) {
+		ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+	}
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	uint32_t *fp;
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	ASSERT_GT(size, 0);
+	const std::vector<uint32_t> expected(fp, fp + size);
+
+	const uint32_t *borrowed_fp;
+	int borrowed_size;
+	ASSERT_EQ(1, chromaprint_borrow_raw_fingerprint(ctx, &borrowed_fp, &borrowed_size));
+	EXPECT_EQ(expected, std::vector<uint32_t>(borrowed_fp, borrowed_fp + borrowed_size));
+
+	// the size is returned even if the buffer is too small
+	std::vector<uint32_t> buffer(size - 1, 0);
+	int copied_size = 0;
+	EXPECT_EQ(0, chromaprint_get_raw_fingerprint_into(ctx, nullptr, 0, &copied_size));
+	EXPECT_EQ(size, copied_size);
+	EXPECT_EQ(0, chromaprint_get_raw_fingerprint_into(ctx, buffer.data(), buffer.size(), &copied_size));
+	EXPECT_EQ(size, copied_size);
+	EXPECT_EQ(std::vector<uint32_t>(size - 1, 0), buffer);
+
+	buffer.resize(size + 1, 0);
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_into(ctx, buffer.data(), buffer.size(), &copied_size));
+	ASSERT_EQ(size, copied_size);
+	EXPECT_EQ(expected, std::vector<uint32_t>(buffer.begin(), buffer.begin() + size));
+
+	ASSERT_EQ(1, chromaprint_clear_fingerprint(ctx));
+	ASSERT_EQ(1, chromaprint_borrow_raw_fingerprint(ctx, &borrowed_fp, &borrowed_size));
+	EXPECT_EQ(0, borrowed_size);
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_into(ctx, nullptr, 0, &copied_size));
+	EXPECT_EQ(0, copied_size);
+}
+
+static void AppendRawFingerprint(void *user_data, const uint32_t *fp, int size)
+{
+	auto output = reinterpret_cast<std::vector<uint32_t> *>(user_data);
+	output->insert(output->end(), fp, fp + size);
+}
+
+TEST(API, TestRawFingerprintCallback)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	std::vector<uint32_t> streamed;
+	ASSERT_EQ(1, chromaprint_set_raw_fingerprint_callback(ctx, AppendRawFingerprint, &streamed));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	for (int i = 0; i < 3; i++) {
+		ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+	}
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	uint32_t *fp;
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+	ASSERT_GT(size, 0);
+	EXPECT_EQ(std::vector<uint32_t>(fp, fp + size), streamed);
+}
+
+TEST(API, TestProcessParallel)
+{
+	std::vector<short> chunk = LoadAudioFile("data/test_stereo_44100.raw");
+
+	// silence at the start for the algorithms that remove it, followed by
+	// the test file repeated at different volumes, so that it's not periodic
+	std::vector<short> data(44100 * 2, 0);
+	for (int i = 0; i < 40; i++) {
+		const int gain = 4 + (i * 7) % 13;
+		for (auto sample : chunk) {
+			data.push_back(sample * gain / 16);
+		}
+	}
+
+	const int algorithms[] = {
+		CHROMAPRINT_ALGORITHM_TEST1,
+		CHROMAPRINT_ALGORITHM_TEST2,
+		CHROMAPRINT_ALGORITHM_TEST3,
+		CHROMAPRINT_ALGORITHM_TEST4,
+		CHROMAPRINT_ALGORITHM_TEST5,
+	};
+	for (auto algorithm : algorithms) {
+		for (int num_channels : { 1, 2 }) {
+			ChromaprintContext *ctx = chromaprint_new(algorithm);
+			ASSERT_NE(nullptr, ctx);
+			SCOPE_EXIT(chromaprint_free(ctx));
+
+			ASSERT_EQ(1, chromaprint_start(ctx, 44100, num_channels));
+			for (size_t offset = 0; offset < data.size(); offset += 4096) {
+				const auto length = std::min(data.size() - offset, size_t(4096));
+				ASSERT_EQ(1, chromaprint_feed(ctx, data.data() + offset, length));
+			}
+			ASSERT_EQ(1, chromaprint_finish(ctx));
+
+			uint32_t *expected;
+			int expected_size;
+			ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &expected, &expected_size));
+			SCOPE_EXIT(chromaprint_dealloc(expected));
+			ASSERT_GT(expected_size, 0);
+
+			for (int num_threads : { 0, 1, 2, 3, 8 }) {
+				// the silence remover keeps some state between runs, so use a new context
+				ChromaprintContext *parallel_ctx = chromaprint_new(algorithm);
+				ASSERT_NE(nullptr, parallel_ctx);
+				SCOPE_EXIT(chromaprint_free(parallel_ctx));
+
+				std::vector<uint32_t> streamed;
+				ASSERT_EQ(1, chromaprint_set_raw_fingerprint_callback(parallel_ctx, AppendRawFingerprint, &streamed));
+				ASSERT_EQ(1, chromaprint_process_parallel(parallel_ctx, 44100, num_channels, data.data(), data.size(), num_threads));
+
+				uint32_t *fp;
+				int size;
+				ASSERT_EQ(1, chromaprint_get_raw_fingerprint(parallel_ctx, &fp, &size));
+				SCOPE_EXIT(chromaprint_dealloc(fp));
+				EXPECT_EQ(std::vector<uint32_t>(expected, expected + expected_size), std::vector<uint32_t>(fp, fp + size))
+					<< "algorithm " << algorithm << ", channels " << num_channels << ", threads " << num_threads;
+				EXPECT_EQ(std::vector<uint32_t>(fp, fp + size), streamed);
+			}
+		}
+	}
+
+	short zeroes[1024] = {};
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+	ASSERT_EQ(1, chromaprint_process_parallel(ctx, 44100, 1, zeroes, 1024, 4));
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &size));
+	EXPECT_EQ(0, size);
+}
+
+// The FFT plans must not be created or destroyed concurrently (the FFTW planner
+// is not thread-safe), so run many segments many times to catch that in the
+// fftw3 builds.
+TEST(API, TestProcessParallelRepeated)
+{
+	std::vector<short> chunk = LoadAudioFile("data/test_mono_44100.raw");
+	std::vector<short> data;
+	for (int i = 0; i < 20; i++) {
+		const int gain = 4 + (i * 7) % 13;
+		for (auto sample : chunk) {
+			data.push_back(sample * gain / 16);
+		}
+	}
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	uint32_t *expected;
+	int expected_size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &expected, &expected_size));
+	SCOPE_EXIT(chromaprint_dealloc(expected));
+	ASSERT_GT(expected_size, 0);
+
+	for (int i = 0; i < 20; i++) {
+		ASSERT_EQ(1, chromaprint_process_parallel(ctx, 44100, 1, data.data(), data.size(), 16));
+
+		uint32_t *fp;
+		int size;
+		ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &fp, &size));
+		SCOPE_EXIT(chromaprint_dealloc(fp));
+		ASSERT_EQ(std::vector<uint32_t>(expected, expected + expected_size), std::vector<uint32_t>(fp, fp + size)) << "run " << i;
+	}
+}
+
+TEST(API, TestSaveRestoreState)
+{
+	std::vector<short> chunk = LoadAudioFile("data/test_stereo_44100.raw");
+	std::vector<short> data(44100, 0);
+	for (int i = 0; i < 5; i++) {
+		data.insert(data.end(), chunk.begin(), chunk.end());
+	}
+
+	const int algorithms[] = {
+		CHROMAPRINT_ALGORITHM_TEST1,
+		CHROMAPRINT_ALGORITHM_TEST2,
+		CHROMAPRINT_ALGORITHM_TEST4,
+	};
+	for (auto algorithm : algorithms) {
+		for (int sample_rate : { 11025, 44100 }) {
+			ChromaprintContext *ctx = chromaprint_new(algorithm);
+			ASSERT_NE(nullptr, ctx);
+			SCOPE_EXIT(chromaprint_free(ctx));
+
+			ASSERT_EQ(1, chromaprint_start(ctx, sample_rate, 2));
+			ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+			ASSERT_EQ(1, chromaprint_finish(ctx));
+
+			uint32_t *expected;
+			int expected_size;
+			ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx, &expected, &expected_size));
+			SCOPE_EXIT(chromaprint_dealloc(expected));
+			ASSERT_GT(expected_size, 0);
+
+			for (size_t split : { size_t(2), size_t(88200), size_t(100002), size_t(300000), data.size() - 1000 }) {
+				ChromaprintContext *ctx1 = chromaprint_new(algorithm);
+				ASSERT_NE(nullptr, ctx1);
+				SCOPE_EXIT(chromaprint_free(ctx1));
+
+				std::vector<uint32_t> streamed;
+				ASSERT_EQ(1, chromaprint_set_raw_fingerprint_callback(ctx1, AppendRawFingerprint, &streamed));
+				ASSERT_EQ(1, chromaprint_start(ctx1, sample_rate, 2));
+				ASSERT_EQ(1, chromaprint_feed(ctx1, data.data(), split));
+
+				void *state;
+				int state_size;
+				ASSERT_EQ(1, chromaprint_save_state(ctx1, &state, &state_size));
+				SCOPE_EXIT(chromaprint_dealloc(state));
+
+				ChromaprintContext *ctx2 = chromaprint_new(algorithm);
+				ASSERT_NE(nullptr, ctx2);
+				SCOPE_EXIT(chromaprint_free(ctx2));
+
+				// truncated states are rejected
+				EXPECT_EQ(0, chromaprint_restore_state(ctx2, state, state_size - 1));
+
+				ASSERT_EQ(1, chromaprint_set_raw_fingerprint_callback(ctx2, AppendRawFingerprint, &streamed));
+				ASSERT_EQ(1, chromaprint_restore_state(ctx2, state, state_size));
+				ASSERT_EQ(1, chromaprint_feed(ctx2, data.data() + split, data.size() - split));
+				ASSERT_EQ(1, chromaprint_finish(ctx2));
+
+				uint32_t *fp;
+				int size;
+				ASSERT_EQ(1, chromaprint_get_raw_fingerprint(ctx2, &fp, &size));
+				SCOPE_EXIT(chromaprint_dealloc(fp));
+				EXPECT_EQ(std::vector<uint32_t>(expected, expected + expected_size), std::vector<uint32_t>(fp, fp + size))
+					<< "algorithm " << algorithm << ", sample rate " << sample_rate << ", split " << split;
+				EXPECT_EQ(std::vector<uint32_t>(fp, fp + size), streamed);
+			}
+		}
+	}
+}
+
+TEST(API, TestRestoreStateErrors)
+{
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	void *state;
+	int state_size;
+	EXPECT_EQ(0, chromaprint_save_state(ctx, &state, &state_size));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_save_state(ctx, &state, &state_size));
+	SCOPE_EXIT(chromaprint_dealloc(state));
+
+	ChromaprintContext *other_ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST1);
+	ASSERT_NE(nullptr, other_ctx);
+	SCOPE_EXIT(chromaprint_free(other_ctx));
+	EXPECT_EQ(0, chromaprint_restore_state(other_ctx, state, state_size));
+
+	std::vector<char> corrupted((char *) state, (char *) state + state_size);
+	corrupted[0] ^= 1;
+	EXPECT_EQ(0, chromaprint_restore_state(ctx, corrupted.data(), corrupted.size()));
+
+	EXPECT_EQ(1, chromaprint_restore_state(ctx, state, state_size));
+}
+
+TEST(API, TestFailedRestoreStateClearsFingerprint)
+{
+	std::vector<short> chunk = LoadAudioFile("data/test_mono_44100.raw");
+	std::vector<short> data;
+	for (int i = 0; i < 3; i++) {
+		data.insert(data.end(), chunk.begin(), chunk.end());
+	}
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	void *state;
+	int state_size;
+	ASSERT_EQ(1, chromaprint_save_state(ctx, &state, &state_size));
+	SCOPE_EXIT(chromaprint_dealloc(state));
+
+	// fails while reading the cursor and while restoring the fingerprinter
+	for (int truncate : { 1, state_size / 2 }) {
+		ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+		ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+		ASSERT_EQ(1, chromaprint_finish(ctx));
+
+		// move the cursor to the end of the fingerprint
+		const uint32_t *items;
+		int num_items;
+		ASSERT_EQ(1, chromaprint_get_new_raw_fingerprint(ctx, &items, &num_items));
+		ASSERT_GT(num_items, 0);
+
+		EXPECT_EQ(0, chromaprint_restore_state(ctx, state, state_size - truncate));
+
+		int size;
+		ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &size));
+		EXPECT_EQ(0, size);
+		ASSERT_EQ(1, chromaprint_get_new_raw_fingerprint(ctx, &items, &num_items));
+		EXPECT_EQ(0, num_items);
+	}
+}
+
+TEST(API, TestStats)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+
+	ChromaprintContext *ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_TEST2);
+	ASSERT_NE(nullptr, ctx);
+	SCOPE_EXIT(chromaprint_free(ctx));
+
+	ASSERT_EQ(1, chromaprint_start(ctx, 44100, 1));
+	ASSERT_EQ(1, chromaprint_feed(ctx, data.data(), data.size()));
+	ASSERT_EQ(1, chromaprint_finish(ctx));
+
+	char *fp;
+	ASSERT_EQ(1, chromaprint_get_fingerprint(ctx, &fp));
+	SCOPE_EXIT(chromaprint_dealloc(fp));
+
+	int size;
+	ASSERT_EQ(1, chromaprint_get_raw_fingerprint_size(ctx, &size));
+
+	EXPECT_STREQ("audio_processor", chromaprint_get_stage_name(CHROMAPRINT_STAGE_AUDIO_PROCESSOR));
+	EXPECT_STREQ("compressor", chromaprint_get_stage_name(CHROMAPRINT_STAGE_COMPRESSOR));
+	EXPECT_EQ(nullptr, chromaprint_get_stage_name(CHROMAPRINT_NUM_STAGES));
+
+	uint64_t time_ns, count;
+	EXPECT_EQ(0, chromaprint_get_stats(ctx, CHROMAPRINT_NUM_STAGES, &time_ns, &count));
+
+#ifdef USE_STATS
+	uint64_t counts[CHROMAPRINT_NUM_STAGES];
+	for (int i = 0; i < CHROMAPRINT_NUM_STAGES; i++) {
+		ASSERT_EQ(1, chromaprint_get_stats(ctx, i, &time_ns, &counts[i])) << chromaprint_get_stage_name(i);
+		EXPECT_GT(time_ns, 0u) << chromaprint_get_stage_name(i);
+	}
+	EXPECT_EQ(data.size(), counts[CHROMAPRINT_STAGE_AUDIO_PROCESSOR]);
+	EXPECT_GT(counts[CHROMAPRINT_STAGE_FFT], 0u);
+	EXPECT_GT(counts[CHROMAPRINT_STAGE_CHROMA], 0u);
+	EXPECT_EQ(counts[CHROMAPRINT_STAGE_CHROMA], counts[CHROMAPRINT_STAGE_CHROMA_FILTER]);
+	EXPECT_EQ(counts[CHROMAPRINT_STAGE_CHROMA_FILTER], counts[CHROMAPRINT_STAGE_CHROMA_NORMALIZER] + 4);
+	EXPECT_EQ(counts[CHROMAPRINT_STAGE_CHROMA_NORMALIZER], counts[CHROMAPRINT_STAGE_FINGERPRINT_CALCULATOR]);
+	EXPECT_EQ(uint64_t(size), counts[CHROMAPRINT_STAGE_COMPRESSOR]);
+
+	ASSERT_EQ(1, chromaprint_reset_stats(ctx));
+	for (int i = 0; i < CHROMAPRINT_NUM_STAGES; i++) {
+		ASSERT_EQ(1, chromaprint_get_stats(ctx, i, &time_ns, &count));
+		EXPECT_EQ(0u, time_ns);
+		EXPECT_EQ(0u, count);
+	}
+#else
+	EXPECT_EQ(0, chromaprint_get_stats(ctx, CHROMAPRINT_STAGE_FFT, &time_ns, &count));
+#endif
+}
+
 }; // namespace chromaprint
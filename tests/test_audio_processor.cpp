@@ -43,6 +43,69 @@ TEST(AudioProcessor, PassThrough)
 	}
 }
 
+class PointerRecorder : public AudioConsumer
+{
+public:
+	void Consume(const int16_t *input, int length) override
+	{
+		pointers.push_back(input);
+	}
+
+	std::vector<const int16_t *> pointers;
+};
+
+TEST(AudioProcessor, PassThroughWithoutCopy)
+{
+	std::vector<short> data = LoadAudioFile("data/test_mono_44100.raw");
+
+	PointerRecorder recorder;
+	AudioProcessor processor(44100, &recorder);
+	processor.Reset(44100, 1);
+	processor.Consume(data.data(), data.size());
+	processor.Consume(data.data() + 100, data.size() - 100);
+	processor.Flush();
+
+	ASSERT_EQ(2, recorder.pointers.size());
+	EXPECT_EQ(data.data(), recorder.pointers[0]);
+	EXPECT_EQ(data.data() + 100, recorder.pointers[1]);
+}
+
+// Mono input is resampled without buffering it, the result must not change.
+TEST(AudioProcessor, ResampleMonoInChunks)
+{
+	const std::vector<short> data = LoadAudioFile("data/test_mono_44100.raw");
+	std::vector<short> mono;
+	for (int i = 0; i < 4; i++) {
+		mono.insert(mono.end(), data.begin(), data.end());
+	}
+	std::vector<short> stereo(mono.size() * 2);
+	for (size_t i = 0; i < mono.size(); i++) {
+		stereo[2 * i] = stereo[2 * i + 1] = mono[i];
+	}
+
+	for (int sample_rate : { 8000, 44100, 48000 }) {
+		// stereo input is always buffered and the downmix of the same samples is exact
+		AudioBuffer expected;
+		AudioProcessor processor1(11025, &expected);
+		processor1.Reset(sample_rate, 2);
+		processor1.Consume(stereo.data(), stereo.size());
+		processor1.Flush();
+
+		for (size_t chunk_size : { 1, 10, 1000, 5000, 100000 }) {
+			AudioBuffer buffer;
+			AudioProcessor processor2(11025, &buffer);
+			processor2.Reset(sample_rate, 1);
+			for (size_t i = 0; i < mono.size(); i += chunk_size) {
+				processor2.Consume(mono.data() + i, std::min(chunk_size, mono.size() - i));
+			}
+			processor2.Flush();
+
+			ASSERT_FALSE(expected.data().empty());
+			ASSERT_EQ(expected.data(), buffer.data()) << sample_rate << " " << chunk_size;
+		}
+	}
+}
+
 TEST(AudioProcessor, StereoToMono)
 {
 	std::vector<short> data1 = LoadAudioFile("data/test_stereo_44100.raw");
@@ -110,3 +173,171 @@ TEST(AudioProcessor, StereoToMonoAndResample)
 		ASSERT_EQ(data2[i], buffer.data()[i]) << "Signals differ at index " << i;
 	}
 }
+
+TEST(AudioProcessor, PlanarToMono)
+{
+	const size_t length = 50000;
+	for (int num_channels = 1; num_channels <= 8; num_channels++) {
+		std::vector<int16_t> interleaved(length * num_channels);
+		std::vector<std::vector<int16_t>> planar(num_channels, std::vector<int16_t>(length));
+		for (size_t i = 0; i < interleaved.size(); i++) {
+			const int16_t value = int16_t(int((i * 7919) % 65536) - 32768);
+			interleaved[i] = value;
+			planar[i % num_channels][i / num_channels] = value;
+		}
+
+		AudioBuffer buffer1, buffer2;
+		AudioProcessor processor1(11025, &buffer1);
+		AudioProcessor processor2(11025, &buffer2);
+		processor1.Reset(48000, num_channels);
+		processor2.Reset(48000, num_channels);
+		processor1.Consume(interleaved.data(), interleaved.size());
+		std::vector<const int16_t *> chunk(num_channels);
+		for (size_t offset = 0; offset < length; offset += 999) {
+			for (int ch = 0; ch < num_channels; ch++) {
+				chunk[ch] = planar[ch].data() + offset;
+			}
+			processor2.ConsumePlanar(chunk.data(), std::min(length - offset, size_t(999)));
+		}
+		processor1.Flush();
+		processor2.Flush();
+
+		ASSERT_FALSE(buffer1.data().empty());
+		ASSERT_EQ(buffer1.data(), buffer2.data()) << "Signals differ for " << num_channels << " channels";
+	}
+}
+
+TEST(AudioProcessor, SurroundToMono)
+{
+	// the LFE channel is ignored, the center and surround channels are
+	// mixed at -3 dB and the weights add up to one
+	const int16_t data51[] = {
+		1000, 1000, 1000, 30000, 1000, 1000,
+		-2000, -2000, -2000, -30000, -2000, -2000,
+		4000, 0, 0, 0, 0, 0,
+		0, 0, 4000, 0, 0, 0,
+	};
+	const int16_t data71[] = {
+		1000, 1000, 1000, 30000, 1000, 1000, 1000, 1000,
+		-2000, -2000, -2000, -30000, -2000, -2000, -2000, -2000,
+		4000, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 4000, 0, 0, 0, 0, 0,
+	};
+	const int16_t expected51[] = { 1000, -2000, 971, 686 };
+	const int16_t expected71[] = { 1000, -2000, 723, 511 };
+
+	AudioBuffer buffer1, buffer2;
+	AudioProcessor processor1(44100, &buffer1);
+	AudioProcessor processor2(44100, &buffer2);
+	processor1.Reset(44100, 6);
+	processor2.Reset(44100, 8);
+	processor1.Consume(data51, 24);
+	processor2.Consume(data71, 32);
+	processor1.Flush();
+	processor2.Flush();
+
+	ASSERT_EQ(std::vector<int16_t>(expected51, expected51 + 4), buffer1.data());
+	ASSERT_EQ(std::vector<int16_t>(expected71, expected71 + 4), buffer2.data());
+}
+
+TEST(AudioProcessor, FloatMono)
+{
+	std::vector<short> data = LoadAudioFile("data/test_mono_44100.raw");
+	std::vector<float> float_data(data.size());
+	for (size_t i = 0; i < data.size(); i++) {
+		float_data[i] = data[i] / 32768.0f;
+	}
+
+	AudioBuffer buffer;
+	AudioProcessor processor(44100, &buffer);
+	processor.Reset(44100, 1);
+	processor.ConsumeFloat(float_data.data(), float_data.size());
+	processor.Flush();
+
+	ASSERT_EQ(data.size(), buffer.data().size());
+	for (size_t i = 0; i < data.size(); i++) {
+		ASSERT_EQ(data[i], buffer.data()[i]) << "Signals differ at index " << i;
+	}
+}
+
+TEST(AudioProcessor, FloatStereoToMono)
+{
+	std::vector<short> data = LoadAudioFile("data/test_stereo_44100.raw");
+	const size_t length = data.size() / 2;
+	std::vector<float> float_data(data.size());
+	std::vector<float> planar_data[2] = { std::vector<float>(length), std::vector<float>(length) };
+	for (size_t i = 0; i < data.size(); i++) {
+		float_data[i] = data[i] / 32768.0f;
+		planar_data[i % 2][i / 2] = data[i] / 32768.0f;
+	}
+	const float *planes[2] = { planar_data[0].data(), planar_data[1].data() };
+
+	AudioBuffer buffer1, buffer2, buffer3;
+	AudioProcessor processor1(44100, &buffer1);
+	AudioProcessor processor2(44100, &buffer2);
+	AudioProcessor processor3(44100, &buffer3);
+	processor1.Reset(44100, 2);
+	processor2.Reset(44100, 2);
+	processor3.Reset(44100, 2);
+	processor1.Consume(data.data(), data.size());
+	processor2.ConsumeFloat(float_data.data(), float_data.size());
+	for (size_t offset = 0; offset < length; offset += 1000) {
+		const float *chunk[2] = { planes[0] + offset, planes[1] + offset };
+		processor3.ConsumePlanarFloat(chunk, std::min(length - offset, size_t(1000)));
+	}
+	processor1.Flush();
+	processor2.Flush();
+	processor3.Flush();
+
+	// the float input is rounded after downmixing, so it can differ by one
+	ASSERT_EQ(buffer1.data().size(), buffer2.data().size());
+	for (size_t i = 0; i < buffer1.data().size(); i++) {
+		ASSERT_NEAR(buffer1.data()[i], buffer2.data()[i], 1) << "Signals differ at index " << i;
+	}
+	ASSERT_EQ(buffer2.data(), buffer3.data());
+}
+
+TEST(AudioProcessor, FloatClipping)
+{
+	const float data[] = { 0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.5f, -0.5f, 1e-6f };
+	const size_t length = sizeof(data) / sizeof(data[0]);
+
+	AudioBuffer buffer;
+	AudioProcessor processor(44100, &buffer);
+	processor.Reset(44100, 1);
+	processor.ConsumeFloat(data, length);
+	processor.Flush();
+
+	const int16_t expected[] = { 0, 32767, -32768, 32767, -32768, 16384, -16384, 0 };
+	ASSERT_EQ(std::vector<int16_t>(expected, expected + length), buffer.data());
+}
+
+TEST(AudioProcessor, FloatPlanarMultiChannel)
+{
+	const int num_channels = 6;
+	const size_t length = 50000;
+	std::vector<float> interleaved(length * num_channels);
+	std::vector<std::vector<float>> planar(num_channels, std::vector<float>(length));
+	for (size_t i = 0; i < interleaved.size(); i++) {
+		const float value = ((i * 7919) % 2001) / 1000.0f - 1.0f;
+		interleaved[i] = value;
+		planar[i % num_channels][i / num_channels] = value;
+	}
+	std::vector<const float *> planes;
+	for (const auto &plane : planar) {
+		planes.push_back(plane.data());
+	}
+
+	AudioBuffer buffer1, buffer2;
+	AudioProcessor processor1(11025, &buffer1);
+	AudioProcessor processor2(11025, &buffer2);
+	processor1.Reset(48000, num_channels);
+	processor2.Reset(48000, num_channels);
+	processor1.ConsumeFloat(interleaved.data(), interleaved.size());
+	processor2.ConsumePlanarFloat(planes.data(), length);
+	processor1.Flush();
+	processor2.Flush();
+
+	ASSERT_FALSE(buffer1.data().empty());
+	ASSERT_EQ(buffer1.data(), buffer2.data());
+}
@@ -9,12 +9,12 @@ using namespace chromaprint;
 class FeatureVectorBuffer : public FeatureVectorConsumer
 {
 public:
-	void Consume(std::vector<double> &features)
+	void Consume(FeatureVector &features)
 	{
 		m_features = features;
 	}
 
-	std::vector<double> m_features;
+	FeatureVector m_features;
 };
 
 TEST(Chroma, NormalA) {
@@ -13,9 +13,9 @@ TEST(ChromaFilter, Blur2) {
 	double d1[] = { 0.0, 5.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 	double d2[] = { 1.0, 6.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 	double d3[] = { 2.0, 7.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-	std::vector<double> v1(d1, d1 + 12);
-	std::vector<double> v2(d2, d2 + 12);
-	std::vector<double> v3(d3, d3 + 12);
+	FeatureVector v1(d1, d1 + 12);
+	FeatureVector v2(d2, d2 + 12);
+	FeatureVector v3(d3, d3 + 12);
 	filter.Consume(v1);
 	filter.Consume(v2);
 	filter.Consume(v3);
@@ -35,10 +35,10 @@ TEST(ChromaFilter, Blur3) {
 	double d2[] = { 1.0, 6.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 	double d3[] = { 2.0, 7.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 	double d4[] = { 3.0, 8.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-	std::vector<double> v1(d1, d1 + 12);
-	std::vector<double> v2(d2, d2 + 12);
-	std::vector<double> v3(d3, d3 + 12);
-	std::vector<double> v4(d4, d4 + 12);
+	FeatureVector v1(d1, d1 + 12);
+	FeatureVector v2(d2, d2 + 12);
+	FeatureVector v3(d3, d3 + 12);
+	FeatureVector v4(d4, d4 + 12);
 	filter.Consume(v1);
 	filter.Consume(v2);
 	filter.Consume(v3);
@@ -58,9 +58,9 @@ TEST(ChromaFilter, Diff) {
 	double d1[] = { 0.0, 5.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 	double d2[] = { 1.0, 6.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 	double d3[] = { 2.0, 7.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-	std::vector<double> v1(d1, d1 + 12);
-	std::vector<double> v2(d2, d2 + 12);
-	std::vector<double> v3(d3, d3 + 12);
+	FeatureVector v1(d1, d1 + 12);
+	FeatureVector v2(d2, d2 + 12);
+	FeatureVector v3(d3, d3 + 12);
 	filter.Consume(v1);
 	filter.Consume(v2);
 	filter.Consume(v3);
@@ -12,7 +12,11 @@
 #include "audio_processor.h"
 #include "image.h"
 #include "image_builder.h"
+#include "fingerprinter.h"
+#include "fingerprinter_configuration.h"
+#include "fingerprint_decompressor.h"
 #include "utils.h"
+#include "utils/base64.h"
 
 using namespace chromaprint;
 
@@ -63,3 +67,62 @@ TEST(Chromaprint, BasicImage)
 		}
 	}
 }
+
+// Fingerprints calculated by the double precision pipeline, each file is fed five times.
+static const struct {
+	const char *file_name;
+	int sample_rate;
+	const char *fingerprint;
+} kReferenceFingerprints[] = {
+	{ "data/test_mono_8000.raw", 8000,
+	  "AQAAM0mUK1KYJLgU-FA-PB_8KJMCH09wqcb25NCL42k5vNGDPNGRP7hPXIMP5RGefHCcKJMC_8QTXCr85IFy_Hj64VYe5FmO_MHT49rhQ3mEJ8evVAl-Gg--FO7yQPlxPD1-5cGzHNdxnMrhE8GEEUyQQ4BwABAhDELIMGQAA84QICwggBAgiFHIMIYMYEA4YIgwQgICBCCIMIUYAA" },
+	{ "data/test_mono_11025.raw", 11025,
+	  "AQAAO0mUK1KoBNfwQR_WfHiUSYGPJ8elGtuTQ8ePp-XgNXqQJzryB65PXMOhPMKTD3eiTAp8PMeVFH7yQDl-PP3gWXmQZznyB256XMOhRxiTD7_SwT_xE49SuMuh_MLx9HCuPHiW4_pg41SOE7owJjx-WYHPUfhxGZ6UQ7kOwRxijhxIgMCAACEMQoZRAxgARhMgLCCAAEGMcowiBoQASBJihAREAIIIQ4wpAoRA2hgjAA" },
+	{ "data/test_mono_44100.raw", 44100,
+	  "AQAAO0mUK1KoBNfwQR_WfHiUSYGPJ8elGn5yKC-Op-XgNXqQJzryB65PXMOhPMKTD3eiTAp8PMeVFH7yDMrxH08_-MqDfDnyB256XMOhRxiTD7_SwT_xE49SuMuh_MLx9HCuPHiWI9cHGzmV48QFhQmPX1bgcxR-XIYn5VCuA8EcYo4cSIBgAAhhEDKMGsAAMJoAYQFBgBBAiFGOUcSAEABJQoyQgAhAkGCGMUeAEEgbYwQ" },
+	{ "data/test_stereo_44100.raw", 44100,
+	  "AQAAjEkkZUqYREkUnFAXHk8uuMZl6EfO4zu-4HC148HuoLyJXDmh8XGMn0Sq7Ph-eLoYPEepoXXhbfiF0D90oidC4_LRM8dWhUf-QmsoomrywD0uET_0E_mPSzl-uIc_hdhQOyfyEVp3FY66UHiGeCeub4H_oJRC9IMXHT9yPUcP7ciJmrj2YEoVJUf-QmtFVNxh58JNXIf-EPmPa3jw41OxHbVz5DvKbFchPotxH3miEv8WePJRsketCF50_Mj1oD-040RI4d1RN0c0NRdeESp3PBdc4zL0H_l5XDse_PCn4tgdlDcRVjkL_UmD_0iVHd8_ePIZ_Lg23CG87biO8IdO9ERoXD565ohWhcefCZoWHn1ywcUlQj9-Iv9xKccPShRhEliCDBHBCkUEAIAAYBgFjCiiBDCAAGCMYhYIQpwgRCEGiDACEIaEIJAYQghTgAFgjEHMCEGcIAoxxpiAAAACACWAQGIIsYwBQ4gxyjAhACGEGIUYwEIJAAAQBABALCCGIGKJEsAAAgQhgDAJDCFOEKIQ" },
+};
+
+// Compares the fingerprints from the current build with the double precision
+// ones, to check how much a build with USE_FLOAT_FEATURES deviates from them.
+TEST(Chromaprint, FeaturePrecision)
+{
+	size_t num_bits = 0;
+	size_t num_errors = 0;
+
+	for (const auto &reference : kReferenceFingerprints) {
+		std::vector<short> data = LoadAudioFile(reference.file_name);
+
+		Fingerprinter fingerprinter(new FingerprinterConfigurationTest2());
+		ASSERT_TRUE(fingerprinter.Start(reference.sample_rate, 1));
+		for (int i = 0; i < 5; i++) {
+			fingerprinter.Consume(data.data(), data.size());
+		}
+		fingerprinter.Finish();
+		const auto &fingerprint = fingerprinter.GetFingerprint();
+
+		std::vector<uint32_t> expected;
+		int algorithm;
+		ASSERT_TRUE(DecompressFingerprint(Base64Decode(reference.fingerprint), expected, algorithm));
+		ASSERT_EQ(expected.size(), fingerprint.size()) << reference.file_name;
+
+		size_t file_errors = 0;
+		for (size_t i = 0; i < expected.size(); i++) {
+			file_errors += HammingDistance(expected[i], fingerprint[i]);
+		}
+		const double file_error_rate = double(file_errors) / (expected.size() * 32);
+		EXPECT_LE(file_error_rate, 0.01) << reference.file_name;
+
+		num_bits += expected.size() * 32;
+		num_errors += file_errors;
+	}
+
+	const double error_rate = double(num_errors) / num_bits;
+	RecordProperty("bit_errors", int(num_errors));
+	RecordProperty("bits", int(num_bits));
+#ifndef USE_FLOAT_FEATURES
+	EXPECT_EQ(0, num_errors);
+#endif
+	EXPECT_LE(error_rate, 0.005);
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include "fingerprint_index.h"
+#include "fingerprint_searcher.h"
+
+namespace chromaprint
+{
+
+TEST(FingerprintIndex, Lookup)
+{
+	const uint32_t fp1[] = { 1u << 28, 2u << 28, 1u << 28 };
+	const uint32_t fp2[] = { 3u << 28, 1u << 28 | 5 };
+
+	FingerprintIndex index(4);
+	index.AddFingerprint(100, fp1, 3);
+	index.AddFingerprint(200, fp2, 2);
+	index.Build();
+
+	ASSERT_EQ(2, index.num_docs());
+	ASSERT_EQ(3, index.num_hashes());
+	ASSERT_EQ(5, index.num_postings());
+	ASSERT_EQ(100, index.GetDocId(0));
+	ASSERT_EQ(200, index.GetDocId(1));
+
+	const FingerprintIndexPosting *postings;
+	ASSERT_EQ(3, index.Lookup(1, &postings));
+	EXPECT_EQ(0, postings[0].doc);
+	EXPECT_EQ(0, postings[0].position);
+	EXPECT_EQ(0, postings[1].doc);
+	EXPECT_EQ(2, postings[1].position);
+	EXPECT_EQ(1, postings[2].doc);
+	EXPECT_EQ(1, postings[2].position);
+
+	ASSERT_EQ(1, index.Lookup(3, &postings));
+	EXPECT_EQ(1, postings[0].doc);
+	EXPECT_EQ(0, postings[0].position);
+
+	ASSERT_EQ(0, index.Lookup(4, &postings));
+
+	size_t size;
+	const uint32_t *data = index.GetFingerprint(1, &size);
+	ASSERT_EQ(2, size);
+	EXPECT_EQ(fp2[0], data[0]);
+	EXPECT_EQ(fp2[1], data[1]);
+}
+
+TEST(FingerprintIndex, Clear)
+{
+	const uint32_t fp[] = { 1u << 28, 2u << 28 };
+
+	FingerprintIndex index(4);
+	index.AddFingerprint(1, fp, 2);
+	index.Build();
+	index.Clear();
+
+	const FingerprintIndexPosting *postings;
+	ASSERT_EQ(0, index.num_docs());
+	ASSERT_EQ(0, index.Lookup(1, &postings));
+}
+
+TEST(FingerprintIndex, SaveAndOpen)
+{
+	const uint32_t fp1[] = { 1u << 28, 2u << 28, 1u << 28 };
+	const uint32_t fp2[] = { 3u << 28, 1u << 28 | 5 };
+	const char *file_name = "test_fingerprint_index.idx";
+
+	{
+		FingerprintIndex index(4);
+		index.AddFingerprint(100, fp1, 3);
+		index.AddFingerprint(200, fp2, 2);
+		index.Build();
+		ASSERT_TRUE(index.Save(file_name));
+	}
+
+	FingerprintIndex index;
+	ASSERT_TRUE(index.Open(file_name));
+	remove(file_name);
+
+	ASSERT_TRUE(index.is_mapped());
+	ASSERT_EQ(4, index.hash_bits());
+	ASSERT_EQ(2, index.num_docs());
+	ASSERT_EQ(3, index.num_hashes());
+	ASSERT_EQ(5, index.num_postings());
+	ASSERT_EQ(200, index.GetDocId(1));
+
+	const FingerprintIndexPosting *postings;
+	ASSERT_EQ(3, index.Lookup(1, &postings));
+	EXPECT_EQ(1, postings[2].doc);
+	EXPECT_EQ(1, postings[2].position);
+
+	size_t size;
+	const uint32_t *data = index.GetFingerprint(1, &size);
+	ASSERT_EQ(2, size);
+	EXPECT_EQ(fp2[1], data[1]);
+
+	// adding to a mapped index copies it into memory
+	index.AddFingerprint(300, fp2, 2);
+	index.Build();
+	ASSERT_FALSE(index.is_mapped());
+	ASSERT_EQ(3, index.num_docs());
+	ASSERT_EQ(4, index.Lookup(1, &postings));
+	EXPECT_EQ(2, postings[3].doc);
+}
+
+TEST(FingerprintIndex, OpenInvalid)
+{
+	const char *file_name = "test_fingerprint_index_invalid.idx";
+	{
+		std::ofstream file(file_name, std::ofstream::out | std::ofstream::binary);
+		file << "CPINDEX this is not an index file, but it's long enough to have a header";
+	}
+
+	FingerprintIndex index;
+	ASSERT_FALSE(index.Open(file_name));
+	ASSERT_FALSE(index.Open("does_not_exist.idx"));
+	remove(file_name);
+	ASSERT_FALSE(index.is_mapped());
+}
+
+TEST(FingerprintIndex, OpenCorrupted)
+{
+	const uint32_t fp1[] = { 1u << 28, 2u << 28, 1u << 28 };
+	const uint32_t fp2[] = { 3u << 28, 1u << 28 | 5 };
+	const char *file_name = "test_fingerprint_index_corrupted.idx";
+
+	// section offsets for two documents with five items and three hashes
+	const std::streamoff kFingerprintOffsets = 128;
+	const std::streamoff kHashOffsets = 320;
+	const std::streamoff kPostings = 384;
+
+	auto corrupt = [&](std::streamoff offset, const void *data, size_t size) {
+		{
+			FingerprintIndex index(4);
+			index.AddFingerprint(100, fp1, 3);
+			index.AddFingerprint(200, fp2, 2);
+			index.Build();
+			EXPECT_TRUE(index.Save(file_name));
+		}
+		std::fstream file(file_name, std::fstream::in | std::fstream::out | std::fstream::binary);
+		file.seekp(offset);
+		file.write(static_cast<const char *>(data), size);
+	};
+
+	// corrupted offsets and postings are not checked by Open(), but they
+	// are detected by Verify() and never used to read outside of the file
+	FingerprintIndex index;
+	const FingerprintIndexPosting *postings;
+	size_t size;
+
+	corrupt(0, "CPINDEX", 0);
+	ASSERT_TRUE(index.Open(file_name));
+	EXPECT_TRUE(index.Verify());
+
+	const uint64_t bad_offset = 1000;
+	corrupt(kFingerprintOffsets + sizeof(uint64_t), &bad_offset, sizeof(bad_offset));
+	ASSERT_TRUE(index.Open(file_name));
+	EXPECT_FALSE(index.Verify());
+	index.GetFingerprint(0, &size);
+	EXPECT_EQ(0, size);
+	index.GetFingerprint(1, &size);
+	EXPECT_EQ(0, size);
+
+	corrupt(kHashOffsets + sizeof(uint64_t), &bad_offset, sizeof(bad_offset));
+	ASSERT_TRUE(index.Open(file_name));
+	EXPECT_FALSE(index.Verify());
+	EXPECT_EQ(0, index.Lookup(1, &postings));
+	EXPECT_EQ(0, index.Lookup(2, &postings));
+
+	const FingerprintIndexPosting bad_doc = { 2, 0 };
+	corrupt(kPostings, &bad_doc, sizeof(bad_doc));
+	ASSERT_TRUE(index.Open(file_name));
+	EXPECT_FALSE(index.Verify());
+	FingerprintSearcher searcher(&index);
+	std::vector<FingerprintSearchResult> results;
+	ASSERT_EQ(2, searcher.Search(fp1, 3, 10, results));
+	EXPECT_EQ(100, results[0].id);
+	EXPECT_EQ(2, results[0].score);
+	EXPECT_EQ(200, results[1].id);
+
+	const FingerprintIndexPosting bad_position = { 1, 2 };
+	corrupt(kPostings, &bad_position, sizeof(bad_position));
+	ASSERT_TRUE(index.Open(file_name));
+	EXPECT_FALSE(index.Verify());
+
+	// copying a corrupted index into memory keeps it usable
+	corrupt(kFingerprintOffsets + sizeof(uint64_t), &bad_offset, sizeof(bad_offset));
+	ASSERT_TRUE(index.Open(file_name));
+	index.AddFingerprint(300, fp2, 2);
+	index.Build();
+	EXPECT_TRUE(index.Verify());
+	EXPECT_EQ(3, index.num_docs());
+	index.Clear();
+
+	remove(file_name);
+	ASSERT_FALSE(index.is_mapped());
+}
+
+};
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <vector>
 #include <fstream>
+#include <cstdlib>
 #include "fingerprinter_configuration.h"
 #include "fingerprint_matcher.h"
 #include "utils.h"
@@ -21,7 +22,22 @@ TEST(FingerprintMatcher, Match)
 	std::vector<uint32_t> fp2(fp2_data, fp2_data + sizeof(fp2_data)/sizeof(fp2_data[0]));
 
 	FingerprintMatcher matcher(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_TEST2));
-	matcher.Match(fp1, fp2);
+	ASSERT_TRUE(matcher.Match(fp1, fp2));
+	ASSERT_FALSE(matcher.segments().empty());
+	const auto segments = matcher.segments();
+
+	// results must not depend on rand() or on previous calls
+	srand(12345);
+	FingerprintMatcher matcher2(CreateFingerprinterConfiguration(CHROMAPRINT_ALGORITHM_TEST2));
+	ASSERT_TRUE(matcher2.Match(fp1, fp2));
+	ASSERT_TRUE(matcher2.Match(fp1, fp2));
+	ASSERT_EQ(segments.size(), matcher2.segments().size());
+	for (size_t i = 0; i < segments.size(); i++) {
+		EXPECT_EQ(segments[i].pos1, matcher2.segments()[i].pos1);
+		EXPECT_EQ(segments[i].pos2, matcher2.segments()[i].pos2);
+		EXPECT_EQ(segments[i].duration, matcher2.segments()[i].duration);
+		EXPECT_EQ(segments[i].score, matcher2.segments()[i].score);
+	}
 }
 
 };
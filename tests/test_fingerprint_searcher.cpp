@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "fingerprint_index.h"
+#include "fingerprint_searcher.h"
+
+namespace chromaprint
+{
+
+static std::vector<uint32_t> GenerateFingerprint(uint32_t seed, size_t size)
+{
+	std::vector<uint32_t> fp(size);
+	uint32_t x = seed * 2654435761u + 1;
+	for (size_t i = 0; i < size; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		fp[i] = x;
+	}
+	return fp;
+}
+
+TEST(FingerprintSearcher, Search)
+{
+	FingerprintIndex index;
+	for (uint32_t i = 0; i < 100; i++) {
+		index.AddFingerprint(1000 + i, GenerateFingerprint(i, 200));
+	}
+	index.Build();
+
+	const auto fp = GenerateFingerprint(42, 200);
+	const std::vector<uint32_t> query(fp.begin() + 30, fp.begin() + 150);
+
+	FingerprintSearcher searcher(&index);
+	std::vector<FingerprintSearchResult> results;
+	ASSERT_EQ(1, searcher.Search(query, 10, results));
+	ASSERT_EQ(1, results.size());
+	EXPECT_EQ(42, results[0].doc);
+	EXPECT_EQ(1042, results[0].id);
+	EXPECT_EQ(120, results[0].score);
+	EXPECT_EQ(30, results[0].offset);
+	ASSERT_EQ(1, results[0].offsets.size());
+	EXPECT_EQ(30, results[0].offsets[0].first);
+	EXPECT_EQ(120, results[0].offsets[0].second);
+}
+
+TEST(FingerprintSearcher, SearchTopK)
+{
+	auto fp1 = GenerateFingerprint(1, 100);
+	auto fp2 = GenerateFingerprint(2, 100);
+	auto fp3 = GenerateFingerprint(3, 100);
+	std::copy(fp1.begin(), fp1.begin() + 50, fp2.begin() + 10);
+	std::copy(fp1.begin(), fp1.begin() + 20, fp3.begin());
+
+	FingerprintIndex index;
+	index.AddFingerprint(1, fp1);
+	index.AddFingerprint(2, fp2);
+	index.AddFingerprint(3, fp3);
+	index.Build();
+
+	FingerprintSearcher searcher(&index);
+	std::vector<FingerprintSearchResult> results;
+	ASSERT_EQ(3, searcher.Search(fp1, 3, results));
+	EXPECT_EQ(1, results[0].id);
+	EXPECT_EQ(100, results[0].score);
+	EXPECT_EQ(0, results[0].offset);
+	EXPECT_EQ(2, results[1].id);
+	EXPECT_EQ(50, results[1].score);
+	EXPECT_EQ(10, results[1].offset);
+	EXPECT_EQ(3, results[2].id);
+	EXPECT_EQ(20, results[2].score);
+	EXPECT_EQ(0, results[2].offset);
+
+	ASSERT_EQ(2, searcher.Search(fp1, 2, results));
+	ASSERT_EQ(2, results.size());
+
+	searcher.set_min_score(30);
+	ASSERT_EQ(2, searcher.Search(fp1, 10, results));
+
+	searcher.set_min_score(1);
+	searcher.set_max_posting_list_size(1);
+	ASSERT_EQ(1, searcher.Search(fp1, 10, results));
+	EXPECT_EQ(1, results[0].id);
+	EXPECT_EQ(50, results[0].score);
+}
+
+};